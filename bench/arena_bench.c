@@ -0,0 +1,143 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Arena benchmark.
+ *
+ * Loads COPIES copies of each layout, then frees them, once with widgets
+ * allocated by malloc() and once with each copy allocated from an arena.
+ * Reports average load and free times in microseconds, resident memory
+ * growth with all copies loaded and resident memory that was not returned
+ * after all copies were freed, which is a rough measure of heap
+ * fragmentation.
+ *
+ * Each run is done in a separate process so that the heap state of one run
+ * does not affect the other.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include "bench.h"
+
+#define COPIES 100
+
+static long rss_kb(void)
+{
+	long pages, rss = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+
+	if (!f)
+		return 0;
+
+	if (fscanf(f, "%ld %ld", &pages, &rss) != 2)
+		rss = 0;
+
+	fclose(f);
+
+	return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void bench_run(const char *path, int use_arena)
+{
+	static gp_widget *layouts[COPIES];
+	static gp_widget_arena arenas[COPIES];
+	uint64_t t0, t1, t2;
+	long rss0, rss1, rss2;
+	unsigned int i;
+
+	rss0 = rss_kb();
+
+	t0 = now_ns();
+
+	for (i = 0; i < COPIES; i++) {
+		if (use_arena)
+			layouts[i] = gp_widget_layout_json_arena(path, NULL, &arenas[i]);
+		else
+			layouts[i] = gp_widget_layout_json(path, NULL);
+	}
+
+	t1 = now_ns();
+
+	rss1 = rss_kb();
+
+	for (i = 0; i < COPIES; i++) {
+		if (use_arena)
+			gp_widget_arena_free(&arenas[i], layouts[i]);
+		else
+			gp_widget_free(layouts[i]);
+	}
+
+	t2 = now_ns();
+
+	rss2 = rss_kb();
+
+	printf("%-40s %-6s %11.1f %11.1f %9ld %9ld\n",
+	       path, use_arena ? "arena" : "malloc",
+	       (double)(t1 - t0) / COPIES / 1000,
+	       (double)(t2 - t1) / COPIES / 1000,
+	       rss1 - rss0, rss2 - rss0);
+}
+
+static void bench_fork(const char *path, int use_arena)
+{
+	pid_t pid;
+
+	fflush(stdout);
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork()");
+		return;
+	}
+
+	if (!pid) {
+		bench_run(path, use_arena);
+		exit(0);
+	}
+
+	waitpid(pid, NULL, 0);
+}
+
+static void bench_layout(const char *path)
+{
+	gp_widget *layout = gp_widget_layout_json(path, NULL);
+
+	if (!layout) {
+		printf("%-40s failed to load\n", path);
+		return;
+	}
+
+	gp_widget_free(layout);
+
+	bench_fork(path, 0);
+	bench_fork(path, 1);
+}
+
+int on_event(gp_widget_event *ev)
+{
+	(void)ev;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int i;
+
+	gp_widgets_getopt(&argc, &argv);
+
+	printf("%-40s %-6s %11s %11s %9s %9s\n", "layout", "alloc",
+	       "load[us]", "free[us]", "rss[kB]", "left[kB]");
+
+	for (i = 0; i < argc; i++)
+		bench_layout(argv[i]);
+
+	return 0;
+}
@@ -0,0 +1,39 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Helpers shared by the benchmarks.
+ *
+ * Each measured case is repeated at least BENCH_MIN_LOOPS times and until
+ * BENCH_MIN_NS has passed.
+ */
+
+#ifndef BENCH_H__
+#define BENCH_H__
+
+#include <time.h>
+#include <stdint.h>
+
+#define BENCH_MIN_NS (200 * 1000000ull)
+#define BENCH_MIN_LOOPS 3
+
+static inline uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline int bench_done(unsigned int loops, uint64_t start)
+{
+	return loops >= BENCH_MIN_LOOPS && now_ns() - start >= BENCH_MIN_NS;
+}
+
+#endif /* BENCH_H__ */
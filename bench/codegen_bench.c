@@ -0,0 +1,107 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Generated layout benchmark.
+ *
+ * Compares time needed to build a layout from the C code generated by
+ * tools/layout_to_c with the time needed to load the same layout with
+ * gp_widget_layout_json(). The generated layouts are listed in gen_layouts.h
+ * which is created by the Makefile.
+ *
+ * Each load is repeated until BENCH_MIN_NS has passed, the times reported
+ * are averages in microseconds and do not include freeing the layout.
+ */
+
+#include <stdio.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include "bench.h"
+
+#define GEN_LAYOUT(name) gp_widget *gen_##name##_layout(void);
+#include "gen_layouts.h"
+#undef GEN_LAYOUT
+
+static struct gen_layout {
+	const char *name;
+	gp_widget *(*layout)(void);
+} layouts[] = {
+#define GEN_LAYOUT(name) {#name, gen_##name##_layout},
+#include "gen_layouts.h"
+#undef GEN_LAYOUT
+};
+
+static double bench_json(const char *path)
+{
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		t0 = now_ns();
+		gp_widget *layout = gp_widget_layout_json(path, NULL);
+		total += now_ns() - t0;
+
+		gp_widget_free(layout);
+	}
+
+	return (double)total / loops / 1000;
+}
+
+static double bench_gen(gp_widget *(*gen_layout)(void))
+{
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		t0 = now_ns();
+		gp_widget *layout = gen_layout();
+		total += now_ns() - t0;
+
+		gp_widget_free(layout);
+	}
+
+	return (double)total / loops / 1000;
+}
+
+int on_event(gp_widget_event *ev)
+{
+	(void)ev;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	char path[1024];
+	double json_us, gen_us;
+	unsigned int i;
+
+	gp_widgets_getopt(&argc, &argv);
+
+	if (argc != 1) {
+		fprintf(stderr, "usage: codegen_bench layouts_dir\n");
+		return 1;
+	}
+
+	printf("%-40s %11s %11s %8s\n", "layout", "json[us]", "gen[us]", "speedup");
+
+	for (i = 0; i < GP_ARRAY_SIZE(layouts); i++) {
+		snprintf(path, sizeof(path), "%s/%s.json", argv[0], layouts[i].name);
+
+		json_us = bench_json(path);
+		gen_us = bench_gen(layouts[i].layout);
+
+		printf("%-40s %11.1f %11.1f %7.1fx\n",
+		       layouts[i].name, json_us, gen_us, json_us / gen_us);
+	}
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Grid benchmark.
+ *
+ * Appends GRID_ROWS rows one by one to a grid with a label in the first column
+ * and compares it with inserting all rows at once, then deletes the rows from
+ * the start in small batches and measures a layout of the filled grid, which
+ * has only the first column out of GRID_COLS non-empty. Each case runs on both
+ * a dense and a sparse grid.
+ *
+ * Each case is repeated until BENCH_MIN_NS has passed, the times reported are
+ * averages in milliseconds.
+ */
+
+#include <stdio.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include <gp_widget_ops.h>
+#include "bench.h"
+
+#define GRID_ROWS 100000
+#define GRID_COLS 4
+#define DEL_STEP 100u
+
+static gp_widget *grid_new(int sparse)
+{
+	if (sparse)
+		return gp_widget_grid_sparse_new(GRID_COLS, 0);
+
+	return gp_widget_grid_new(GRID_COLS, 0);
+}
+
+static void grid_fill(gp_widget *grid)
+{
+	unsigned int i;
+
+	for (i = 0; i < GRID_ROWS; i++)
+		gp_widget_grid_put(grid, 0, i, gp_widget_label_new("Row", 0, 0));
+}
+
+static void grid_append(gp_widget *grid)
+{
+	unsigned int i;
+
+	for (i = 0; i < GRID_ROWS; i++) {
+		gp_widget_grid_add_row(grid);
+		gp_widget_grid_put(grid, 0, i, gp_widget_label_new("Row", 0, 0));
+	}
+}
+
+static void grid_insert(gp_widget *grid)
+{
+	gp_widget_grid_rows_ins(grid, 0, GRID_ROWS);
+	grid_fill(grid);
+}
+
+static void grid_delete(gp_widget *grid)
+{
+	while (grid->grid->rows)
+		gp_widget_grid_rows_del(grid, 0, GP_MIN(DEL_STEP, grid->grid->rows));
+}
+
+static double bench_build(void (*build)(gp_widget *grid), int sparse)
+{
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		gp_widget *grid = grid_new(sparse);
+
+		t0 = now_ns();
+		build(grid);
+		total += now_ns() - t0;
+
+		gp_widget_free(grid);
+	}
+
+	return (double)total / loops / 1000000;
+}
+
+static double bench_delete(int sparse)
+{
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		gp_widget *grid = grid_new(sparse);
+
+		grid_append(grid);
+
+		t0 = now_ns();
+		grid_delete(grid);
+		total += now_ns() - t0;
+
+		gp_widget_free(grid);
+	}
+
+	return (double)total / loops / 1000000;
+}
+
+static double bench_layout(int sparse)
+{
+	const gp_widget_render_ctx *ctx = gp_widgets_render_ctx();
+	gp_widget *grid = grid_new(sparse);
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	grid_append(grid);
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		gp_widget_resize(grid);
+
+		t0 = now_ns();
+		gp_widget_calc_size(grid, ctx, 0, 0, 1);
+		total += now_ns() - t0;
+	}
+
+	gp_widget_free(grid);
+
+	return (double)total / loops / 1000000;
+}
+
+static void bench_grid(const char *name, int sparse)
+{
+	double append_ms, insert_ms, delete_ms, layout_ms;
+
+	append_ms = bench_build(grid_append, sparse);
+	insert_ms = bench_build(grid_insert, sparse);
+	delete_ms = bench_delete(sparse);
+	layout_ms = bench_layout(sparse);
+
+	printf("%-8s %12.1f %12.1f %12.1f %12.1f\n", name,
+	       append_ms, insert_ms, delete_ms, layout_ms);
+}
+
+int on_event(gp_widget_event *ev)
+{
+	(void)ev;
+	return 0;
+}
+
+int main(void)
+{
+	printf("%u rows, %u columns\n\n", GRID_ROWS, GRID_COLS);
+	printf("%-8s %12s %12s %12s %12s\n", "grid", "append[ms]",
+	       "insert[ms]", "delete[ms]", "layout[ms]");
+
+	bench_grid("dense", 0);
+	bench_grid("sparse", 1);
+
+	return 0;
+}
@@ -0,0 +1,299 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Layout benchmark.
+ *
+ * Renders layouts into an offscreen pixmap and reports time spend in the
+ * measure, distribute and render phases of a full relayout as well as time
+ * needed to repaint a frame of an unchanged layout and a frame after all
+ * scroll areas in the layout were scrolled by SCROLL_STEP pixels.
+ *
+ * Each phase is repeated until BENCH_MIN_NS has passed, the times reported
+ * are averages in microseconds.
+ *
+ * Pass -c budget_kB to measure frames with the widget surface cache enabled.
+ */
+
+#include <stdio.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include "bench.h"
+
+#define NESTED_DEPTH 32
+#define GRID_SIZE 100
+#define TABLE_ROWS 1000000
+/* not a multiple of a row height so that rows straddle the exposed strips */
+#define SCROLL_STEP 7
+
+static double avg_us(uint64_t ns, unsigned int loops)
+{
+	return (double)ns / loops / 1000;
+}
+
+static void count_widgets(gp_widget *self, void *priv)
+{
+	unsigned int *cnt = priv;
+
+	(*cnt)++;
+
+	gp_widget_ops_for_each_child(self, count_widgets, priv);
+}
+
+static void scroll_areas(gp_widget *self, void *priv)
+{
+	unsigned int *cnt = priv;
+
+	if (self->type == GP_WIDGET_SCROLL_AREA) {
+		if (!gp_widget_scroll_area_move(self, 0, SCROLL_STEP))
+			gp_widget_scroll_area_move(self, 0, -self->scroll->y_off);
+
+		(*cnt)++;
+	}
+
+	gp_widget_ops_for_each_child(self, scroll_areas, priv);
+}
+
+static void print_us(uint64_t ns, unsigned int loops)
+{
+	if (!loops) {
+		printf(" %11s", "-");
+		return;
+	}
+
+	printf(" %11.1f", avg_us(ns, loops));
+}
+
+static void bench_layout(const char *name, gp_widget *layout)
+{
+	const gp_widget_render_ctx *ctx = gp_widgets_render_ctx();
+	const gp_widget_layout_stats *stats = gp_widget_layout_stats_get();
+	uint64_t measure = 0, distribute = 0, render = 0, frame = 0, scroll = 0;
+	uint64_t start, t0, t1, t2, t3;
+	unsigned long measured = 0;
+	unsigned int loops, frames, scrolls = 0, widgets = 0, areas = 0;
+	gp_widget_damage damage;
+	gp_pixmap *buf;
+
+	if (!layout) {
+		printf("%-40s failed to load\n", name);
+		return;
+	}
+
+	count_widgets(layout, &widgets);
+
+	buf = gp_widgets_offscreen_render(layout, NULL, 1);
+	if (!buf) {
+		printf("%-40s failed to render\n", name);
+		return;
+	}
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		gp_widget_resize_subtree(layout);
+
+		unsigned long measure_calls = stats->measure_calls;
+
+		t0 = now_ns();
+		gp_widget_min_w(layout, ctx);
+		gp_widget_min_h(layout, ctx);
+		t1 = now_ns();
+		gp_widget_calc_size(layout, ctx, gp_pixmap_w(buf), gp_pixmap_h(buf), 0);
+		t2 = now_ns();
+		gp_widget_redraw(layout);
+		gp_widget_redraw_children(layout);
+		buf = gp_widgets_offscreen_render(layout, NULL, 0);
+		t3 = now_ns();
+
+		measured += stats->measure_calls - measure_calls;
+		measure += t1 - t0;
+		distribute += t2 - t1;
+		render += t3 - t2;
+	}
+
+	gp_widget_damage_init(&damage, GP_WIDGET_DAMAGE_MAX, 0);
+
+	start = now_ns();
+
+	for (frames = 0; !bench_done(frames, start); frames++) {
+		gp_widget_damage_clear(&damage);
+		gp_widget_redraw(layout);
+		gp_widget_redraw_children(layout);
+
+		t0 = now_ns();
+		gp_widgets_offscreen_render(layout, &damage, 0);
+		frame += now_ns() - t0;
+	}
+
+	scroll_areas(layout, &areas);
+
+	if (areas) {
+		start = now_ns();
+
+		for (scrolls = 0; !bench_done(scrolls, start); scrolls++) {
+			gp_widget_damage_clear(&damage);
+			scroll_areas(layout, &areas);
+
+			t0 = now_ns();
+			gp_widgets_offscreen_render(layout, &damage, 0);
+			scroll += now_ns() - t0;
+		}
+	}
+
+	printf("%-40s %7u %9lu %4ux%-5u %11.1f %11.1f %11.1f %11.1f",
+	       name, widgets, measured / loops, gp_pixmap_w(buf), gp_pixmap_h(buf),
+	       avg_us(measure, loops), avg_us(distribute, loops),
+	       avg_us(render, loops), avg_us(frame, frames));
+	print_us(scroll, scrolls);
+	printf("\n");
+
+	gp_widget_free(layout);
+}
+
+static gp_widget *stress_nested(unsigned int depth)
+{
+	gp_widget *child = gp_widget_label_new("Leaf", 0, 0);
+	unsigned int i;
+
+	for (i = 0; i < depth; i++) {
+		gp_widget *grid;
+
+		if (i % 2) {
+			grid = gp_widget_grid_new(2, 1);
+			gp_widget_grid_put(grid, 0, 0, gp_widget_label_new("Level", 0, 0));
+			gp_widget_grid_put(grid, 1, 0, child);
+		} else {
+			grid = gp_widget_grid_new(1, 2);
+			gp_widget_grid_put(grid, 0, 0, gp_widget_label_new("Level", 0, 0));
+			gp_widget_grid_put(grid, 0, 1, child);
+		}
+
+		child = grid;
+	}
+
+	return child;
+}
+
+static gp_widget *stress_grid(unsigned int cols, unsigned int rows)
+{
+	gp_widget *grid = gp_widget_grid_new(cols, rows);
+	unsigned int col, row;
+	char buf[32];
+
+	for (col = 0; col < cols; col++) {
+		for (row = 0; row < rows; row++) {
+			snprintf(buf, sizeof(buf), "%u:%u", col, row);
+			gp_widget_grid_put(grid, col, row, gp_widget_label_new(buf, 0, 0));
+		}
+	}
+
+	return grid;
+}
+
+static int table_row(gp_widget *self, int op, unsigned int pos)
+{
+	switch (op) {
+	case GP_TABLE_ROW_RESET:
+		self->tbl->row_idx = 0;
+	break;
+	case GP_TABLE_ROW_ADVANCE:
+		self->tbl->row_idx += pos;
+	break;
+	}
+
+	return self->tbl->row_idx < TABLE_ROWS;
+}
+
+static const char *table_get(gp_widget *self, unsigned int col)
+{
+	static char buf[32];
+
+	snprintf(buf, sizeof(buf), "%lu:%u", self->tbl->row_idx, col);
+
+	return buf;
+}
+
+static const gp_widget_table_header table_headers[] = {
+	{.text = "Row"},
+	{.text = "Value"},
+	{.text = "Another value"},
+};
+
+static gp_widget *stress_table(void)
+{
+	return gp_widget_table_new(GP_ARRAY_SIZE(table_headers), 25,
+	                           table_headers, table_row, table_get);
+}
+
+int on_event(gp_widget_event *ev)
+{
+	(void)ev;
+	return 0;
+}
+
+static double hit_rate(unsigned long hits, unsigned long misses)
+{
+	unsigned long total = hits + misses;
+
+	return total ? 100.0 * hits / total : 0.0;
+}
+
+static void print_cache_stats(void)
+{
+	const gp_text_cache_stats *text = gp_text_cache_stats_get();
+	const gp_widget_surface_cache_stats *surf = gp_widget_surface_cache_stats_get();
+
+	printf("\nText cache: %lu hits %lu misses (%.1f%% hit rate)\n",
+	       text->hits, text->misses, hit_rate(text->hits, text->misses));
+
+	if (!surf->budget)
+		return;
+
+	printf("Surface cache: %lu hits %lu misses (%.1f%% hit rate) "
+	       "%lu evictions, %u surfaces %zukB of %zukB\n",
+	       surf->hits, surf->misses, hit_rate(surf->hits, surf->misses),
+	       surf->evictions, surf->surfaces, surf->used / 1024,
+	       surf->budget / 1024);
+}
+
+int main(int argc, char *argv[])
+{
+	char name[64];
+	int i;
+
+	gp_widgets_getopt(&argc, &argv);
+
+	if (!gp_widgets_offscreen_init(GP_PIXEL_RGB888)) {
+		fprintf(stderr, "Failed to initialize offscreen rendering\n");
+		return 1;
+	}
+
+	printf("%-40s %7s %9s %10s %11s %11s %11s %11s %11s\n",
+	       "layout", "widgets", "measured", "size",
+	       "measure[us]", "distrib[us]", "render[us]", "frame[us]",
+	       "scroll[us]");
+
+	for (i = 0; i < argc; i++)
+		bench_layout(argv[i], gp_widget_layout_json(argv[i], NULL));
+
+	snprintf(name, sizeof(name), "stress: nested grids depth %u", NESTED_DEPTH);
+	bench_layout(name, stress_nested(NESTED_DEPTH));
+
+	snprintf(name, sizeof(name), "stress: grid %ux%u", GRID_SIZE, GRID_SIZE);
+	bench_layout(name, stress_grid(GRID_SIZE, GRID_SIZE));
+
+	snprintf(name, sizeof(name), "stress: table %u rows", TABLE_ROWS);
+	bench_layout(name, stress_table());
+
+	print_cache_stats();
+
+	gp_widgets_offscreen_exit();
+
+	return 0;
+}
@@ -0,0 +1,183 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Lazy loading benchmark.
+ *
+ * Generates a settings dialog like layout with TABS tabs of ROWS rows each and
+ * loads COPIES copies of it once with all tabs created and once with "lazy"
+ * set so that only the active tab is created. Reports average load time in
+ * microseconds, number of widgets created, resident memory growth with all
+ * copies loaded and average time needed to activate all tabs of a copy.
+ *
+ * Each run is done in a separate process so that the heap state of one run
+ * does not affect the other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include "bench.h"
+
+#define COPIES 100
+#define TABS 12
+#define ROWS 20
+
+static long rss_kb(void)
+{
+	long pages, rss = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+
+	if (!f)
+		return 0;
+
+	if (fscanf(f, "%ld %ld", &pages, &rss) != 2)
+		rss = 0;
+
+	fclose(f);
+
+	return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int write_layout(FILE *f, int lazy)
+{
+	unsigned int tab, row;
+
+	fprintf(f, "{\n \"type\": \"tabs\",\n \"lazy\": %s,\n \"labels\": [",
+	        lazy ? "true" : "false");
+
+	for (tab = 0; tab < TABS; tab++)
+		fprintf(f, "%s\"Tab %u\"", tab ? ", " : "", tab);
+
+	fprintf(f, "],\n \"widgets\": [\n");
+
+	for (tab = 0; tab < TABS; tab++) {
+		fprintf(f, "  {\"cols\": 3, \"rows\": %u, \"widgets\": [\n", ROWS);
+
+		for (row = 0; row < ROWS; row++)
+			fprintf(f, "   {\"type\": \"label\", \"text\": \"Option %u\"},\n", row);
+
+		for (row = 0; row < ROWS; row++)
+			fprintf(f, "   {\"type\": \"textbox\", \"text\": \"%u\", \"size\": 10},\n", row);
+
+		for (row = 0; row < ROWS; row++) {
+			fprintf(f, "   {\"type\": \"checkbox\", \"label\": \"Enabled\"}%s\n",
+			        row + 1 < ROWS ? "," : "");
+		}
+
+		fprintf(f, "  ]}%s\n", tab + 1 < TABS ? "," : "");
+	}
+
+	fprintf(f, " ]\n}\n");
+
+	return fclose(f);
+}
+
+static void count_widgets(gp_widget *self, void *priv)
+{
+	unsigned int *cnt = priv;
+
+	(*cnt)++;
+
+	gp_widget_ops_for_each_child(self, count_widgets, priv);
+}
+
+static void bench_run(const char *path, int lazy)
+{
+	static gp_widget *layouts[COPIES];
+	unsigned int i, tab, widgets = 0;
+	uint64_t t0, t1, t2;
+	long rss0, rss1;
+
+	rss0 = rss_kb();
+
+	t0 = now_ns();
+
+	for (i = 0; i < COPIES; i++)
+		layouts[i] = gp_widget_layout_json(path, NULL);
+
+	t1 = now_ns();
+
+	rss1 = rss_kb();
+
+	if (!layouts[0]) {
+		printf("%-10s failed to load\n", lazy ? "lazy" : "eager");
+		return;
+	}
+
+	count_widgets(layouts[0], &widgets);
+
+	for (i = 0; i < COPIES; i++) {
+		for (tab = 1; tab < TABS; tab++)
+			gp_widget_tabs_set_active(layouts[i], tab);
+	}
+
+	t2 = now_ns();
+
+	printf("%-10s %11.1f %7u %9ld %13.1f\n", lazy ? "lazy" : "eager",
+	       (double)(t1 - t0) / COPIES / 1000, widgets, rss1 - rss0,
+	       (double)(t2 - t1) / COPIES / 1000);
+
+	for (i = 0; i < COPIES; i++)
+		gp_widget_free(layouts[i]);
+}
+
+static void bench(int lazy)
+{
+	char path[] = "/tmp/lazy_bench_XXXXXX";
+	pid_t pid;
+	FILE *f;
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp()");
+		return;
+	}
+
+	f = fdopen(fd, "w");
+	if (!f || write_layout(f, lazy)) {
+		perror("Failed to write layout");
+		goto exit;
+	}
+
+	fflush(stdout);
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork()");
+		goto exit;
+	}
+
+	if (!pid) {
+		bench_run(path, lazy);
+		exit(0);
+	}
+
+	waitpid(pid, NULL, 0);
+exit:
+	unlink(path);
+}
+
+int main(int argc, char *argv[])
+{
+	gp_widgets_getopt(&argc, &argv);
+
+	printf("%u tabs %u rows each, %u copies\n\n", TABS, ROWS, COPIES);
+
+	printf("%-10s %11s %7s %9s %13s\n", "mode", "load[us]", "widgets",
+	       "rss[kB]", "show all[us]");
+
+	bench(0);
+	bench(1);
+
+	return 0;
+}
@@ -0,0 +1,189 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * List benchmark.
+ *
+ * Compares a grid with a label per row put into a scroll area with a list
+ * widget with the same number of items. Reports the time needed to create and
+ * render the first frame, to recalculate the whole layout and to scroll down,
+ * along with the number of widgets measured per layout recalculation.
+ *
+ * Each case is repeated until BENCH_MIN_NS has passed, the times reported are
+ * averages in microseconds.
+ */
+
+#include <stdio.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include <gp_widget_ops.h>
+#include "bench.h"
+
+#define LIST_ITEMS 50000
+#define LIST_H 400
+#define SCROLL_STEP 20
+
+static void item_text(char *buf, size_t size, unsigned int idx)
+{
+	snprintf(buf, size, "Item %u", idx);
+}
+
+static gp_widget *grid_new(void)
+{
+	gp_widget *grid = gp_widget_grid_new(1, LIST_ITEMS);
+	unsigned int i;
+	char buf[32];
+
+	if (!grid)
+		return NULL;
+
+	for (i = 0; i < LIST_ITEMS; i++) {
+		item_text(buf, sizeof(buf), i);
+		gp_widget_grid_put(grid, 0, i, gp_widget_label_new(buf, 0, 0));
+	}
+
+	return gp_widget_scroll_area_new(0, LIST_H, grid);
+}
+
+static unsigned int item_cnt(gp_widget *self)
+{
+	(void)self;
+	return LIST_ITEMS;
+}
+
+static gp_widget *item_new(gp_widget *self)
+{
+	(void)self;
+	return gp_widget_label_new("", 0, 0);
+}
+
+static void item_set(gp_widget *self, gp_widget *item, unsigned int idx)
+{
+	char buf[32];
+
+	(void)self;
+
+	item_text(buf, sizeof(buf), idx);
+	gp_widget_label_set(item, buf);
+}
+
+static const gp_widget_list_model list_model = {
+	.item_cnt = item_cnt,
+	.item_new = item_new,
+	.item_set = item_set,
+};
+
+static gp_widget *list_new(void)
+{
+	return gp_widget_list_new(0, LIST_H, &list_model, NULL);
+}
+
+static void grid_scroll(gp_widget *layout)
+{
+	if (!gp_widget_scroll_area_move(layout, 0, SCROLL_STEP))
+		gp_widget_scroll_area_move(layout, 0, -LIST_ITEMS * LIST_H);
+}
+
+static void list_scroll(gp_widget *layout)
+{
+	if (!gp_widget_list_move(layout, SCROLL_STEP))
+		gp_widget_list_move(layout, -LIST_ITEMS * LIST_H);
+}
+
+static double bench_create(gp_widget *(*create)(void))
+{
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		t0 = now_ns();
+		gp_widget *layout = create();
+		gp_widgets_offscreen_render(layout, NULL, 1);
+		total += now_ns() - t0;
+
+		gp_widget_free(layout);
+	}
+
+	return (double)total / loops / 1000;
+}
+
+static double bench_frame(gp_widget *layout, void (*change)(gp_widget *layout),
+                          int new_wh)
+{
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		if (change)
+			change(layout);
+
+		t0 = now_ns();
+		gp_widgets_offscreen_render(layout, NULL, new_wh);
+		total += now_ns() - t0;
+	}
+
+	return (double)total / loops / 1000;
+}
+
+static void bench_layout(const char *name, gp_widget *(*create)(void),
+                         void (*scroll)(gp_widget *layout))
+{
+	const gp_widget_layout_stats *stats = gp_widget_layout_stats_get();
+	double create_us, relayout_us, scroll_us;
+	unsigned int measured;
+	gp_widget *layout;
+
+	create_us = bench_create(create);
+
+	layout = create();
+	if (!layout || !gp_widgets_offscreen_render(layout, NULL, 1)) {
+		printf("%-12s failed to render\n", name);
+		gp_widget_free(layout);
+		return;
+	}
+
+	relayout_us = bench_frame(layout, NULL, 1);
+	measured = stats->last_measure_calls;
+	scroll_us = bench_frame(layout, scroll, 0);
+
+	printf("%-12s %12.1f %12.1f %12.1f %9u\n", name,
+	       create_us, relayout_us, scroll_us, measured);
+
+	gp_widget_free(layout);
+}
+
+int on_event(gp_widget_event *ev)
+{
+	(void)ev;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	gp_widgets_getopt(&argc, &argv);
+
+	if (!gp_widgets_offscreen_init(GP_PIXEL_RGB888)) {
+		fprintf(stderr, "Failed to initialize offscreen rendering\n");
+		return 1;
+	}
+
+	printf("%u items\n\n", LIST_ITEMS);
+	printf("%-12s %12s %12s %12s %9s\n", "layout", "create[us]",
+	       "relayout[us]", "scroll[us]", "measured");
+
+	bench_layout("scroll area", grid_new, grid_scroll);
+	bench_layout("list", list_new, list_scroll);
+
+	gp_widgets_offscreen_exit();
+
+	return 0;
+}
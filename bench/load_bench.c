@@ -0,0 +1,184 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Layout load benchmark.
+ *
+ * Compiles each JSON layout into a binary layout and compares the time needed
+ * to load the layout with gp_widget_layout_json() and gp_widget_layout_bjson().
+ * Each load is repeated until BENCH_MIN_NS has passed, the times reported
+ * are averages in microseconds and do not include freeing the layout.
+ *
+ * The widget trees produced by both loaders are compared as well and the
+ * program exits with non-zero status if any of them differ.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include "bench.h"
+
+static double bench_load(gp_widget *(*load)(const char *path, void **uids),
+                         const char *path)
+{
+	uint64_t start, t0, total = 0;
+	unsigned int loops;
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		t0 = now_ns();
+		gp_widget *layout = load(path, NULL);
+		total += now_ns() - t0;
+
+		gp_widget_free(layout);
+	}
+
+	return (double)total / loops / 1000;
+}
+
+struct flat_tree {
+	const gp_widget **widgets;
+	unsigned int cnt;
+	unsigned int size;
+};
+
+static void flatten(gp_widget *self, void *priv)
+{
+	struct flat_tree *tree = priv;
+
+	if (tree->cnt >= tree->size) {
+		tree->size = tree->size ? 2 * tree->size : 64;
+		tree->widgets = realloc(tree->widgets, tree->size * sizeof(gp_widget *));
+	}
+
+	tree->widgets[tree->cnt++] = self;
+
+	gp_widget_ops_for_each_child(self, flatten, priv);
+}
+
+static int same_widget(const gp_widget *a, const gp_widget *b)
+{
+	if (a->type != b->type || a->align != b->align ||
+	    a->no_resize != b->no_resize || a->event_mask != b->event_mask ||
+	    a->on_event != b->on_event)
+		return 0;
+
+	if (a->parent ? !b->parent || a->parent->type != b->parent->type : !!b->parent)
+		return 0;
+
+	if (a->type == GP_WIDGET_LABEL) {
+		const char *ta = a->label->text, *tb = b->label->text;
+
+		return ta && tb ? !strcmp(ta, tb) : ta == tb;
+	}
+
+	return 1;
+}
+
+static int same_tree(gp_widget *a, gp_widget *b)
+{
+	struct flat_tree ta = {}, tb = {};
+	unsigned int i;
+	int ret;
+
+	flatten(a, &ta);
+	flatten(b, &tb);
+
+	ret = ta.cnt == tb.cnt;
+
+	for (i = 0; ret && i < ta.cnt; i++)
+		ret = same_widget(ta.widgets[i], tb.widgets[i]);
+
+	free(ta.widgets);
+	free(tb.widgets);
+
+	return ret;
+}
+
+static int bench_layout(const char *path)
+{
+	char bin_path[] = "/tmp/load_bench_XXXXXX";
+	gp_bjson_hdr *hdr;
+	gp_widget *json, *bjson;
+	double json_us, bjson_us;
+	int fd, same = 0;
+
+	hdr = gp_widget_layout_compile(path);
+	if (!hdr) {
+		printf("%-40s failed to compile\n", path);
+		return 1;
+	}
+
+	fd = mkstemp(bin_path);
+	if (fd < 0) {
+		perror("mkstemp()");
+		free(hdr);
+		return 1;
+	}
+
+	close(fd);
+
+	if (gp_bjson_save(hdr, bin_path))
+		goto exit;
+
+	json = gp_widget_layout_json(path, NULL);
+	bjson = gp_widget_layout_bjson(bin_path, NULL);
+
+	if (!json || !bjson) {
+		printf("%-40s failed to load\n", path);
+		gp_widget_free(json);
+		gp_widget_free(bjson);
+		goto exit;
+	}
+
+	same = same_tree(json, bjson);
+
+	gp_widget_free(json);
+	gp_widget_free(bjson);
+
+	json_us = bench_load(gp_widget_layout_json, path);
+	bjson_us = bench_load(gp_widget_layout_bjson, bin_path);
+
+	printf("%-40s %7u %9u %11.1f %11.1f %7.1fx %4s\n",
+	       path, (unsigned int)hdr->nodes, (unsigned int)hdr->size,
+	       json_us, bjson_us, json_us / bjson_us, same ? "yes" : "NO");
+exit:
+	unlink(bin_path);
+	free(hdr);
+	return !same;
+}
+
+int on_event(gp_widget_event *ev)
+{
+	(void)ev;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, failed = 0;
+
+	gp_widgets_getopt(&argc, &argv);
+
+	printf("%-40s %7s %9s %11s %11s %8s %4s\n", "layout", "nodes", "bytes",
+	       "json[us]", "bjson[us]", "speedup", "same");
+
+	for (i = 0; i < argc; i++)
+		failed += bench_layout(argv[i]);
+
+	if (failed) {
+		printf("%i layout(s) failed the JSON and bjson comparison!\n", failed);
+		return 1;
+	}
+
+	return 0;
+}
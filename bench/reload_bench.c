@@ -0,0 +1,170 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Layout reload benchmark.
+ *
+ * Generates a grid layout with COLS x ROWS cells and a copy that differs in a
+ * single label and compares the time needed to load the changed layout from
+ * scratch with the time needed to patch the live layout by
+ * gp_widget_layout_patch(), which is what happens when a layout loaded by
+ * gp_widget_layout_json_watch() is edited. Both copies are compiled before the
+ * measurement, i.e. the times do not include JSON parsing.
+ *
+ * Each measurement is repeated until BENCH_MIN_NS has passed, the times
+ * reported are averages in microseconds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include "bench.h"
+
+#define COLS 20
+#define ROWS 100
+
+static gp_bjson_hdr *gen_layout(const char *changed)
+{
+	char path[] = "/tmp/reload_bench_XXXXXX";
+	gp_bjson_hdr *ret = NULL;
+	unsigned int col, row;
+	FILE *f;
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp()");
+		return NULL;
+	}
+
+	f = fdopen(fd, "w");
+	if (!f) {
+		perror("fdopen()");
+		close(fd);
+		goto exit;
+	}
+
+	fprintf(f, "{\n \"cols\": %u, \"rows\": %u, \"widgets\": [\n", COLS, ROWS);
+
+	for (col = 0; col < COLS; col++) {
+		for (row = 0; row < ROWS; row++) {
+			const char *sep = col + 1 < COLS || row + 1 < ROWS ? "," : "";
+
+			if (col % 2) {
+				fprintf(f, "  {\"type\": \"textbox\", \"uid\": \"t%u_%u\", \"size\": 8}%s\n",
+				        col, row, sep);
+				continue;
+			}
+
+			if (col == COLS/2 && row == ROWS/2) {
+				fprintf(f, "  {\"type\": \"label\", \"text\": \"%s\"}%s\n",
+				        changed, sep);
+				continue;
+			}
+
+			fprintf(f, "  {\"type\": \"label\", \"text\": \"Label %u:%u\"}%s\n",
+			        col, row, sep);
+		}
+	}
+
+	fprintf(f, " ]\n}\n");
+
+	if (fclose(f)) {
+		perror("fclose()");
+		goto exit;
+	}
+
+	ret = gp_widget_layout_compile(path);
+exit:
+	unlink(path);
+	return ret;
+}
+
+static void htable_free(void *uids)
+{
+	if (uids)
+		gp_htable_free(uids);
+}
+
+int main(int argc, char *argv[])
+{
+	gp_bjson_hdr *json[2], *same;
+	gp_widget *layout;
+	gp_widget_reload_stats stats;
+	uint64_t start, t0, load = 0, patch = 0, noop = 0;
+	unsigned int loops, patches, noops;
+	void *uids = NULL;
+
+	gp_widgets_getopt(&argc, &argv);
+
+	json[0] = gen_layout("Original");
+	json[1] = gen_layout("Changed");
+
+	if (!json[0] || !json[1]) {
+		fprintf(stderr, "Failed to generate layouts\n");
+		return 1;
+	}
+
+	start = now_ns();
+
+	for (loops = 0; !bench_done(loops, start); loops++) {
+		void *load_uids = NULL;
+
+		t0 = now_ns();
+		layout = gp_widget_layout_from_bjson(gp_bjson_root(json[1]), &load_uids);
+		load += now_ns() - t0;
+
+		gp_widget_free(layout);
+		htable_free(load_uids);
+	}
+
+	layout = gp_widget_layout_from_bjson(gp_bjson_root(json[0]), &uids);
+
+	start = now_ns();
+
+	for (patches = 0; !bench_done(patches, start); patches++) {
+		const gp_bjson *old = gp_bjson_root(json[patches % 2]);
+		const gp_bjson *new = gp_bjson_root(json[(patches + 1) % 2]);
+
+		t0 = now_ns();
+		layout = gp_widget_layout_patch(layout, old, new, &uids, &stats);
+		patch += now_ns() - t0;
+	}
+
+	same = gp_bjson_dup(gp_bjson_root(json[patches % 2]));
+	if (!same) {
+		fprintf(stderr, "Failed to copy layout\n");
+		return 1;
+	}
+
+	start = now_ns();
+
+	for (noops = 0; !bench_done(noops, start); noops++) {
+		const gp_bjson *cur = gp_bjson_root(json[patches % 2]);
+
+		t0 = now_ns();
+		layout = gp_widget_layout_patch(layout, cur, gp_bjson_root(same), &uids, NULL);
+		noop += now_ns() - t0;
+	}
+
+	printf("grid %ux%u, one label changed\n\n", COLS, ROWS);
+	printf("%-24s %11.1f\n", "full load [us]", (double)load / loops / 1000);
+	printf("%-24s %11.1f (%u kept, %u patched, %u rebuilt)\n", "patch [us]",
+	       (double)patch / patches / 1000, stats.kept, stats.patched, stats.rebuilt);
+	printf("%-24s %11.1f\n", "unchanged patch [us]", (double)noop / noops / 1000);
+
+	gp_widget_free(layout);
+	htable_free(uids);
+	free(json[0]);
+	free(json[1]);
+	free(same);
+
+	return 0;
+}
@@ -0,0 +1,232 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Table repaint benchmark.
+ *
+ * Renders a table into an offscreen pixmap and compares the time needed to
+ * repaint a frame after the whole table was refreshed, after the focused row
+ * moved down, after the table scrolled down and after a single row was
+ * refreshed, along with the number of cells fetched and the damaged area per
+ * frame.
+ *
+ * Tables with the row iterator and with the random access model are measured,
+ * the latter also with the cell cache enabled.
+ *
+ * Each case is repeated until BENCH_MIN_NS has passed, the times reported are
+ * averages in microseconds.
+ */
+
+#include <stdio.h>
+#include <gfxprim.h>
+#include <gp_widgets.h>
+#include <gp_widget_ops.h>
+#include "bench.h"
+
+#define TABLE_ROWS 10000000
+#define TABLE_VISIBLE_ROWS 100
+
+static unsigned long cells;
+
+static int table_row(gp_widget *self, int op, unsigned int pos)
+{
+	switch (op) {
+	case GP_TABLE_ROW_RESET:
+		self->tbl->row_idx = 0;
+	break;
+	case GP_TABLE_ROW_ADVANCE:
+		self->tbl->row_idx += pos;
+	break;
+	}
+
+	return self->tbl->row_idx < TABLE_ROWS;
+}
+
+static const char *table_get(gp_widget *self, unsigned int col)
+{
+	static char buf[32];
+
+	cells++;
+
+	snprintf(buf, sizeof(buf), "%lu:%u", self->tbl->row_idx, col);
+
+	return buf;
+}
+
+static unsigned int model_row_cnt(gp_widget *self)
+{
+	(void)self;
+
+	return TABLE_ROWS;
+}
+
+static const char *model_get_cell(gp_widget *self, unsigned int row, unsigned int col)
+{
+	static char buf[32];
+
+	(void)self;
+
+	cells++;
+
+	snprintf(buf, sizeof(buf), "%u:%u", row, col);
+
+	return buf;
+}
+
+static const gp_widget_table_model table_model = {
+	.row_cnt = model_row_cnt,
+	.get_cell = model_get_cell,
+};
+
+static const gp_widget_table_header table_headers[] = {
+	{.text = "Row"},
+	{.text = "Value"},
+	{.text = "Another value"},
+};
+
+static void table_refresh(gp_widget *table)
+{
+	gp_widget_table_refresh(table);
+}
+
+static void table_move_down(gp_widget *table)
+{
+	gp_event ev = {
+		.type = GP_EV_KEY,
+		.code = GP_EV_KEY_DOWN,
+		.val = GP_KEY_DOWN,
+	};
+
+	/* Wrap around before the table starts to scroll */
+	if (table->tbl->focused_row + 2 >= TABLE_VISIBLE_ROWS)
+		table->tbl->focused_row = 0;
+
+	gp_widget_ops_event(table, gp_widgets_render_ctx(), &ev);
+}
+
+static void table_scroll_down(gp_widget *table)
+{
+	gp_event ev = {
+		.type = GP_EV_KEY,
+		.code = GP_EV_KEY_DOWN,
+		.val = GP_KEY_DOWN,
+	};
+	unsigned int last_row = table->tbl->start_row + TABLE_VISIBLE_ROWS;
+
+	/* Keep the focused row at the bottom so that each move scrolls */
+	if (table->tbl->focused_row < last_row)
+		table->tbl->focused_row = last_row;
+
+	gp_widget_ops_event(table, gp_widgets_render_ctx(), &ev);
+}
+
+static void table_row_refresh(gp_widget *table)
+{
+	gp_widget_table_row_refresh(table, TABLE_VISIBLE_ROWS/2);
+}
+
+static void bench_frame(const char *name, gp_widget *table,
+                        void (*change)(gp_widget *table))
+{
+	uint64_t start, t0, frame = 0;
+	unsigned long area = 0;
+	unsigned int frames, i;
+	gp_widget_damage damage;
+
+	gp_widget_damage_init(&damage, GP_WIDGET_DAMAGE_MAX, 0);
+
+	cells = 0;
+	start = now_ns();
+
+	for (frames = 0; !bench_done(frames, start); frames++) {
+		gp_widget_damage_clear(&damage);
+		change(table);
+
+		t0 = now_ns();
+		gp_widgets_offscreen_render(table, &damage, 0);
+		frame += now_ns() - t0;
+
+		for (i = 0; i < damage.cnt; i++)
+			area += (unsigned long)damage.rects[i].w * damage.rects[i].h;
+	}
+
+	printf("%-28s %11.1f %9lu %11lu\n", name, (double)frame / frames / 1000,
+	       cells / frames, area / frames);
+}
+
+int on_event(gp_widget_event *ev)
+{
+	(void)ev;
+	return 0;
+}
+
+static void bench_table(const char *name, gp_widget *table)
+{
+	char case_name[64];
+	gp_pixmap *buf;
+
+	if (!table) {
+		printf("%-28s failed to create\n", name);
+		return;
+	}
+
+	buf = gp_widgets_offscreen_render(table, NULL, 1);
+	if (!buf) {
+		printf("%-28s failed to render\n", name);
+		gp_widget_free(table);
+		return;
+	}
+
+	snprintf(case_name, sizeof(case_name), "%s full refresh", name);
+	bench_frame(case_name, table, table_refresh);
+
+	snprintf(case_name, sizeof(case_name), "%s focus move", name);
+	bench_frame(case_name, table, table_move_down);
+
+	snprintf(case_name, sizeof(case_name), "%s scroll", name);
+	bench_frame(case_name, table, table_scroll_down);
+
+	snprintf(case_name, sizeof(case_name), "%s row refresh", name);
+	bench_frame(case_name, table, table_row_refresh);
+
+	gp_widget_free(table);
+}
+
+int main(int argc, char *argv[])
+{
+	gp_widget *table;
+
+	gp_widgets_getopt(&argc, &argv);
+
+	if (!gp_widgets_offscreen_init(GP_PIXEL_RGB888)) {
+		fprintf(stderr, "Failed to initialize offscreen rendering\n");
+		return 1;
+	}
+
+	printf("table %u rows, %u visible\n\n", TABLE_ROWS, TABLE_VISIBLE_ROWS);
+	printf("%-28s %11s %9s %11s\n", "change", "frame[us]", "cells", "damage[px]");
+
+	bench_table("iterator",
+	            gp_widget_table_new(GP_ARRAY_SIZE(table_headers), TABLE_VISIBLE_ROWS,
+	                                table_headers, table_row, table_get));
+
+	bench_table("model",
+	            gp_widget_table_model_new(GP_ARRAY_SIZE(table_headers), TABLE_VISIBLE_ROWS,
+	                                      table_headers, &table_model));
+
+	table = gp_widget_table_model_new(GP_ARRAY_SIZE(table_headers), TABLE_VISIBLE_ROWS,
+	                                  table_headers, &table_model);
+	if (table)
+		gp_widget_table_cache(table, 1);
+
+	bench_table("model cached", table);
+
+	gp_widgets_offscreen_exit();
+
+	return 0;
+}
@@ -6,6 +6,7 @@
 
  */
 
+#include <string.h>
 #include <gfxprim.h>
 #include <gp_widgets.h>
 
@@ -18,11 +19,18 @@ int on_event(gp_widget_event *ev)
 int main(int argc, char *argv[])
 {
 	if (argc != 2) {
-		fprintf(stderr, "usage: %s layout.json\n", argv[0]);
+		fprintf(stderr, "usage: %s layout.json|layout.bjson\n", argv[0]);
 		return 1;
 	}
 
-	gp_widget *layout = gp_widget_layout_json(argv[1], NULL);
+	const char *ext = strrchr(argv[1], '.');
+	gp_widget *layout;
+
+	if (ext && !strcmp(ext, ".bjson"))
+		layout = gp_widget_layout_bjson(argv[1], NULL);
+	else
+		layout = gp_widget_layout_json_watch(argv[1], NULL);
+
 	if (!layout) {
 		fprintf(stderr, "Layout cannot be loaded!\n");
 		return 1;
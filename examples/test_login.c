@@ -51,10 +51,19 @@ int show_password(gp_widget_event *ev)
 	return 0;
 }
 
+static const gp_widget_callback callbacks[] = {
+	GP_WIDGET_CALLBACK(login_callback),
+	GP_WIDGET_CALLBACK(cancel_callback),
+	GP_WIDGET_CALLBACK(show_password),
+	{}
+};
+
 int main(int argc, char *argv[])
 {
 	const char *layout_path = "test_login_1.json";
 
+	gp_widget_callbacks_register(callbacks);
+
 	if (argv[1]) {
 		layout_path = "test_login_2.json";
 	}
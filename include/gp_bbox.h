@@ -77,6 +77,13 @@ static inline int gp_bbox_intersects(gp_bbox box1, gp_bbox box2)
 	return 1;
 }
 
+static inline int gp_bbox_contains(gp_bbox box, gp_bbox inner)
+{
+	return inner.x >= box.x && inner.y >= box.y &&
+	       inner.x + (gp_coord)inner.w <= box.x + (gp_coord)box.w &&
+	       inner.y + (gp_coord)inner.h <= box.y + (gp_coord)box.h;
+}
+
 #define GP_BBOX_FMT "[%i, %i] w=%u h=%u"
 #define GP_BBOX_PARS(bbox) (bbox).x, (bbox).y, (bbox).w, (bbox).h
 
@@ -0,0 +1,243 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Binary JSON, a compact read-only representation of a parsed JSON document
+ * that can be mapped from a file and used as it is.
+ *
+ * The blob starts with a header that is followed by an array of fixed size
+ * nodes and a string table. All offsets in a node are relative to the node
+ * itself so that the blob can be used at any address. Elements of an array
+ * and members of an object are stored consecutively, member keys are stored
+ * in the member nodes.
+ *
+ * Scalar nodes have their JSON string representation stored as well so that
+ * gp_bjson_str() works for any value, the same way json_object_get_string()
+ * does.
+ */
+
+#ifndef GP_BJSON_H__
+#define GP_BJSON_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct json_object;
+
+#define GP_BJSON_MAGIC "GPBJ"
+#define GP_BJSON_VERSION 1
+#define GP_BJSON_BYTE_ORDER 0x0102
+
+enum gp_bjson_type {
+	GP_BJSON_NULL,
+	GP_BJSON_BOOL,
+	GP_BJSON_INT,
+	GP_BJSON_DOUBLE,
+	GP_BJSON_STRING,
+	GP_BJSON_ARRAY,
+	GP_BJSON_OBJECT,
+};
+
+typedef struct gp_bjson {
+	/* enum gp_bjson_type */
+	uint8_t type;
+	uint8_t reserved[3];
+	/* string length, number of array elements or object members */
+	uint32_t len;
+	/* offset of the member key, zero if node is not an object member */
+	int32_t key;
+	/* offset of the string, first element or first member, zero if none */
+	int32_t off;
+	union {
+		int64_t i;
+		double d;
+	} val;
+} gp_bjson;
+
+typedef struct gp_bjson_hdr {
+	char magic[4];
+	uint16_t version;
+	/* GP_BJSON_BYTE_ORDER in the byte order of the writer */
+	uint16_t byte_order;
+	/* size of the whole blob including the header */
+	uint32_t size;
+	/* number of nodes, root node is the first one */
+	uint32_t nodes;
+} gp_bjson_hdr;
+
+static inline const gp_bjson *gp_bjson_root(const gp_bjson_hdr *hdr)
+{
+	return (const gp_bjson *)(hdr + 1);
+}
+
+static inline enum gp_bjson_type gp_bjson_type(const gp_bjson *self)
+{
+	return self ? self->type : GP_BJSON_NULL;
+}
+
+static inline int gp_bjson_is_type(const gp_bjson *self, enum gp_bjson_type type)
+{
+	return gp_bjson_type(self) == type;
+}
+
+static inline const char *gp_bjson_key(const gp_bjson *self)
+{
+	return self->key ? (const char *)self + self->key : NULL;
+}
+
+/**
+ * @brief Returns number of array elements or object members.
+ */
+static inline unsigned int gp_bjson_len(const gp_bjson *self)
+{
+	switch (gp_bjson_type(self)) {
+	case GP_BJSON_ARRAY:
+	case GP_BJSON_OBJECT:
+		return self->len;
+	default:
+		return 0;
+	}
+}
+
+static inline const gp_bjson *gp_bjson_first(const gp_bjson *self)
+{
+	return (const gp_bjson *)((const char *)self + self->off);
+}
+
+/**
+ * @brief Returns an array element.
+ *
+ * @self An array node.
+ * @idx An element index.
+ *
+ * @return An element or NULL if self is not an array or idx is out of range.
+ */
+static inline const gp_bjson *gp_bjson_idx(const gp_bjson *self, unsigned int idx)
+{
+	if (!gp_bjson_is_type(self, GP_BJSON_ARRAY) || idx >= self->len)
+		return NULL;
+
+	return gp_bjson_first(self) + idx;
+}
+
+/**
+ * @brief Returns a string or a JSON representation of a scalar value.
+ *
+ * @return A string or NULL for arrays, objects and null values.
+ */
+static inline const char *gp_bjson_str(const gp_bjson *self)
+{
+	switch (gp_bjson_type(self)) {
+	case GP_BJSON_BOOL:
+	case GP_BJSON_INT:
+	case GP_BJSON_DOUBLE:
+	case GP_BJSON_STRING:
+		return (const char *)self + self->off;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * @brief Looks up an object member by a key.
+ *
+ * @self An object node.
+ * @key A member key.
+ *
+ * @return A member or NULL if not found.
+ */
+const gp_bjson *gp_bjson_get(const gp_bjson *self, const char *key);
+
+/**
+ * @brief Compares two subtrees.
+ *
+ * Object members are compared in the order they are stored, i.e. objects with
+ * the same members in a different order are not equal.
+ *
+ * @return Non-zero if the subtrees are equal, the keys of a and b are ignored.
+ */
+int gp_bjson_equal(const gp_bjson *a, const gp_bjson *b);
+
+/*
+ * Value conversions, these follow the json_object_get_*() semantics, i.e.
+ * strings are parsed, booleans are converted to 0 and 1 and arrays, objects
+ * and null values are 0.
+ */
+int gp_bjson_int(const gp_bjson *self);
+
+double gp_bjson_double(const gp_bjson *self);
+
+int gp_bjson_bool(const gp_bjson *self);
+
+/**
+ * @brief Iterates over object members.
+ *
+ * @self An object node.
+ * @key A name for the const char * member key variable.
+ * @val A name for the const gp_bjson * member variable.
+ */
+#define gp_bjson_foreach(self, key, val) \
+	for (const gp_bjson *val = gp_bjson_first(self), \
+	     *val##_end = val + gp_bjson_len(self); val < val##_end; val++) \
+		for (const char *key = gp_bjson_key(val); key; key = NULL)
+
+/**
+ * @brief Compiles a json-c object into a binary JSON blob.
+ *
+ * @json A json-c object.
+ *
+ * @return A newly allocated blob, to be freed by free(), or NULL on failure.
+ */
+gp_bjson_hdr *gp_bjson_compile(struct json_object *json);
+
+/**
+ * @brief Copies a binary JSON subtree into a new blob.
+ *
+ * @self A node to be copied, the node becomes the root of the new blob.
+ *
+ * @return A newly allocated blob, to be freed by free(), or NULL on failure.
+ */
+gp_bjson_hdr *gp_bjson_dup(const gp_bjson *self);
+
+/**
+ * @brief Validates a binary JSON blob.
+ *
+ * Checks the header and that all offsets and strings are within the blob.
+ *
+ * @blob A pointer to a blob.
+ * @size A blob size.
+ *
+ * @return A root node or NULL if the blob is not valid.
+ */
+const gp_bjson *gp_bjson_check(const void *blob, size_t size);
+
+/**
+ * @brief Writes a binary JSON blob into a file.
+ *
+ * @hdr A blob.
+ * @path A file path.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+int gp_bjson_save(const gp_bjson_hdr *hdr, const char *path);
+
+/**
+ * @brief Maps a binary JSON file into the memory and validates it.
+ *
+ * @path A file path.
+ *
+ * @return A blob to be passed to gp_bjson_unmap() or NULL on failure.
+ */
+const gp_bjson_hdr *gp_bjson_map(const char *path);
+
+/**
+ * @brief Unmaps a blob mapped by gp_bjson_map().
+ */
+void gp_bjson_unmap(const gp_bjson_hdr *hdr);
+
+#endif /* GP_BJSON_H__ */
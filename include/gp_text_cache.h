@@ -0,0 +1,92 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Text extent cache.
+ *
+ * Widgets embed a gp_text_cache for each string they measure repeatedly. The
+ * cached width is valid as long as the text style stays the same and the
+ * global cache generation has not changed, the generation is bumped whenever
+ * fonts are changed, e.g. on zoom.
+ *
+ * Widgets have to call gp_text_cache_invalidate() when the string changes.
+ */
+
+#ifndef GP_TEXT_CACHE_H__
+#define GP_TEXT_CACHE_H__
+
+#include <text/gp_text.h>
+
+typedef struct gp_text_cache {
+	const gp_text_style *style;
+	unsigned int gen;
+	gp_size width;
+} gp_text_cache;
+
+typedef struct gp_text_cache_stats {
+	/* current cache generation, never zero */
+	unsigned int gen;
+	unsigned long hits;
+	unsigned long misses;
+} gp_text_cache_stats;
+
+/**
+ * @brief Returns cached text width.
+ *
+ * @self A text cache.
+ * @style A text style.
+ * @str A string, has to be the same as long as the cache is valid.
+ *
+ * @return A string width in pixels.
+ */
+gp_size gp_text_cache_width(gp_text_cache *self, const gp_text_style *style,
+                            const char *str);
+
+/**
+ * @brief Returns cached width of len characters wide text.
+ *
+ * Same as gp_text_max_width_chars() but cached.
+ *
+ * @self A text cache.
+ * @style A text style.
+ * @chars A set of characters expected in the text, may be NULL.
+ * @len A text length in characters.
+ *
+ * @return A text width in pixels.
+ */
+gp_size gp_text_cache_max_width_chars(gp_text_cache *self,
+                                      const gp_text_style *style,
+                                      const char *chars, unsigned int len);
+
+/**
+ * @brief Invalidates a single cache entry.
+ *
+ * Has to be called when the cached string changes.
+ *
+ * @self A text cache.
+ */
+static inline void gp_text_cache_invalidate(gp_text_cache *self)
+{
+	self->gen = 0;
+}
+
+/**
+ * @brief Invalidates all cache entries.
+ *
+ * Has to be called when fonts are changed.
+ */
+void gp_text_cache_flush(void);
+
+/**
+ * @brief Returns text cache statistics.
+ *
+ * @return Cache hit and miss counters.
+ */
+const gp_text_cache_stats *gp_text_cache_stats_get(void);
+
+#endif /* GP_TEXT_CACHE_H__ */
@@ -46,8 +46,24 @@ typedef struct gp_widget {
 	 */
 	unsigned int min_w, min_h;
 
+	/*
+	 * Layout generation the minimal size was computed in.
+	 */
+	unsigned int min_gen;
+
+	/*
+	 * Minimal size when the parent distributed its space last time.
+	 */
+	unsigned int dist_min_w, dist_min_h;
+
 	unsigned int align:16;
 	unsigned int no_resize:1;
+	/*
+	 * Set if container children has to be placed again on next layout
+	 * update even if the container size didn't change, e.g. child was
+	 * added or removed.
+	 */
+	unsigned int redistribute:1;
 	/*
 	 * If set the widget_ops_render() is called next time layout is repainted.
 	 */
@@ -63,9 +79,27 @@ typedef struct gp_widget {
 	unsigned int redraw_children:1;
 	unsigned int focused:1;
 	unsigned int input_events:1;
+	/*
+	 * Set while the widget timer is scheduled.
+	 */
+	unsigned int timer_running:1;
+	/*
+	 * Widget was allocated from an arena and is released along with it.
+	 */
+	unsigned int arena:1;
 
 	uint32_t event_mask;
 
+	/*
+	 * Widget timer, allocated on first use by gp_widget_render_timer().
+	 */
+	struct gp_timer *timer;
+
+	/*
+	 * Retained subtree surface, allocated by gp_widget_retain().
+	 */
+	struct gp_widget_surface_cache *retained;
+
 	union {
 		struct gp_widget_grid *grid;
 		struct gp_widget_tabs *tabs;
@@ -99,6 +133,8 @@ typedef struct gp_widget {
 
 		struct gp_widget_overlay *overlay;
 
+		struct gp_widget_list *list;
+
 		void *payload;
 	};
 	char buf[];
@@ -122,6 +158,7 @@ enum gp_widget_type {
 	GP_WIDGET_MARKUP,
 	GP_WIDGET_SWITCH,
 	GP_WIDGET_OVERLAY,
+	GP_WIDGET_LIST,
 	GP_WIDGET_MAX,
 };
 
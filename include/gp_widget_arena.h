@@ -0,0 +1,94 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Widget arena.
+ *
+ * While an arena is active widgets, their payloads and strings loaded along
+ * with them are allocated from a chain of big blocks instead of separate
+ * malloc() calls. The whole layout is then released at once by
+ * gp_widget_arena_free().
+ *
+ * Buffers that may grow later, e.g. label text, are still allocated from the
+ * heap and freed when the layout is freed.
+ */
+
+#ifndef GP_WIDGET_ARENA_H__
+#define GP_WIDGET_ARENA_H__
+
+#include <stddef.h>
+#include <utils/gp_block_alloc.h>
+
+#include <gp_widget.h>
+
+typedef struct gp_widget_arena {
+	gp_block *blocks;
+	/* number of bytes and allocations served by the arena */
+	size_t size;
+	unsigned long allocs;
+} gp_widget_arena;
+
+/**
+ * @brief Starts allocating widgets from an arena.
+ *
+ * @self An arena, has to be zeroed before first use.
+ *
+ * @return Zero on success, non-zero if other arena is already active.
+ */
+int gp_widget_arena_begin(gp_widget_arena *self);
+
+/**
+ * @brief Stops allocating widgets from the active arena.
+ */
+void gp_widget_arena_end(void);
+
+/**
+ * @brief Returns true if an arena is active.
+ */
+int gp_widget_arena_active(void);
+
+/**
+ * @brief Allocates memory from the active arena or from the heap.
+ *
+ * @size A size in bytes.
+ *
+ * @return A pointer to the memory, the memory has to be released with free()
+ *         only if there was no arena active.
+ */
+void *gp_widget_arena_malloc(size_t size);
+
+/**
+ * @brief Duplicates a string into the active arena or on the heap.
+ *
+ * @str A string.
+ *
+ * @return A string copy.
+ */
+char *gp_widget_arena_strdup(const char *str);
+
+/**
+ * @brief Loads a layout with widgets allocated from an arena.
+ *
+ * @path A path to a JSON layout.
+ * @uids Pointer to store the uid hash table to.
+ * @self An arena, has to be zeroed before first use.
+ *
+ * @return A widget layout or NULL in a case of failure.
+ */
+gp_widget *gp_widget_layout_json_arena(const char *path, void **uids,
+                                       gp_widget_arena *self);
+
+/**
+ * @brief Frees a layout and the arena it was allocated from.
+ *
+ * @self An arena.
+ * @layout A layout allocated from the arena, may be NULL.
+ */
+void gp_widget_arena_free(gp_widget_arena *self, gp_widget *layout);
+
+#endif /* GP_WIDGET_ARENA_H__ */
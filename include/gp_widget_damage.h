@@ -0,0 +1,73 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Damage list, a short list of rectangles that has to be updated on the screen
+ * after a layout has been rendered.
+ *
+ * Rectangles that overlap or are closer than merge_dist pixels are merged
+ * together. Once the list is full the new rectangle is merged with the one
+ * that grows the least by the merge.
+ */
+
+#ifndef GP_WIDGET_DAMAGE_H__
+#define GP_WIDGET_DAMAGE_H__
+
+#include <gp_bbox.h>
+
+#define GP_WIDGET_DAMAGE_MAX 32
+
+typedef struct gp_widget_damage {
+	/* number of rectangles in the list */
+	unsigned int cnt;
+	/* maximal number of rectangles, at most GP_WIDGET_DAMAGE_MAX */
+	unsigned int max;
+	/* rectangles closer than this are merged */
+	gp_size merge_dist;
+
+	gp_bbox rects[GP_WIDGET_DAMAGE_MAX];
+} gp_widget_damage;
+
+/**
+ * @brief Initializes an empty damage list.
+ *
+ * @self A damage list.
+ * @max Maximal number of rectangles, clamped to [1, GP_WIDGET_DAMAGE_MAX].
+ * @merge_dist Rectangles closer than merge_dist pixels are merged.
+ */
+void gp_widget_damage_init(gp_widget_damage *self, unsigned int max,
+                           gp_size merge_dist);
+
+/**
+ * @brief Adds a rectangle to a damage list.
+ *
+ * @self A damage list.
+ * @box A rectangle to be added.
+ */
+void gp_widget_damage_add(gp_widget_damage *self, gp_bbox box);
+
+/**
+ * @brief Returns a bounding box of all rectangles in a damage list.
+ *
+ * @self A damage list.
+ *
+ * @return A bounding box, empty if the list is empty.
+ */
+gp_bbox gp_widget_damage_bbox(const gp_widget_damage *self);
+
+static inline void gp_widget_damage_clear(gp_widget_damage *self)
+{
+	self->cnt = 0;
+}
+
+static inline int gp_widget_damage_empty(const gp_widget_damage *self)
+{
+	return !self->cnt;
+}
+
+#endif /* GP_WIDGET_DAMAGE_H__ */
@@ -16,6 +16,7 @@
 #define GP_WIDGET_EVENT_H__
 
 #include <stdarg.h>
+#include <gp_widget_trace.h>
 
 /**
  * @brief Widget event type.
@@ -115,6 +116,8 @@ static inline int gp_widget_send_event(gp_widget *self,
 	if (!(self->event_mask & (1<<type)))
 		return 0;
 
+	gp_widget_trace(GP_WIDGET_TRACE_EVENT, 0, type, self->type, self);
+
 	const struct gp_widget_render_ctx *ctx = NULL;
 
 	va_list va;
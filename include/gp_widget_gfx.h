@@ -32,4 +32,12 @@ void gp_triangle_down(gp_pixmap *pix, gp_coord x_center, gp_coord y_center,
 void gp_triangle_updown(gp_pixmap *pix, gp_coord x_center, gp_coord y_center,
                         gp_size base, gp_pixel color);
 
+/*
+ * Moves the content of a rectangle by dx and dy, the parts moved out of the
+ * rectangle are dropped and the exposed parts are left unchanged. Used for
+ * scrolling, so that only the exposed parts have to be rendered.
+ */
+void gp_move_rect_xywh(gp_pixmap *pix, gp_coord x, gp_coord y,
+                       gp_size w, gp_size h, gp_coord dx, gp_coord dy);
+
 #endif /* GP_WIDGET_GFX_H__ */
@@ -11,6 +11,12 @@
 
 #include <stdint.h>
 
+typedef struct gp_widget_grid_cell {
+	unsigned int col;
+	unsigned int row;
+	gp_widget *widget;
+} gp_widget_grid_cell;
+
 struct gp_widget_grid {
 	unsigned int cols, rows;
 
@@ -23,6 +29,8 @@ struct gp_widget_grid {
 	int frame:1;
 	/* if set the grid all columns and all rows have the same size */
 	int uniform:1;
+	/* if set only non-empty cells are stored */
+	int sparse:1;
 
 	/** column/row sizes */
 	unsigned int *cols_w;
@@ -42,11 +50,40 @@ struct gp_widget_grid {
 	uint8_t *col_fills;
 	uint8_t *row_fills;
 
+	/* Internal do not touch */
+
+	/*
+	 * Number of columns and rows the storage has space for, grows
+	 * geometrically so that appending is amortized O(1).
+	 */
+	unsigned int cols_cap, rows_cap;
+
+	/* dense storage, columns are rows_cap pointers apart */
 	gp_widget **widgets;
+
+	/* sparse storage, non-empty cells sorted by row and column */
+	gp_widget_grid_cell *cells;
+	unsigned int cells_cnt;
+	unsigned int cells_size;
 };
 
 gp_widget *gp_widget_grid_new(unsigned int cols, unsigned int rows);
 
+/**
+ * @brief Allocates a grid that stores only non-empty cells.
+ *
+ * Suitable for large grids with most of the cells empty, the memory used is
+ * proportional to the number of widgets in the grid rather than to the number
+ * of cells. Looking up a cell takes O(log n) where n is the number of
+ * widgets.
+ *
+ * @cols Number of columns.
+ * @rows Number of rows.
+ *
+ * @return A grid widget or NULL in a case of a failure.
+ */
+gp_widget *gp_widget_grid_sparse_new(unsigned int cols, unsigned int rows);
+
 /*
  * Puts wiget to be placed inside of the grid, returns previous widget in the
  * grid.
@@ -59,6 +96,54 @@ gp_widget *gp_widget_grid_put(gp_widget *self, unsigned int col, unsigned int ro
  */
 void gp_widget_grid_add_row(gp_widget *self);
 
+/*
+ * Add a new (empty) column to the grid.
+ */
+void gp_widget_grid_add_col(gp_widget *self);
+
+/**
+ * @brief Inserts empty rows into the grid.
+ *
+ * Appending rows is amortized O(1) per row, inserting in the middle moves
+ * the rows after the insertion point.
+ *
+ * @self A grid widget.
+ * @row A row index to insert the rows at, the number of rows appends.
+ * @rows Number of rows to insert.
+ *
+ * @return Zero on success, non-zero on a failure.
+ */
+int gp_widget_grid_rows_ins(gp_widget *self, unsigned int row, unsigned int rows);
+
+/**
+ * @brief Removes rows from the grid, widgets in the rows are freed.
+ *
+ * @self A grid widget.
+ * @row A first row to remove.
+ * @rows Number of rows to remove.
+ */
+void gp_widget_grid_rows_del(gp_widget *self, unsigned int row, unsigned int rows);
+
+/**
+ * @brief Inserts empty columns into the grid.
+ *
+ * @self A grid widget.
+ * @col A column index to insert the columns at, the number of columns appends.
+ * @cols Number of columns to insert.
+ *
+ * @return Zero on success, non-zero on a failure.
+ */
+int gp_widget_grid_cols_ins(gp_widget *self, unsigned int col, unsigned int cols);
+
+/**
+ * @brief Removes columns from the grid, widgets in the columns are freed.
+ *
+ * @self A grid widget.
+ * @col A first column to remove.
+ * @cols Number of columns to remove.
+ */
+void gp_widget_grid_cols_del(gp_widget *self, unsigned int col, unsigned int cols);
+
 /*
  * Removes widget at col, row.
  */
@@ -96,4 +181,19 @@ void gp_widget_grid_hborder_set(gp_widget *self, unsigned int padd, unsigned int
  */
 void gp_widget_grid_vborder_set(gp_widget *self, unsigned int padd, unsigned int fill);
 
+/*
+ * @brief Parses padding or filling coeficients in the JSON layout format.
+ *
+ * The string is a comma separated list of numbers, a number can be repeated
+ * with a '*' e.g. "0, 3 * 1, 0". This is the format of the cpad, rpad, cpadf,
+ * rpadf, cfill and rfill grid attributes.
+ *
+ * @sarray A string to be parsed.
+ * @array An array to store the coeficients to.
+ * @len An array length.
+ * @name A name used in warnings.
+ */
+void gp_widget_grid_coefs_parse(const char *sarray, uint8_t *array,
+                                unsigned int len, const char *name);
+
 #endif /* GP_WIDGET_GRID_H__ */
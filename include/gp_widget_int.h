@@ -27,6 +27,17 @@ static inline int gp_widget_int_get(gp_widget *self)
 	return self->i->val;
 }
 
+/**
+ * @brief Allocate and initialize a spinner widget.
+ *
+ * @min Spinner minimum.
+ * @max Spinner maximum.
+ * @val Initial spinner value.
+ *
+ * @return A spinner widget.
+ */
+gp_widget *gp_widget_spinner_new(int min, int max, int val);
+
 void gp_widget_int_set(gp_widget *self, int val);
 
 void gp_widget_int_set_max(gp_widget *self, int max);
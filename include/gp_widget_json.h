@@ -10,8 +10,7 @@
 #define GP_WIDGET_JSON_H__
 
 #include <gp_widget.h>
-
-struct json_object;
+#include <gp_bjson.h>
 
 /**
  * @brief Loads a widget layout given a JSON object.
@@ -23,6 +22,98 @@ struct json_object;
  */
 gp_widget *gp_widget_from_json(struct json_object *json, void **uids);
 
+/**
+ * @brief Loads a widget layout given a binary JSON node.
+ *
+ * This is the function all layout loaders end up in, the JSON layouts are
+ * compiled into binary JSON first.
+ *
+ * @json A binary JSON object node.
+ * @uids A pointer to a hash table to store widget pointers by UIDs.
+ *
+ * @return A widget layout or a NULL in case of a failure.
+ */
+gp_widget *gp_widget_from_bjson(const gp_bjson *json, void **uids);
+
+/**
+ * @brief Loads a widget layout given a binary JSON node.
+ *
+ * Unlike gp_widget_from_bjson() this function looks up the callbacks that were
+ * not registered in the application binary as well, the same way the layout
+ * loaders do.
+ *
+ * @json A binary JSON object node.
+ * @uids A pointer to a hash table to store widget pointers by UIDs.
+ *
+ * @return A widget layout or a NULL in case of a failure.
+ */
+gp_widget *gp_widget_layout_from_bjson(const gp_bjson *json, void **uids);
+
+/**
+ * @brief Sets the alignment, on_event callback and retain flag of an existing
+ *        widget from a widget JSON object.
+ *
+ * The widget specific keys as well as uid are ignored.
+ *
+ * @self A widget.
+ * @json A binary JSON widget object.
+ */
+void gp_widget_json_apply_common(gp_widget *self, const gp_bjson *json);
+
+/**
+ * @brief Returns non-zero for keys common to all widgets.
+ *
+ * These keys are parsed in gp_widget_from_bjson() and have to be skipped by
+ * the widget from_json() handlers.
+ */
+int gp_widget_json_common_key(const char *key);
+
+/**
+ * @brief Iterates over widget specific keys of a widget JSON object.
+ */
+#define gp_widget_json_foreach(json, key, val) \
+	gp_bjson_foreach(json, key, val) \
+		if (gp_widget_json_common_key(key)) {} else
+
+/**
+ * @brief A widget subtree whose JSON is kept until the subtree is needed.
+ *
+ * Container widgets with the "lazy" JSON key set keep the children that are
+ * not shown when the layout is loaded in this form and create the widgets
+ * once the child is activated, which saves both startup time and memory for
+ * parts of the layout that are never shown.
+ */
+typedef struct gp_widget_lazy gp_widget_lazy;
+
+/**
+ * @brief Stores a widget JSON object for a deferred loading.
+ *
+ * The JSON object is copied so the layout the node points into can be freed.
+ *
+ * @json A binary JSON widget object.
+ * @uids A pointer to a hash table to store widget pointers by UIDs when the
+ *       widgets are created, the pointer has to stay valid until then.
+ *
+ * @return A deferred widget or NULL in case of a failure.
+ */
+gp_widget_lazy *gp_widget_lazy_new(const gp_bjson *json, void **uids);
+
+/**
+ * @brief Creates the widgets for a deferred widget and frees it.
+ *
+ * @self A deferred widget.
+ *
+ * @return A widget or NULL in case of a failure.
+ */
+gp_widget *gp_widget_lazy_load(gp_widget_lazy *self);
+
+/**
+ * @brief Frees a deferred widget that has not been loaded.
+ *
+ * @self A deferred widget.
+ */
+void gp_widget_lazy_free(gp_widget_lazy *self);
+
 /**
  * @brief Loads a widget layout given a path to a JSON layout description.
  *
@@ -33,14 +124,64 @@ gp_widget *gp_widget_from_json(struct json_object *json, void **uids);
  */
 gp_widget *gp_widget_layout_json(const char *fname, void **uids);
 
+/**
+ * @brief Compiles a JSON layout description into binary JSON.
+ *
+ * The result can be written into a file with gp_bjson_save() and loaded with
+ * gp_widget_layout_bjson() which produces the same widget tree as
+ * gp_widget_layout_json() without any JSON parsing.
+ *
+ * @fname A path to a JSON layout file.
+ *
+ * @return A binary JSON blob to be freed by free() or NULL on failure.
+ */
+gp_bjson_hdr *gp_widget_layout_compile(const char *fname);
+
+/**
+ * @brief Loads a widget layout given a path to a compiled binary layout.
+ *
+ * The file is mapped into the memory and validated, widgets are created
+ * directly from the mapping.
+ *
+ * @fname A path to a binary layout file.
+ * @uids A pointer to a hash table to store widget pointers by UIDs.
+ *
+ * @return A widget layout or a NULL in case of a failure.
+ */
+gp_widget *gp_widget_layout_bjson(const char *fname, void **uids);
+
+typedef struct gp_widget_callback {
+	const char *name;
+	void *addr;
+} gp_widget_callback;
+
+/**
+ * @brief Initializes a gp_widget_callback table entry.
+ */
+#define GP_WIDGET_CALLBACK(fn) {.name = #fn, .addr = fn}
+
+/**
+ * @brief Registers a table of callbacks for JSON layouts.
+ *
+ * Registered callbacks are looked up before the symbols exported from the
+ * binary, which means that an application that registers all its callbacks
+ * does not have to be linked with -rdynamic. The table is hashed on the first
+ * lookup after the registration.
+ *
+ * @table An array of callbacks terminated by an entry with NULL name, the
+ *        array must not be modified or freed after the registration.
+ */
+void gp_widget_callbacks_register(const gp_widget_callback *table);
+
 /**
  * @brief Attempts to get a pointer to a function given it's name.
  *
- * This function is used to resolve callbacks from a JSON layout.
+ * This function is used to resolve callbacks from a JSON layout. Registered
+ * callbacks are tried first, then the function is looked up by dlsym().
  *
  * @fn_name A fucntion name.
  *
- * @return A function pointer.
+ * @return A function pointer or NULL if not found or if fn_name is NULL.
  */
 void *gp_widget_callback_addr(const char *fn_name);
 
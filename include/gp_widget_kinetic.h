@@ -0,0 +1,123 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Kinetic scrolling, drag and fling scrolling driven by relative pointer
+ * motion and mouse wheel.
+ *
+ * Input events only accumulate the motion, the widgets are moved from a
+ * single frame timer shared by all scrolling widgets, so that no matter how
+ * many events arrive each widget is moved and rendered at most once per frame.
+ * After the pointer button is released the widget continues to move with a
+ * decaying velocity. The frame timer runs only while a widget is moving.
+ */
+
+#ifndef GP_WIDGET_KINETIC_H__
+#define GP_WIDGET_KINETIC_H__
+
+#include <core/gp_types.h>
+#include <input/gp_event.h>
+
+typedef struct gp_widget_kinetic {
+	/* velocity in pixels per second */
+	int vx;
+	int vy;
+
+	/* Internal do not touch */
+
+	/* sub-pixel motion remainder in 1/1000 of a pixel */
+	int rem_x;
+	int rem_y;
+
+	/* motion accumulated since the last frame */
+	gp_coord drag_x;
+	gp_coord drag_y;
+
+	struct gp_widget *widget;
+	int (*move)(struct gp_widget *self, gp_coord x_off, gp_coord y_off);
+
+	/* next kinetic in the list of moving widgets */
+	struct gp_widget_kinetic *next;
+
+	int dragging:1;
+	int active:1;
+} gp_widget_kinetic;
+
+/**
+ * @brief Initializes a kinetic scrolling state.
+ *
+ * @self A kinetic scrolling state, usually embedded in a widget.
+ * @widget A widget the state belongs to.
+ * @move A callback that moves the widget content by a relative offset in
+ *       pixels, returns zero if the widget cannot move any further.
+ */
+void gp_widget_kinetic_init(gp_widget_kinetic *self, struct gp_widget *widget,
+                            int (*move)(struct gp_widget *self,
+                                        gp_coord x_off, gp_coord y_off));
+
+/**
+ * @brief Feeds an input event into kinetic scrolling.
+ *
+ * Relative motion with the left button pressed drags the content, releasing
+ * the button starts a fling, pressing it stops the content. Wheel moves the
+ * content by wheel_step pixels per wheel step.
+ *
+ * @self A kinetic scrolling state.
+ * @ev An input event.
+ * @wheel_step A distance in pixels to scroll per wheel step.
+ *
+ * @return Non-zero if the event was consumed, button events are never consumed.
+ */
+int gp_widget_kinetic_event(gp_widget_kinetic *self, gp_event *ev,
+                            gp_size wheel_step);
+
+/**
+ * @brief Stops the motion immediately.
+ *
+ * Has to be called before a widget with a kinetic state is freed.
+ *
+ * @self A kinetic scrolling state.
+ */
+void gp_widget_kinetic_stop(gp_widget_kinetic *self);
+
+/**
+ * @brief Sets the frame rate the moving widgets are updated with.
+ *
+ * The frame period is also the frame budget, frames that take longer are
+ * counted as late, see gp_widget_kinetic_stats.
+ *
+ * @fps A frame rate in frames per second, 60 by default.
+ */
+void gp_widget_kinetic_rate_set(unsigned int fps);
+
+/**
+ * @brief Called by the render loop after the layout has been rendered.
+ *
+ * Finishes the frame time measurement if a frame was started.
+ */
+void gp_widget_kinetic_frame_end(void);
+
+typedef struct gp_widget_kinetic_stats {
+	/* number of frames so far */
+	unsigned long frames;
+	/* number of frames that took longer than the frame period */
+	unsigned long frames_late;
+	/* time from the frame timer expiration to the end of rendering in us */
+	unsigned int last_frame_us;
+	unsigned int max_frame_us;
+	unsigned long long sum_frame_us;
+} gp_widget_kinetic_stats;
+
+/**
+ * @brief Returns kinetic scrolling frame statistics.
+ *
+ * @return Kinetic scrolling frame statistics.
+ */
+const gp_widget_kinetic_stats *gp_widget_kinetic_stats_get(void);
+
+#endif /* GP_WIDGET_KINETIC_H__ */
@@ -20,6 +20,10 @@ struct gp_widget_label {
 	unsigned int bold:1;
 	unsigned int ralign:1;
 	unsigned int frame:1;
+	/* cached text width */
+	gp_text_cache width_cache;
+	/* cached rendered label */
+	gp_widget_surface_cache surface;
 };
 
 /**
@@ -49,7 +53,9 @@ static inline void gp_widget_label_bold(gp_widget *self, int bold)
 
 	self->label->bold = bold;
 
+	gp_widget_surface_cache_invalidate(&self->label->surface);
 	gp_widget_redraw(self);
+	gp_text_cache_invalidate(&self->label->width_cache);
 }
 
 /**
@@ -61,6 +67,7 @@ static inline void gp_widget_label_bold(gp_widget *self, int bold)
 static inline void gp_widget_label_set_width(gp_widget *self, unsigned int width)
 {
 	self->label->width = width;
+	gp_text_cache_invalidate(&self->label->width_cache);
 	gp_widget_resize(self);
 }
 
@@ -0,0 +1,130 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Virtualized list, a scrollable list of items where only items that are
+ * visible exist as widgets.
+ *
+ * Item widgets are created by the model and bound to the item indexes as the
+ * list scrolls, items that were scrolled out of the view are kept and bound
+ * again to the items scrolled into the view. Only the bound items are
+ * measured and laid out, the height of the items that are not bound is
+ * estimated from the heights measured so far.
+ */
+
+#ifndef GP_WIDGET_LIST_H__
+#define GP_WIDGET_LIST_H__
+
+typedef struct gp_widget_list_model {
+	/* returns number of items in the list */
+	unsigned int (*item_cnt)(struct gp_widget *self);
+	/* creates a new item widget */
+	struct gp_widget *(*item_new)(struct gp_widget *self);
+	/* updates an item widget to show an item at index */
+	void (*item_set)(struct gp_widget *self, struct gp_widget *item,
+	                 unsigned int idx);
+} gp_widget_list_model;
+
+typedef struct gp_widget_list_item {
+	struct gp_widget *widget;
+	/* item offset relative to the top of the visible area */
+	gp_coord y;
+} gp_widget_list_item;
+
+struct gp_widget_list {
+	const gp_widget_list_model *model;
+
+	/* minimal size of the visible area */
+	gp_size min_w;
+	gp_size min_h;
+
+	/* estimated offset of the visible area in the list */
+	gp_coord y_off;
+
+	/* Internal do not touch */
+	unsigned int item_cnt;
+
+	/* estimated item height and the sum of measured heights */
+	gp_size est_h;
+	unsigned long est_sum;
+	unsigned int est_cnt;
+
+	/* widest item measured so far */
+	gp_size items_w;
+
+	/* items bound to first ... first + bound_cnt - 1 */
+	unsigned int first;
+	unsigned int bound_cnt;
+	gp_widget_list_item *bound;
+	/* bound items are swapped with tmp on each layout */
+	gp_widget_list_item *tmp;
+	unsigned int items_size;
+
+	/* items ready to be bound again */
+	unsigned int pool_cnt;
+	unsigned int pool_size;
+	struct gp_widget **pool;
+
+	struct gp_widget *focused;
+
+	int area_focused:1;
+
+	void *priv;
+};
+
+/**
+ * @brief Allocate and initialize a list widget.
+ *
+ * @min_w Minimal width of the visible area.
+ * @min_h Minimal height of the visible area.
+ * @model A list model, has to stay valid while the list exists.
+ * @priv A user private pointer.
+ *
+ * @return A list widget.
+ */
+gp_widget *gp_widget_list_new(gp_size min_w, gp_size min_h,
+                              const gp_widget_list_model *model, void *priv);
+
+/**
+ * @brief Updates the list after the items has changed.
+ *
+ * Number of items is queried again and all visible items are set again.
+ *
+ * @self A list widget.
+ */
+void gp_widget_list_refresh(gp_widget *self);
+
+/**
+ * @brief Updates a single item after it has changed.
+ *
+ * Does nothing if the item is not visible.
+ *
+ * @self A list widget.
+ * @idx An item index.
+ */
+void gp_widget_list_item_refresh(gp_widget *self, unsigned int idx);
+
+/**
+ * @brief Scrolls the list so that an item is visible.
+ *
+ * @self A list widget.
+ * @idx An item index.
+ */
+void gp_widget_list_show(gp_widget *self, unsigned int idx);
+
+/**
+ * @brief Moves the visible area of the list.
+ *
+ * @self A list widget.
+ * @y_off A relative offset in pixels.
+ *
+ * @return Returns non-zero if the list was moved zero otherwise.
+ */
+int gp_widget_list_move(gp_widget *self, gp_coord y_off);
+
+#endif /* GP_WIDGET_LIST_H__ */
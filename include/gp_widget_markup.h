@@ -30,6 +30,10 @@ struct gp_widget_markup {
 	char *text;
 	char *(*get)(unsigned int var_id, char *old_val);
 	struct gp_markup *markup;
+	/* cached widths, one for each markup element */
+	gp_text_cache *widths;
+	/* cached rendered markup */
+	gp_widget_surface_cache surface;
 };
 
 /**
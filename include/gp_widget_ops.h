@@ -25,7 +25,7 @@ enum gp_widget_focus_flag {
 	GP_FOCUS_PREV,
 };
 
-struct json_object;
+struct gp_bjson;
 
 typedef struct gp_offset {
 	gp_coord x;
@@ -38,6 +38,10 @@ enum gp_widget_render_flags {
 };
 
 struct gp_widget_ops {
+	/*
+	 * Frees resources owned by the widget payload, children and the
+	 * widget itself are freed by gp_widget_free().
+	 */
 	void (*free)(gp_widget *self);
 
 	/**
@@ -87,10 +91,26 @@ struct gp_widget_ops {
 	                        const gp_widget_render_ctx *ctx,
 	                        int new_wh);
 
+	/**
+	 * @brief Calls a function for each child widget.
+	 *
+	 * Implemented only for non-leaf widgets, empty slots are skipped.
+	 *
+	 * @self A widget container.
+	 * @func A function to call for each child.
+	 * @priv A pointer passed down to the function.
+	 */
+	void (*for_each_child)(gp_widget *self,
+	                       void (*func)(gp_widget *child, void *priv),
+	                       void *priv);
+
 	/*
-	 * json_object -> widget converter.
+	 * JSON object -> widget converter.
+	 *
+	 * The object is passed as a binary JSON node, common widget keys
+	 * should be skipped with gp_widget_json_foreach().
 	 */
-	gp_widget *(*from_json)(struct json_object *json, void **uids);
+	gp_widget *(*from_json)(const struct gp_bjson *json, void **uids);
 
 	/* id used for debugging */
 	const char *id;
@@ -104,6 +124,11 @@ const char *gp_widget_type_id(gp_widget *self);
 
 const char *gp_widget_type_name(enum gp_widget_type type);
 
+/**
+ * @brief Frees a widget and all its children.
+ *
+ * @self A widget, may be NULL.
+ */
 void gp_widget_free(gp_widget *self);
 
 unsigned int gp_widget_min_w(gp_widget *self, const gp_widget_render_ctx *ctx);
@@ -117,6 +142,26 @@ int gp_widget_input_event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_e
 void gp_widget_ops_render(gp_widget *self, const gp_offset *offset,
                           const gp_widget_render_ctx *ctx, int flags);
 
+/**
+ * @brief Renders a widget clipped to a rectangle.
+ *
+ * The widget is rendered into a subpixmap of the rectangle intersected with
+ * the ctx->bbox, nothing is rendered if they do not intersect. Used by
+ * containers whose children may not fit into them, e.g. scroll area.
+ *
+ * @self A widget to render.
+ * @offset A widget offset relative to the rectangle top left corner.
+ * @ctx A render context.
+ * @flags Render flags.
+ * @rect A rectangle in the ctx->buf coordinates.
+ * @blit_damage If set the widget damage is clipped to the rectangle and added
+ *              to the ctx->flip, should be unset when the caller blits the
+ *              whole rectangle anyway.
+ */
+void gp_widget_ops_render_clip(gp_widget *self, const gp_offset *offset,
+                               const gp_widget_render_ctx *ctx, int flags,
+                               gp_bbox rect, int blit_damage);
+
 /*
  * Send event to a widget.
  *
@@ -171,6 +216,19 @@ int gp_widget_ops_render_focus_xy(gp_widget *self, const gp_widget_render_ctx *c
 void gp_widget_ops_distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx,
                                    unsigned int w, unsigned int h, int new_wh);
 
+/**
+ * @brief Calls a function for each widget child.
+ *
+ * Does nothing for leaf widgets.
+ *
+ * @self A widget.
+ * @func A function to call for each child.
+ * @priv A pointer passed down to the function.
+ */
+void gp_widget_ops_for_each_child(gp_widget *self,
+                                  void (*func)(gp_widget *child, void *priv),
+                                  void *priv);
+
 
 /**
  * @brief Marks an area to be blit on the screen from a buffer.
@@ -186,10 +244,45 @@ static inline void gp_widget_ops_blit(const gp_widget_render_ctx *ctx,
 	if (!ctx->flip)
 		return;
 
-	if (gp_bbox_empty(*ctx->flip))
-		*ctx->flip = gp_bbox_pack(x, y, w, h);
-	else
-		*ctx->flip = gp_bbox_merge(*ctx->flip, gp_bbox_pack(x, y, w, h));
+	gp_widget_damage_add(ctx->flip, gp_bbox_pack(x, y, w, h));
+}
+
+/**
+ * @brief Blits a part of a surface into the render buffer.
+ *
+ * The rectangle is clipped to the buffer and the ctx->bbox, since a widget
+ * may be only partially visible, e.g. when rendered into a sub-pixmap.
+ *
+ * @ctx A render context.
+ * @surface A surface to blit from.
+ * @x A surface x coordinate in ctx->buf.
+ * @y A surface y coordinate in ctx->buf.
+ * @rect A rectangle to blit in the surface coordinates.
+ *
+ * @return The area that has been blit in the buffer coordinates, empty if the
+ *         rectangle was clipped out.
+ */
+gp_bbox gp_widget_ops_surface_blit(const gp_widget_render_ctx *ctx,
+                                   const gp_pixmap *surface,
+                                   gp_coord x, gp_coord y, gp_bbox rect);
+
+/**
+ * @brief Returns true if a rectangle can be scrolled by moving its pixels.
+ *
+ * The rectangle has to be inside of the buffer and the ctx->bbox since pixels
+ * outside of the bbox may have not been rendered at all.
+ */
+static inline int gp_widget_ops_can_move(const gp_widget_render_ctx *ctx,
+                                         gp_coord x, gp_coord y,
+                                         gp_size w, gp_size h)
+{
+	gp_bbox rect = gp_bbox_pack(x, y, w, h);
+	gp_bbox buf = gp_bbox_pack(0, 0, gp_pixmap_w(ctx->buf), gp_pixmap_h(ctx->buf));
+
+	if (!gp_bbox_contains(buf, rect))
+		return 0;
+
+	return !ctx->bbox || gp_bbox_contains(*ctx->bbox, rect);
 }
 
 /**
@@ -220,6 +313,32 @@ static inline int gp_widget_should_redraw(gp_widget *self, int flags)
 void gp_widget_calc_size(gp_widget *layout, const gp_widget_render_ctx *ctx,
                          unsigned int w, unsigned int h, int new_wh);
 
+typedef struct gp_widget_layout_stats {
+	/* layout generation, increased on each gp_widget_resize() */
+	unsigned int gen;
+	/* number of gp_widget_calc_size() calls that recalculated the layout */
+	unsigned long relayouts;
+	/* number of widgets measured, i.e. min_w() and min_h() called, so far */
+	unsigned long measure_calls;
+	/* number of widgets measured in last layout recalculation */
+	unsigned int last_measure_calls;
+	/* number of containers whose children were placed, so far */
+	unsigned long distribute_calls;
+	/* number of containers whose children were placed in last recalculation */
+	unsigned int last_distribute_calls;
+} gp_widget_layout_stats;
+
+/**
+ * @brief Returns layout statistics.
+ *
+ * Each widget minimal size is measured at most once per layout generation,
+ * the counters can be used to check how much of the layout was measured on
+ * an update.
+ *
+ * @return Layout statistics.
+ */
+const gp_widget_layout_stats *gp_widget_layout_stats_get(void);
+
 /**
  * @brief Redraw widget.
  *
@@ -235,10 +354,25 @@ void gp_widget_redraw(gp_widget *self);
  * Marks widget to be resized on next update. The resize is propagated in the
  * layout to the top. E.g. if widget has to grow, the whole layout will.
  *
+ * The layout update is incremental, widgets are placed again only in the
+ * containers whose size or position has changed or whose children minimal
+ * sizes have changed, the rest of the layout is left untouched.
+ *
  * @self A widget.
  */
 void gp_widget_resize(gp_widget *self);
 
+/**
+ * @brief Resize whole widget subtree.
+ *
+ * Marks widget and all its children to be resized on next update, i.e. all
+ * minimal sizes in the subtree are recalculated. This is needed when
+ * parameters that affect all widgets, such as fonts, were changed.
+ *
+ * @self A widget.
+ */
+void gp_widget_resize_subtree(gp_widget *self);
+
 /**
  * @brief Redraw all child widgets.
  *
@@ -249,6 +383,22 @@ void gp_widget_resize(gp_widget *self);
  */
 void gp_widget_redraw_children(gp_widget *self);
 
+/**
+ * @brief Enables or disables retained rendering for a widget subtree.
+ *
+ * Retained widget renders its whole subtree into a private surface once, when
+ * parent is repainted the surface is blit instead and only the descendants
+ * that were marked for redraw are rendered again.
+ *
+ * The surfaces are allocated from the widget surface cache, i.e. retained
+ * rendering is active only if the cache budget is set and the surface fits
+ * into it.
+ *
+ * @self A widget, usually a container.
+ * @retain Non-zero to enable, zero to disable retained rendering.
+ */
+void gp_widget_retain(gp_widget *self, int retain);
+
 /*
  * Resizes and redraws changed widgets.
  */
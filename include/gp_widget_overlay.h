@@ -17,6 +17,8 @@
 struct gp_widget_overlay_elem {
 	int hidden:1;
 	struct gp_widget *widget;
+	/* deferred hidden widget, loaded on gp_widget_overlay_show() */
+	struct gp_widget_lazy *lazy;
 };
 
 struct gp_widget_overlay {
@@ -0,0 +1,89 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Layout hot reload.
+ *
+ * A reloaded layout is compared with the layout it was loaded from and only
+ * the parts that differ are changed. Widgets are matched by their position in
+ * the layout, type and uid. A matching widget is kept along with its state.
+ * If only the common keys (align, on_event, retain) differ, they are updated
+ * in place. If the widget specific keys differ, the widget and its subtree
+ * are created again. The children of a matching container are compared the
+ * same way.
+ *
+ * Layouts changed by the application at runtime, e.g. by adding grid rows,
+ * may not be patched correctly.
+ */
+
+#ifndef GP_WIDGET_RELOAD_H__
+#define GP_WIDGET_RELOAD_H__
+
+#include <gp_widget.h>
+#include <gp_bjson.h>
+
+typedef struct gp_widget_reload_stats {
+	/* number of widgets and deferred widgets kept in place */
+	unsigned int kept;
+	/* number of widgets whose common keys were updated */
+	unsigned int patched;
+	/* number of subtrees created again */
+	unsigned int rebuilt;
+} gp_widget_reload_stats;
+
+/**
+ * @brief Patches a layout to match a new layout description.
+ *
+ * @layout A layout loaded from old.
+ * @old A binary JSON the layout was loaded from.
+ * @new A new binary JSON layout description.
+ * @uids A pointer to the hash table with widget pointers by UIDs, the UIDs of
+ *       widgets that were freed are removed and the new ones are added.
+ * @stats Optional pointer to store the statistics to.
+ *
+ * @return The patched layout, which is either the layout that was passed or a
+ *         new layout if the root widget had to be created again, in which case
+ *         the old layout is freed. NULL is returned if any of the widgets
+ *         failed to be created, the layout is left untouched in that case.
+ */
+gp_widget *gp_widget_layout_patch(gp_widget *layout, const gp_bjson *old,
+                                  const gp_bjson *new, void **uids,
+                                  gp_widget_reload_stats *stats);
+
+/**
+ * @brief Loads a JSON layout and reloads it whenever the file changes.
+ *
+ * The file is watched with inotify and changes are applied to the layout by
+ * gp_widget_layout_patch() from gp_widgets_main_loop(). If the root widget
+ * has to be created again, the application layout is swapped by
+ * gp_widget_layout_replace(). A file that fails to parse or a layout that
+ * fails to be created is ignored and the layout is kept.
+ *
+ * This is meant for layout development, the layout should be passed to
+ * gp_widgets_main_loop() and the application should not keep pointers to the
+ * widgets in the layout other than the ones looked up by uids.
+ *
+ * @path A path to a JSON layout file.
+ * @uids A pointer to a hash table to store widget pointers by UIDs, has to stay
+ *       valid as long as the application runs.
+ *
+ * @return A widget layout or a NULL in case of a failure.
+ */
+gp_widget *gp_widget_layout_json_watch(const char *path, void **uids);
+
+/**
+ * @brief Stops reloading a layout and releases the file watch.
+ *
+ * The layout itself is not freed.
+ *
+ * @layout A layout returned by gp_widget_layout_json_watch() or the layout
+ *         that replaced it after a reload.
+ */
+void gp_widget_layout_unwatch(gp_widget *layout);
+
+#endif /* GP_WIDGET_RELOAD_H__ */
@@ -16,6 +16,7 @@
 
 #include <gp_widget.h>
 #include <gp_bbox.h>
+#include <gp_widget_damage.h>
 
 typedef struct gp_widget_render_ctx {
 	/* colors */
@@ -39,8 +40,8 @@ typedef struct gp_widget_render_ctx {
 	/* padding between widgets */
 	unsigned int padd;
 
-	/* area to update on a screen after a call to gp_widget_render() */
-	gp_bbox *flip;
+	/* areas to update on a screen after a call to gp_widget_render() */
+	gp_widget_damage *flip;
 
 	/* passed down if only part of the layout has to be rendered */
 	gp_bbox *bbox;
@@ -63,9 +64,61 @@ enum gp_widget_render_timer_flags {
 
 extern struct gp_fds *gp_widgets_fds;
 
+/**
+ * @brief Schedules a widget timer.
+ *
+ * Each widget has a single timer, allocated on first use, that is inserted
+ * directly into the backend timer queue. Once the timer expires the widget
+ * event() callback is called with a GP_EV_TMR event.
+ *
+ * @self A widget.
+ * @flags If GP_TIMER_RESCHEDULE is set running timer is rescheduled,
+ *        otherwise scheduling a running timer is an error.
+ * @timeout_ms A timeout in miliseconds.
+ */
 void gp_widget_render_timer(gp_widget *self, int flags, unsigned int timeout_ms);
+
+/**
+ * @brief Cancels a widget timer, does nothing if timer is not running.
+ *
+ * @self A widget.
+ */
 void gp_widget_render_timer_cancel(gp_widget *self);
 
+/**
+ * @brief Initializes rendering into an offscreen pixmap.
+ *
+ * Sets up fonts and colors for rendering into a pixmap in memory instead of a
+ * backend, which allows to render layouts on a machine without display, e.g.
+ * for benchmarks. Must not be combined with gp_widgets_layout_init().
+ *
+ * @pixel_type A pixel type of the offscreen pixmap.
+ *
+ * @return A render context or NULL on a failure.
+ */
+const gp_widget_render_ctx *gp_widgets_offscreen_init(gp_pixel_type pixel_type);
+
+/**
+ * @brief Renders a layout into the offscreen pixmap.
+ *
+ * This is an offscreen counterpart to gp_widgets_redraw(), the layout is
+ * recalculated if needed and changed widgets are rendered. The pixmap is
+ * reallocated to match the layout size when it changes.
+ *
+ * @layout A widget layout.
+ * @damage An optional damage list, filled in with the repainted areas.
+ * @new_wh Forces layout size recalculation and full repaint.
+ *
+ * @return The offscreen pixmap or NULL on a failure.
+ */
+gp_pixmap *gp_widgets_offscreen_render(gp_widget *layout,
+                                       gp_widget_damage *damage, int new_wh);
+
+/**
+ * @brief Frees the offscreen pixmap.
+ */
+void gp_widgets_offscreen_exit(void);
+
 /**
  * @brief Returns a pointer to the current render context.
  *
@@ -125,11 +178,32 @@ void gp_widgets_redraw(gp_widget *layout);
  */
 int gp_widgets_process_events(gp_widget *layout);
 
+/**
+ * @brief Returns number of input events merged so far.
+ *
+ * Input events are processed in batches, consecutive relative pointer motions
+ * are merged into one and only the last resize event in a batch is processed.
+ *
+ * @return Number of events that were merged or dropped.
+ */
+unsigned long gp_widgets_events_merged(void);
+
 /*
  * TODO: Obsolete?
  */
 void gp_widgets_layout_init(gp_widget *layout, const char *win_tittle);
 
+/**
+ * @brief Sets up damage list used by gp_widgets_redraw().
+ *
+ * The damaged areas are merged into at most max_rects rectangles, rectangles
+ * closer than merge_dist pixels are merged together.
+ *
+ * @max_rects Maximal number of rectangles updated on the screen on a redraw.
+ * @merge_dist Distance in pixels.
+ */
+void gp_widgets_damage_set(unsigned int max_rects, gp_size merge_dist);
+
 /**
  * @brief Increases/decreases font sizes, etc.
  *
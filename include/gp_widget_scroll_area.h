@@ -9,6 +9,8 @@
 #ifndef GP_WIDGET_SCROLL_AREA_H__
 #define GP_WIDGET_SCROLL_AREA_H__
 
+#include <gp_widget_kinetic.h>
+
 struct gp_widget_scroll_area {
 	/* offset for the layout inside */
 	gp_coord x_off;
@@ -26,6 +28,15 @@ struct gp_widget_scroll_area {
 	int scrollbar_y:1;
 	int area_focused:1;
 	int child_focused:1;
+	/* offsets changed since last render, content can be moved */
+	int scrolled:1;
+
+	/* offsets the content was rendered with */
+	gp_coord rendered_x_off;
+	gp_coord rendered_y_off;
+
+	/* drag, fling and wheel scrolling */
+	gp_widget_kinetic kinetic;
 
 	gp_widget *child;
 };
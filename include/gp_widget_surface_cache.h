@@ -0,0 +1,149 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Widget surface cache.
+ *
+ * Widgets that rarely change can keep their rendered pixels in a pixmap and
+ * repaint themselves with a single blit. All cached surfaces share a global
+ * memory budget, when the budget is exceeded the least recently used surfaces
+ * are freed.
+ *
+ * The cache is disabled until a non-zero budget is set. Cached surfaces are
+ * invalidated on size or pixel type change, whenever fonts or colors change,
+ * and explicitly by the widget when its content changes.
+ */
+
+#ifndef GP_WIDGET_SURFACE_CACHE_H__
+#define GP_WIDGET_SURFACE_CACHE_H__
+
+#include <stddef.h>
+#include <gp_widget_render.h>
+
+typedef struct gp_widget_surface_cache {
+	gp_pixmap *pixmap;
+	/* LRU list, most recently used first */
+	struct gp_widget_surface_cache *prev;
+	struct gp_widget_surface_cache *next;
+	/* cache generation the surface was rendered in, zero if invalid */
+	unsigned int gen;
+} gp_widget_surface_cache;
+
+typedef struct gp_widget_surface_cache_stats {
+	/* memory budget in bytes, zero if disabled */
+	size_t budget;
+	/* memory used by cached surfaces in bytes */
+	size_t used;
+	unsigned int surfaces;
+	/* current cache generation, never zero */
+	unsigned int gen;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long evictions;
+} gp_widget_surface_cache_stats;
+
+/**
+ * @brief Returns a valid cached surface.
+ *
+ * @self A surface cache.
+ * @ctx A render context.
+ * @w A widget width.
+ * @h A widget height.
+ *
+ * @return A pixmap with the widget content or NULL if there is none.
+ */
+gp_pixmap *gp_widget_surface_cache_get(gp_widget_surface_cache *self,
+                                       const gp_widget_render_ctx *ctx,
+                                       gp_size w, gp_size h);
+
+/**
+ * @brief Allocates a surface to render the widget into.
+ *
+ * The surface is considered valid once this function returns, caller is
+ * expected to render the widget content into it.
+ *
+ * @self A surface cache.
+ * @ctx A render context.
+ * @w A widget width.
+ * @h A widget height.
+ *
+ * @return A pixmap or NULL if cache is disabled, the surface does not fit
+ *         into the budget or allocation has failed.
+ */
+gp_pixmap *gp_widget_surface_cache_alloc(gp_widget_surface_cache *self,
+                                         const gp_widget_render_ctx *ctx,
+                                         gp_size w, gp_size h);
+
+/**
+ * @brief Renders a widget through the cache.
+ *
+ * Blits the cached surface if valid, otherwise calls draw() to render the
+ * widget content into a new surface, or directly into the ctx->buf if the
+ * surface could not be cached.
+ *
+ * @self A surface cache.
+ * @widget A widget to render.
+ * @ctx A render context.
+ * @x A widget x coordinate in ctx->buf.
+ * @y A widget y coordinate in ctx->buf.
+ * @draw A function that draws the widget into buf at x, y.
+ */
+void gp_widget_surface_cache_render(gp_widget_surface_cache *self,
+                                    gp_widget *widget,
+                                    const gp_widget_render_ctx *ctx,
+                                    gp_coord x, gp_coord y,
+                                    void (*draw)(gp_widget *widget,
+                                                 const gp_widget_render_ctx *ctx,
+                                                 gp_pixmap *buf,
+                                                 gp_coord x, gp_coord y));
+
+/**
+ * @brief Invalidates a cached surface.
+ *
+ * Has to be called when the widget content has changed.
+ *
+ * @self A surface cache.
+ */
+static inline void gp_widget_surface_cache_invalidate(gp_widget_surface_cache *self)
+{
+	self->gen = 0;
+}
+
+/**
+ * @brief Frees a cached surface.
+ *
+ * Has to be called when the widget is freed.
+ *
+ * @self A surface cache.
+ */
+void gp_widget_surface_cache_free(gp_widget_surface_cache *self);
+
+/**
+ * @brief Invalidates all cached surfaces.
+ *
+ * Has to be called when fonts or colors are changed.
+ */
+void gp_widget_surface_cache_flush(void);
+
+/**
+ * @brief Sets the cache memory budget.
+ *
+ * Least recently used surfaces are freed until the cache fits the budget.
+ *
+ * @budget A memory budget in bytes, zero disables the cache.
+ */
+void gp_widget_surface_cache_budget_set(size_t budget);
+
+/**
+ * @brief Returns surface cache statistics.
+ *
+ * @return Cache usage, hit, miss and eviction counters.
+ */
+const gp_widget_surface_cache_stats *gp_widget_surface_cache_stats_get(void);
+
+#endif /* GP_WIDGET_SURFACE_CACHE_H__ */
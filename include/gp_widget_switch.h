@@ -11,6 +11,8 @@
 struct gp_widget_switch {
 	unsigned int active_layout;
 	gp_widget **layouts;
+	/* deferred layouts, NULL unless loaded with "lazy" */
+	struct gp_widget_lazy **lazy;
 };
 
 /**
@@ -9,6 +9,11 @@
 #ifndef GP_WIDGET_TABLE_H__
 #define GP_WIDGET_TABLE_H__
 
+#include <gp_widget_kinetic.h>
+
+/* maximal number of rows repainted separately, more rows repaint the body */
+#define GP_WIDGET_TABLE_DIRTY_ROWS 8
+
 enum gp_widget_table_row_op {
 	GP_TABLE_ROW_RESET,
 	GP_TABLE_ROW_ADVANCE,
@@ -20,6 +25,21 @@ typedef struct gp_widget_table_header {
 	int sortable:1;
 } gp_widget_table_header;
 
+/*
+ * Random access table model, an alternative to the row iterator.
+ *
+ * With the model rendering a table takes time proportional to the number of
+ * visible rows rather than to the number of rows in the table.
+ */
+typedef struct gp_widget_table_model {
+	/* returns number of rows in the table */
+	unsigned int (*row_cnt)(struct gp_widget *self);
+	/* optional, called before cells of a row are fetched */
+	void (*seek_row)(struct gp_widget *self, unsigned int row);
+	/* returns a cell text */
+	const char *(*get_cell)(struct gp_widget *self, unsigned int row, unsigned int col);
+} gp_widget_table_model;
+
 typedef struct gp_widget_table {
 	unsigned int cols;
 	unsigned int min_rows;
@@ -36,9 +56,31 @@ typedef struct gp_widget_table {
 
 	unsigned int start_row;
 	unsigned int last_max_row;
+	/* start_row the table was last rendered with */
+	unsigned int rendered_start_row;
+
+	/* parts to be repainted when only a partial redraw is needed */
+	unsigned int dirty_rows[GP_WIDGET_TABLE_DIRTY_ROWS];
+	unsigned int dirty_cnt;
+	unsigned int dirty_header:1;
+	unsigned int dirty_body:1;
+	/* start_row has changed since last render */
+	unsigned int dirty_scroll:1;
+	/* set if only the dirty parts changed since last render */
+	unsigned int partial:1;
+	/* the widget focus the table was last rendered with */
+	unsigned int rendered_focused:1;
+
+	/* drag, fling and wheel scrolling */
+	gp_widget_kinetic kinetic;
+	/* scrolled distance in pixels not yet applied as whole rows */
+	gp_coord kinetic_rem;
 
 	unsigned int *cols_w;
 
+	/* cached header text widths */
+	gp_text_cache *header_widths;
+
 	void *priv;
 
 	/* iterator based API */
@@ -49,6 +91,16 @@ typedef struct gp_widget_table {
 	int (*row)(struct gp_widget *self, int op, unsigned int pos);
 	const char *(*get)(struct gp_widget *self, unsigned int col);
 
+	/* random access API, used instead of the iterator if set */
+	const gp_widget_table_model *model;
+	/* row the iterator or the model points to during rendering */
+	unsigned int iter_row;
+	/* the iterator has to be reset before it's used */
+	unsigned int iter_reset:1;
+
+	/* optional cell cache, see gp_widget_table_cache() */
+	struct gp_widget_table_cache *cache;
+
 	void (*sort)(struct gp_widget *self, unsigned int col, int desc);
 
 	char buf[];
@@ -61,9 +113,47 @@ gp_widget *gp_widget_table_new(unsigned int cols, unsigned int min_rows,
                                const char *(get)(struct gp_widget *self,
                                                  unsigned int col));
 
+/**
+ * @brief Creates a table with a random access model.
+ *
+ * @cols Number of columns.
+ * @min_rows Minimal number of visible rows.
+ * @headers Optional column headers.
+ * @model A table model, has to stay valid while the table exists.
+ *
+ * @return A table widget or NULL in a case of a failure.
+ */
+gp_widget *gp_widget_table_model_new(unsigned int cols, unsigned int min_rows,
+                                     const gp_widget_table_header *headers,
+                                     const gp_widget_table_model *model);
+
+/**
+ * @brief Enables or disables the cell cache.
+ *
+ * The cache stores texts and text widths of the rendered rows, so that
+ * repaints that do not change the data, e.g. after the focused row has moved,
+ * do not call the row and get callbacks. Cached rows are dropped by
+ * gp_widget_table_row_refresh(), gp_widget_table_refresh() and sorting.
+ *
+ * @self A table widget.
+ * @cache Non-zero to enable the cache, zero to disable and free it.
+ */
+void gp_widget_table_cache(gp_widget *self, int cache);
+
 /*
  * Called when table content has changed and table needs to be rerendered.
  */
 void gp_widget_table_refresh(gp_widget *self);
 
+/*
+ * Called when a single row has changed, only the row is repainted.
+ */
+void gp_widget_table_row_refresh(gp_widget *self, unsigned int row);
+
+/*
+ * Called when header labels or the sort order have changed, the header labels
+ * are measured again and the header is repainted.
+ */
+void gp_widget_table_header_refresh(gp_widget *self);
+
 #endif /* GP_WIDGET_TABLE_H__ */
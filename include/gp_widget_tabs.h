@@ -18,6 +18,10 @@ struct gp_widget_tabs {
 
 	char **labels;
 	struct gp_widget **widgets;
+	/* deferred tab widgets, NULL unless loaded with "lazy" */
+	struct gp_widget_lazy **lazy;
+	/* cached label widths */
+	gp_text_cache *label_widths;
 
 	char payload[];
 };
@@ -46,4 +50,12 @@ gp_widget *gp_widget_tabs_new(unsigned int tabs, unsigned int active_tab,
 gp_widget *gp_widget_tabs_put(gp_widget *self, unsigned int tab,
                               gp_widget *child);
 
+/**
+ * @brief Switches the active tab.
+ *
+ * @self A tabs widget.
+ * @tab Index of the tab to activate.
+ */
+void gp_widget_tabs_set_active(gp_widget *self, unsigned int tab);
+
 #endif /* GP_WIDGET_TABS_H__ */
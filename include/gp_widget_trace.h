@@ -0,0 +1,108 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Widget trace is an opt-in fixed size ring buffer of binary records of input
+ * events, widget events and render phases. Once the buffer is full the oldest
+ * records are overwritten.
+ *
+ * Tracing is disabled until gp_widget_trace_init() is called, a disabled
+ * trace point is just a single branch.
+ */
+
+#ifndef GP_WIDGET_TRACE_H__
+#define GP_WIDGET_TRACE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+enum gp_widget_trace_type {
+	/* sub = input event type, code = event code, val = event value */
+	GP_WIDGET_TRACE_INPUT,
+	/* ptr = widget, code = widget event type, val = widget type */
+	GP_WIDGET_TRACE_EVENT,
+	/* ptr = layout, sub = GP_WIDGET_TRACE_START or GP_WIDGET_TRACE_END */
+	GP_WIDGET_TRACE_LAYOUT,
+	/* ptr = layout, sub = GP_WIDGET_TRACE_START or GP_WIDGET_TRACE_END */
+	GP_WIDGET_TRACE_RENDER,
+	/* val = number of rectangles updated on the screen */
+	GP_WIDGET_TRACE_FLIP,
+	/* val = kinetic scrolling frame time in us */
+	GP_WIDGET_TRACE_FRAME,
+	GP_WIDGET_TRACE_MAX,
+};
+
+enum gp_widget_trace_phase {
+	GP_WIDGET_TRACE_START,
+	GP_WIDGET_TRACE_END,
+};
+
+typedef struct gp_widget_trace_rec {
+	/* monotonic time stamp in ns */
+	uint64_t ts;
+	const void *ptr;
+	uint8_t type;
+	uint8_t sub;
+	uint16_t code;
+	int32_t val;
+} gp_widget_trace_rec;
+
+struct gp_widget_trace {
+	gp_widget_trace_rec *recs;
+	/* ring buffer size, power of two */
+	unsigned int size;
+	/* next record position, modulo size */
+	unsigned long pos;
+};
+
+extern struct gp_widget_trace gp_widget_trace_buf;
+
+void gp_widget_trace_rec_add(uint8_t type, uint8_t sub, uint16_t code,
+                             int32_t val, const void *ptr);
+
+/**
+ * @brief Adds a record to the trace buffer if tracing is enabled.
+ *
+ * @type A gp_widget_trace_type.
+ * @sub A record subtype.
+ * @code A record code.
+ * @val A record value.
+ * @ptr A widget pointer, may be NULL.
+ */
+static inline void gp_widget_trace(uint8_t type, uint8_t sub, uint16_t code,
+                                   int32_t val, const void *ptr)
+{
+	if (__builtin_expect(!gp_widget_trace_buf.recs, 1))
+		return;
+
+	gp_widget_trace_rec_add(type, sub, code, val, ptr);
+}
+
+/**
+ * @brief Enables tracing.
+ *
+ * @records A trace buffer size in records, rounded up to a power of two.
+ * @dump_on_exit If set the trace is dumped into stderr at the program exit.
+ *
+ * @return Zero on success, non-zero on allocation failure.
+ */
+int gp_widget_trace_init(unsigned int records, int dump_on_exit);
+
+/**
+ * @brief Disables tracing and frees the trace buffer.
+ */
+void gp_widget_trace_exit(void);
+
+/**
+ * @brief Prints the trace buffer, oldest records first.
+ *
+ * @f A file to print the trace to.
+ */
+void gp_widget_trace_dump(FILE *f);
+
+#endif /* GP_WIDGET_TRACE_H__ */
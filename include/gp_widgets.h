@@ -12,6 +12,8 @@
 #include <gp_widget_ops.h>
 #include "gp_widget.h"
 #include "gp_widget_render.h"
+#include <gp_text_cache.h>
+#include <gp_widget_surface_cache.h>
 #include <gp_widget_gfx.h>
 #include "gp_widget_grid.h"
 #include "gp_widget_tabs.h"
@@ -31,9 +33,14 @@
 #include <gp_widget_markup.h>
 #include <gp_widget_switch.h>
 #include <gp_widget_overlay.h>
+#include <gp_widget_list.h>
 
 #include <gp_widget_json.h>
+#include <gp_widget_arena.h>
+#include <gp_widget_reload.h>
 #include <gp_widget_timer.h>
+#include <gp_widget_kinetic.h>
+#include <gp_widget_trace.h>
 
 #include <utils/gp_htable.h>
 #include <gp_file_size.h>
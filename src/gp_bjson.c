@@ -0,0 +1,566 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <json-c/json.h>
+
+#include <core/gp_debug.h>
+#include <gp_bjson.h>
+
+const gp_bjson *gp_bjson_get(const gp_bjson *self, const char *key)
+{
+	if (!gp_bjson_is_type(self, GP_BJSON_OBJECT))
+		return NULL;
+
+	gp_bjson_foreach(self, mkey, val) {
+		if (!strcmp(mkey, key))
+			return val;
+	}
+
+	return NULL;
+}
+
+int gp_bjson_equal(const gp_bjson *a, const gp_bjson *b)
+{
+	const gp_bjson *ae, *be;
+	uint32_t i;
+
+	if (a == b)
+		return 1;
+
+	if (gp_bjson_type(a) != gp_bjson_type(b))
+		return 0;
+
+	switch (gp_bjson_type(a)) {
+	case GP_BJSON_NULL:
+		return 1;
+	case GP_BJSON_BOOL:
+	case GP_BJSON_INT:
+		return a->val.i == b->val.i;
+	case GP_BJSON_DOUBLE:
+		return !strcmp(gp_bjson_str(a), gp_bjson_str(b));
+	case GP_BJSON_STRING:
+		return a->len == b->len && !memcmp(gp_bjson_str(a), gp_bjson_str(b), a->len);
+	case GP_BJSON_ARRAY:
+	case GP_BJSON_OBJECT:
+	break;
+	}
+
+	if (a->len != b->len)
+		return 0;
+
+	ae = gp_bjson_first(a);
+	be = gp_bjson_first(b);
+
+	for (i = 0; i < a->len; i++) {
+		if (a->type == GP_BJSON_OBJECT &&
+		    strcmp(gp_bjson_key(&ae[i]), gp_bjson_key(&be[i])))
+			return 0;
+
+		if (!gp_bjson_equal(&ae[i], &be[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int clamp_int(int64_t val)
+{
+	if (val > INT_MAX)
+		return INT_MAX;
+
+	if (val < INT_MIN)
+		return INT_MIN;
+
+	return val;
+}
+
+int gp_bjson_int(const gp_bjson *self)
+{
+	switch (gp_bjson_type(self)) {
+	case GP_BJSON_BOOL:
+	case GP_BJSON_INT:
+		return clamp_int(self->val.i);
+	case GP_BJSON_DOUBLE:
+		if (self->val.d >= INT_MAX)
+			return INT_MAX;
+		if (self->val.d <= INT_MIN)
+			return INT_MIN;
+		return self->val.d;
+	case GP_BJSON_STRING:
+		return clamp_int(strtoll(gp_bjson_str(self), NULL, 10));
+	default:
+		return 0;
+	}
+}
+
+double gp_bjson_double(const gp_bjson *self)
+{
+	switch (gp_bjson_type(self)) {
+	case GP_BJSON_BOOL:
+	case GP_BJSON_INT:
+		return self->val.i;
+	case GP_BJSON_DOUBLE:
+		return self->val.d;
+	case GP_BJSON_STRING:
+		return strtod(gp_bjson_str(self), NULL);
+	default:
+		return 0;
+	}
+}
+
+int gp_bjson_bool(const gp_bjson *self)
+{
+	switch (gp_bjson_type(self)) {
+	case GP_BJSON_BOOL:
+	case GP_BJSON_INT:
+		return self->val.i != 0;
+	case GP_BJSON_DOUBLE:
+		return self->val.d != 0;
+	case GP_BJSON_STRING:
+		return self->len != 0;
+	default:
+		return 0;
+	}
+}
+
+struct compile {
+	/* next free node */
+	gp_bjson *node;
+	/* next free byte in the string table */
+	char *str;
+	size_t nodes;
+	size_t strs;
+};
+
+static void compile_count(struct compile *c, json_object *json)
+{
+	size_t i;
+
+	c->nodes++;
+
+	switch (json_object_get_type(json)) {
+	case json_type_null:
+	break;
+	case json_type_boolean:
+	case json_type_int:
+	case json_type_double:
+	case json_type_string:
+		c->strs += strlen(json_object_get_string(json)) + 1;
+	break;
+	case json_type_array:
+		for (i = 0; i < json_object_array_length(json); i++)
+			compile_count(c, json_object_array_get_idx(json, i));
+	break;
+	case json_type_object: {
+		json_object_object_foreach(json, key, val) {
+			c->strs += strlen(key) + 1;
+			compile_count(c, val);
+		}
+	} break;
+	}
+}
+
+static int32_t put_str(struct compile *c, gp_bjson *node, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	int32_t off = c->str - (char *)node;
+
+	memcpy(c->str, str, len);
+	c->str += len;
+
+	return off;
+}
+
+static gp_bjson *alloc_nodes(struct compile *c, gp_bjson *node, size_t cnt)
+{
+	gp_bjson *ret = c->node;
+
+	c->node += cnt;
+
+	node->len = cnt;
+	node->off = cnt ? (char *)ret - (char *)node : 0;
+
+	return ret;
+}
+
+static void compile_node(struct compile *c, gp_bjson *node, json_object *json)
+{
+	gp_bjson *elems;
+	size_t i;
+
+	switch (json_object_get_type(json)) {
+	case json_type_null:
+		node->type = GP_BJSON_NULL;
+	return;
+	case json_type_boolean:
+		node->type = GP_BJSON_BOOL;
+		node->val.i = !!json_object_get_boolean(json);
+	break;
+	case json_type_int:
+		node->type = GP_BJSON_INT;
+		node->val.i = json_object_get_int64(json);
+	break;
+	case json_type_double:
+		node->type = GP_BJSON_DOUBLE;
+		node->val.d = json_object_get_double(json);
+	break;
+	case json_type_string:
+		node->type = GP_BJSON_STRING;
+	break;
+	case json_type_array:
+		node->type = GP_BJSON_ARRAY;
+		elems = alloc_nodes(c, node, json_object_array_length(json));
+		for (i = 0; i < node->len; i++)
+			compile_node(c, &elems[i], json_object_array_get_idx(json, i));
+	return;
+	case json_type_object: {
+		node->type = GP_BJSON_OBJECT;
+		elems = alloc_nodes(c, node, json_object_object_length(json));
+		i = 0;
+		json_object_object_foreach(json, key, val) {
+			elems[i].key = put_str(c, &elems[i], key);
+			compile_node(c, &elems[i], val);
+			i++;
+		}
+	} return;
+	}
+
+	node->off = put_str(c, node, json_object_get_string(json));
+
+	if (node->type == GP_BJSON_STRING)
+		node->len = strlen((char *)node + node->off);
+}
+
+static gp_bjson_hdr *blob_alloc(struct compile *c)
+{
+	gp_bjson_hdr *hdr;
+	size_t size;
+
+	size = sizeof(*hdr) + c->nodes * sizeof(gp_bjson) + c->strs;
+
+	if (size > INT32_MAX) {
+		GP_WARN("Layout too big (%zu bytes)", size);
+		return NULL;
+	}
+
+	hdr = calloc(1, size);
+	if (!hdr) {
+		GP_WARN("Malloc failed :-(");
+		return NULL;
+	}
+
+	memcpy(hdr->magic, GP_BJSON_MAGIC, sizeof(hdr->magic));
+	hdr->version = GP_BJSON_VERSION;
+	hdr->byte_order = GP_BJSON_BYTE_ORDER;
+	hdr->size = size;
+	hdr->nodes = c->nodes;
+
+	gp_bjson *root = (gp_bjson *)(hdr + 1);
+
+	c->node = root + 1;
+	c->str = (char *)(root + c->nodes);
+
+	return hdr;
+}
+
+gp_bjson_hdr *gp_bjson_compile(json_object *json)
+{
+	struct compile c = {};
+	gp_bjson_hdr *hdr;
+
+	compile_count(&c, json);
+
+	hdr = blob_alloc(&c);
+	if (!hdr)
+		return NULL;
+
+	compile_node(&c, (gp_bjson *)gp_bjson_root(hdr), json);
+
+	GP_DEBUG(2, "Compiled %zu nodes %zu string bytes", c.nodes, c.strs);
+
+	return hdr;
+}
+
+static void dup_count(struct compile *c, const gp_bjson *node)
+{
+	c->nodes++;
+
+	switch (gp_bjson_type(node)) {
+	case GP_BJSON_NULL:
+	break;
+	case GP_BJSON_BOOL:
+	case GP_BJSON_INT:
+	case GP_BJSON_DOUBLE:
+	case GP_BJSON_STRING:
+		c->strs += strlen(gp_bjson_str(node)) + 1;
+	break;
+	case GP_BJSON_ARRAY:
+	case GP_BJSON_OBJECT: {
+		const gp_bjson *elems = gp_bjson_first(node);
+		uint32_t i;
+
+		for (i = 0; i < node->len; i++) {
+			if (elems[i].key)
+				c->strs += strlen(gp_bjson_key(&elems[i])) + 1;
+
+			dup_count(c, &elems[i]);
+		}
+	} break;
+	}
+}
+
+static void dup_node(struct compile *c, gp_bjson *dst, const gp_bjson *src)
+{
+	const gp_bjson *src_elems;
+	gp_bjson *elems;
+	uint32_t i;
+
+	dst->type = src->type;
+	dst->val = src->val;
+
+	switch (gp_bjson_type(src)) {
+	case GP_BJSON_NULL:
+	return;
+	case GP_BJSON_ARRAY:
+	case GP_BJSON_OBJECT:
+		src_elems = gp_bjson_first(src);
+		elems = alloc_nodes(c, dst, src->len);
+		for (i = 0; i < dst->len; i++) {
+			if (src_elems[i].key)
+				elems[i].key = put_str(c, &elems[i], gp_bjson_key(&src_elems[i]));
+
+			dup_node(c, &elems[i], &src_elems[i]);
+		}
+	return;
+	default:
+	break;
+	}
+
+	dst->off = put_str(c, dst, gp_bjson_str(src));
+
+	if (dst->type == GP_BJSON_STRING)
+		dst->len = src->len;
+}
+
+gp_bjson_hdr *gp_bjson_dup(const gp_bjson *self)
+{
+	struct compile c = {};
+	gp_bjson_hdr *hdr;
+
+	dup_count(&c, self);
+
+	hdr = blob_alloc(&c);
+	if (!hdr)
+		return NULL;
+
+	dup_node(&c, (gp_bjson *)gp_bjson_root(hdr), self);
+
+	return hdr;
+}
+
+static int check_str(const char *blob, const char *strs, const gp_bjson *node,
+                     int32_t off, size_t size)
+{
+	const char *str = (const char *)node + off;
+
+	return str >= strs && str < blob + size;
+}
+
+/*
+ * String values carry their length, which has to fit into the blob and end
+ * with the terminating null byte.
+ */
+static int check_str_len(const char *blob, const gp_bjson *node, size_t size)
+{
+	const char *str = (const char *)node + node->off;
+
+	return node->len < (size_t)(blob + size - str) && !str[node->len];
+}
+
+const gp_bjson *gp_bjson_check(const void *blob, size_t size)
+{
+	const gp_bjson_hdr *hdr = blob;
+	const gp_bjson *nodes = gp_bjson_root(hdr);
+	const char *strs;
+	size_t i;
+
+	if (size < sizeof(*hdr) + sizeof(gp_bjson)) {
+		GP_WARN("Binary layout too short");
+		return NULL;
+	}
+
+	if (memcmp(hdr->magic, GP_BJSON_MAGIC, sizeof(hdr->magic))) {
+		GP_WARN("Invalid binary layout magic");
+		return NULL;
+	}
+
+	if (hdr->version != GP_BJSON_VERSION) {
+		GP_WARN("Unsupported binary layout version %u", hdr->version);
+		return NULL;
+	}
+
+	if (hdr->byte_order != GP_BJSON_BYTE_ORDER) {
+		GP_WARN("Binary layout byte order mismatch");
+		return NULL;
+	}
+
+	if (hdr->size != size || !hdr->nodes ||
+	    hdr->nodes > (size - sizeof(*hdr)) / sizeof(gp_bjson)) {
+		GP_WARN("Invalid binary layout size");
+		return NULL;
+	}
+
+	strs = (const char *)(nodes + hdr->nodes);
+
+	/* All strings are terminated by the last byte in the blob */
+	if (strs < (const char *)blob + size && ((const char *)blob)[size - 1]) {
+		GP_WARN("Binary layout string table not terminated");
+		return NULL;
+	}
+
+	/*
+	 * Child nodes are always stored after their parents, which rules out
+	 * cycles and lets us check the nodes in a single linear pass.
+	 */
+	for (i = 0; i < hdr->nodes; i++) {
+		const gp_bjson *node = &nodes[i];
+		ptrdiff_t first;
+
+		if (node->key && !check_str(blob, strs, node, node->key, size))
+			goto err;
+
+		switch (node->type) {
+		case GP_BJSON_NULL:
+		break;
+		case GP_BJSON_BOOL:
+		case GP_BJSON_INT:
+		case GP_BJSON_DOUBLE:
+			if (!check_str(blob, strs, node, node->off, size))
+				goto err;
+		break;
+		case GP_BJSON_STRING:
+			if (!check_str(blob, strs, node, node->off, size) ||
+			    !check_str_len(blob, node, size))
+				goto err;
+		break;
+		case GP_BJSON_ARRAY:
+		case GP_BJSON_OBJECT:
+			if (!node->len)
+				break;
+
+			if (node->off % (int32_t)sizeof(gp_bjson))
+				goto err;
+
+			first = i + node->off / (int32_t)sizeof(gp_bjson);
+
+			if (first <= (ptrdiff_t)i || (size_t)first > hdr->nodes ||
+			    node->len > hdr->nodes - first)
+				goto err;
+		break;
+		default:
+			goto err;
+		}
+
+		if (node->type == GP_BJSON_OBJECT) {
+			const gp_bjson *member = gp_bjson_first(node);
+			uint32_t j;
+
+			for (j = 0; j < node->len; j++) {
+				if (!member[j].key)
+					goto err;
+			}
+		}
+	}
+
+	return nodes;
+err:
+	GP_WARN("Binary layout node %zu is corrupted", i);
+	return NULL;
+}
+
+int gp_bjson_save(const gp_bjson_hdr *hdr, const char *path)
+{
+	FILE *f = fopen(path, "wb");
+
+	if (!f) {
+		GP_WARN("Failed to open '%s': %s", path, strerror(errno));
+		return 1;
+	}
+
+	if (fwrite(hdr, hdr->size, 1, f) != 1) {
+		GP_WARN("Failed to write '%s': %s", path, strerror(errno));
+		fclose(f);
+		return 1;
+	}
+
+	if (fclose(f)) {
+		GP_WARN("Failed to close '%s': %s", path, strerror(errno));
+		return 1;
+	}
+
+	return 0;
+}
+
+const gp_bjson_hdr *gp_bjson_map(const char *path)
+{
+	struct stat st;
+	void *blob;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		GP_WARN("Failed to open '%s': %s", path, strerror(errno));
+		return NULL;
+	}
+
+	if (fstat(fd, &st)) {
+		GP_WARN("Failed to stat '%s': %s", path, strerror(errno));
+		goto err;
+	}
+
+	if ((size_t)st.st_size < sizeof(gp_bjson_hdr) || st.st_size > INT32_MAX) {
+		GP_WARN("Invalid binary layout '%s' size", path);
+		goto err;
+	}
+
+	blob = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (blob == MAP_FAILED) {
+		GP_WARN("Failed to mmap '%s': %s", path, strerror(errno));
+		goto err;
+	}
+
+	close(fd);
+
+	if (!gp_bjson_check(blob, st.st_size)) {
+		munmap(blob, st.st_size);
+		return NULL;
+	}
+
+	return blob;
+err:
+	close(fd);
+	return NULL;
+}
+
+void gp_bjson_unmap(const gp_bjson_hdr *hdr)
+{
+	if (!hdr)
+		return;
+
+	munmap((void *)hdr, hdr->size);
+}
@@ -0,0 +1,34 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Internal monotonic clock helpers, used for timestamps and for measuring
+ * time spent in the library.
+ */
+
+#ifndef GP_CLOCK_H__
+#define GP_CLOCK_H__
+
+#include <time.h>
+#include <stdint.h>
+
+static inline uint64_t gp_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint64_t gp_clock_us(void)
+{
+	return gp_clock_ns() / 1000;
+}
+
+#endif /* GP_CLOCK_H__ */
@@ -0,0 +1,62 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <core/gp_debug.h>
+#include <gp_text_cache.h>
+
+static gp_text_cache_stats stats = {
+	.gen = 1,
+};
+
+const gp_text_cache_stats *gp_text_cache_stats_get(void)
+{
+	return &stats;
+}
+
+void gp_text_cache_flush(void)
+{
+	/* zero is reserved for invalidated entries */
+	if (!++stats.gen)
+		stats.gen = 1;
+
+	GP_DEBUG(1, "Text cache flushed, generation %u", stats.gen);
+}
+
+static int cache_hit(gp_text_cache *self, const gp_text_style *style)
+{
+	if (self->gen == stats.gen && self->style == style) {
+		stats.hits++;
+		return 1;
+	}
+
+	stats.misses++;
+
+	self->gen = stats.gen;
+	self->style = style;
+
+	return 0;
+}
+
+gp_size gp_text_cache_width(gp_text_cache *self, const gp_text_style *style,
+                            const char *str)
+{
+	if (!cache_hit(self, style))
+		self->width = gp_text_width(style, str);
+
+	return self->width;
+}
+
+gp_size gp_text_cache_max_width_chars(gp_text_cache *self,
+                                      const gp_text_style *style,
+                                      const char *chars, unsigned int len)
+{
+	if (!cache_hit(self, style))
+		self->width = gp_text_max_width_chars(style, chars, len);
+
+	return self->width;
+}
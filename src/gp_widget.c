@@ -11,11 +11,12 @@
 #include <core/gp_common.h>
 #include <gp_widget.h>
 #include <gp_widget_ops.h>
+#include <gp_widget_arena.h>
 
 gp_widget *gp_widget_new(enum gp_widget_type type, size_t payload_size)
 {
 	size_t size = sizeof(gp_widget) + payload_size;
-	gp_widget *ret = malloc(size);
+	gp_widget *ret = gp_widget_arena_malloc(size);
 
 	GP_DEBUG(1, "Allocating widget %s payload_size=%zu size=%zu",
 	         gp_widget_type_name(type), payload_size, size);
@@ -28,6 +29,7 @@ gp_widget *gp_widget_new(enum gp_widget_type type, size_t payload_size)
 	memset(ret, 0, size);
 	ret->payload = ret->buf;
 	ret->type = type;
+	ret->arena = gp_widget_arena_active();
 
 	ret->event_mask = GP_WIDGET_DEFAULT_EVENT_MASK;
 
@@ -0,0 +1,97 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <string.h>
+#include <core/gp_debug.h>
+
+#include <gp_widget_ops.h>
+#include <gp_widget_json.h>
+#include <gp_widget_arena.h>
+
+static gp_widget_arena *cur_arena;
+
+int gp_widget_arena_begin(gp_widget_arena *self)
+{
+	if (cur_arena) {
+		GP_WARN("Arena %p already active", cur_arena);
+		return 1;
+	}
+
+	cur_arena = self;
+
+	return 0;
+}
+
+void gp_widget_arena_end(void)
+{
+	cur_arena = NULL;
+}
+
+int gp_widget_arena_active(void)
+{
+	return !!cur_arena;
+}
+
+void *gp_widget_arena_malloc(size_t size)
+{
+	void *ret;
+
+	if (!cur_arena)
+		return malloc(size);
+
+	/* Keep all allocations pointer aligned */
+	size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+	ret = gp_block_alloc(&cur_arena->blocks, size);
+	if (!ret)
+		return NULL;
+
+	cur_arena->size += size;
+	cur_arena->allocs++;
+
+	return ret;
+}
+
+char *gp_widget_arena_strdup(const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *ret = gp_widget_arena_malloc(len);
+
+	if (!ret)
+		return NULL;
+
+	return memcpy(ret, str, len);
+}
+
+gp_widget *gp_widget_layout_json_arena(const char *path, void **uids,
+                                       gp_widget_arena *self)
+{
+	gp_widget *ret;
+
+	if (gp_widget_arena_begin(self))
+		return NULL;
+
+	ret = gp_widget_layout_json(path, uids);
+
+	gp_widget_arena_end();
+
+	GP_DEBUG(1, "Layout '%s' loaded into arena, %zu bytes in %lu allocations",
+	         path, self->size, self->allocs);
+
+	return ret;
+}
+
+void gp_widget_arena_free(gp_widget_arena *self, gp_widget *layout)
+{
+	gp_widget_free(layout);
+
+	gp_block_free(&self->blocks);
+
+	self->size = 0;
+	self->allocs = 0;
+}
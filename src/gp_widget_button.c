@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
@@ -107,15 +106,15 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 	return 0;
 }
 
-static gp_widget *json_to_button(json_object *json, void **uids)
+static gp_widget *json_to_button(const gp_bjson *json, void **uids)
 {
 	const char *label = NULL;
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "label"))
-			label = json_object_get_string(val);
+			label = gp_bjson_str(val);
 		else
 			GP_WARN("Invalid button key '%s'", key);
 	}
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
@@ -126,18 +125,18 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 	return 0;
 }
 
-static gp_widget *json_to_checkbox(json_object *json, void **uids)
+static gp_widget *json_to_checkbox(const gp_bjson *json, void **uids)
 {
 	const char *label = NULL;
 	int set = 0;
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "label"))
-			label = json_object_get_string(val);
+			label = gp_bjson_str(val);
 		else if (!strcmp(key, "set"))
-			set = json_object_get_boolean(val);
+			set = gp_bjson_bool(val);
 		else
 			GP_WARN("Invalid checkbox key '%s'", key);
 	}
@@ -0,0 +1,111 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <stdint.h>
+
+#include <core/gp_debug.h>
+#include <gp_widget_damage.h>
+
+void gp_widget_damage_init(gp_widget_damage *self, unsigned int max,
+                           gp_size merge_dist)
+{
+	self->cnt = 0;
+	self->max = GP_MAX(1u, GP_MIN(max, (unsigned int)GP_WIDGET_DAMAGE_MAX));
+	self->merge_dist = merge_dist;
+}
+
+static int bbox_near(gp_bbox box1, gp_bbox box2, gp_size dist)
+{
+	gp_coord d = dist;
+
+	if (box1.x > box2.x + (gp_coord)box2.w + d)
+		return 0;
+
+	if (box2.x > box1.x + (gp_coord)box1.w + d)
+		return 0;
+
+	if (box1.y > box2.y + (gp_coord)box2.h + d)
+		return 0;
+
+	if (box2.y > box1.y + (gp_coord)box1.h + d)
+		return 0;
+
+	return 1;
+}
+
+static uint64_t bbox_area(gp_bbox box)
+{
+	return (uint64_t)box.w * box.h;
+}
+
+static void rect_rem(gp_widget_damage *self, unsigned int i)
+{
+	self->rects[i] = self->rects[--self->cnt];
+}
+
+void gp_widget_damage_add(gp_widget_damage *self, gp_bbox box)
+{
+	unsigned int i, best = 0;
+	uint64_t growth, best_growth = UINT64_MAX;
+
+	if (gp_bbox_empty(box))
+		return;
+
+	/*
+	 * Merging two rectangles produces a bigger one that may be close to
+	 * a rectangle that was too far away before, hence the loop.
+	 */
+	for (i = 0; i < self->cnt; ) {
+		if (bbox_near(self->rects[i], box, self->merge_dist)) {
+			box = gp_bbox_merge(box, self->rects[i]);
+			rect_rem(self, i);
+			i = 0;
+			continue;
+		}
+
+		i++;
+	}
+
+	if (self->cnt < self->max) {
+		self->rects[self->cnt++] = box;
+		return;
+	}
+
+	for (i = 0; i < self->cnt; i++) {
+		growth = bbox_area(gp_bbox_merge(self->rects[i], box)) -
+		         bbox_area(self->rects[i]);
+
+		if (growth < best_growth) {
+			best_growth = growth;
+			best = i;
+		}
+	}
+
+	GP_DEBUG(4, "Damage list full, merging " GP_BBOX_FMT " with " GP_BBOX_FMT,
+	         GP_BBOX_PARS(box), GP_BBOX_PARS(self->rects[best]));
+
+	box = gp_bbox_merge(self->rects[best], box);
+	rect_rem(self, best);
+	gp_widget_damage_add(self, box);
+}
+
+gp_bbox gp_widget_damage_bbox(const gp_widget_damage *self)
+{
+	gp_bbox box = {};
+	unsigned int i;
+
+	if (!self->cnt)
+		return box;
+
+	box = self->rects[0];
+
+	for (i = 1; i < self->cnt; i++)
+		box = gp_bbox_merge(box, self->rects[i]);
+
+	return box;
+}
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <core/gp_common.h>
 
@@ -66,6 +65,14 @@ static void distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx, in
 		gp_widget_ops_distribute_size(self->frame->child, ctx, w, h, new_wh);
 }
 
+static void for_each_child(gp_widget *self,
+                           void (*func)(gp_widget *child, void *priv),
+                           void *priv)
+{
+	if (self->frame->child)
+		func(self->frame->child, priv);
+}
+
 static void render(gp_widget *self, const gp_offset *offset,
                    const gp_widget_render_ctx *ctx, int flags)
 {
@@ -162,15 +169,15 @@ static int focus(gp_widget *self, int sel)
 	return gp_widget_ops_render_focus(self->frame->child, sel);
 }
 
-static gp_widget *json_to_frame(json_object *json, void **uids)
+static gp_widget *json_to_frame(const gp_bjson *json, void **uids)
 {
 	const char *label = NULL;
-	json_object *jwidget = NULL;
+	const gp_bjson *jwidget = NULL;
 	int bold = 0;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "label"))
-			label = json_object_get_string(val);
+			label = gp_bjson_str(val);
 		else if (!strcmp(key, "widget"))
 			jwidget = val;
 		else if (!strcmp(key, "bold"))
@@ -179,7 +186,7 @@ static gp_widget *json_to_frame(json_object *json, void **uids)
 			GP_WARN("Invalid frame key '%s'", key);
 	}
 
-	gp_widget *child = gp_widget_from_json(jwidget, uids);
+	gp_widget *child = gp_widget_from_bjson(jwidget, uids);
 	gp_widget *ret = gp_widget_frame_new(label, bold, child);
 
 	if (!ret)
@@ -196,6 +203,7 @@ struct gp_widget_ops gp_widget_frame_ops = {
 	.focus_xy = focus_xy,
 	.focus = focus,
 	.distribute_size = distribute_size,
+	.for_each_child = for_each_child,
 	.from_json = json_to_frame,
 	.id = "frame",
 };
@@ -135,3 +135,95 @@ void gp_triangle_updown(gp_pixmap *pix, gp_coord x_center, gp_coord y_center,
 		         x_center, y_center - base/2,
 			 x_center + base/2, y_center, color);
 }
+
+/*
+ * Fallback for pixmaps that cannot be moved by rows of bytes. The source and
+ * destination strips are at most step pixels apart, hence they never overlap
+ * and the strips are copied in the direction of the move so that no source
+ * strip is overwritten before it's copied.
+ */
+static void move_rect_y(gp_pixmap *pix, gp_coord x, gp_coord y,
+                        gp_size w, gp_size h, gp_coord dy)
+{
+	gp_size step = GP_ABS(dy);
+	gp_size i, sh;
+
+	if (dy < 0) {
+		for (i = step; i < h; i += sh) {
+			sh = GP_MIN(step, h - i);
+			gp_blit_xywh(pix, x, y + i, w, sh, pix, x, y + i + dy);
+		}
+		return;
+	}
+
+	for (i = h - step; i > 0; ) {
+		sh = GP_MIN(step, i);
+		i -= sh;
+		gp_blit_xywh(pix, x, y + i, w, sh, pix, x, y + i + dy);
+	}
+}
+
+static void move_rect_x(gp_pixmap *pix, gp_coord x, gp_coord y,
+                        gp_size w, gp_size h, gp_coord dx)
+{
+	gp_size step = GP_ABS(dx);
+	gp_size i, sw;
+
+	if (dx < 0) {
+		for (i = step; i < w; i += sw) {
+			sw = GP_MIN(step, w - i);
+			gp_blit_xywh(pix, x + i, y, sw, h, pix, x + i + dx, y);
+		}
+		return;
+	}
+
+	for (i = w - step; i > 0; ) {
+		sw = GP_MIN(step, i);
+		i -= sw;
+		gp_blit_xywh(pix, x + i, y, sw, h, pix, x + i + dx, y);
+	}
+}
+
+/*
+ * Moves the rectangle in a single pass with one memmove() per row. The rows
+ * are copied in the direction opposite to the move so that no source row is
+ * overwritten before it's copied, memmove() handles the overlap in a row.
+ */
+static void move_rect_rows(gp_pixmap *pix, gp_coord x, gp_coord y,
+                           gp_size w, gp_size h, gp_coord dx, gp_coord dy)
+{
+	size_t bpp = gp_pixel_size(pix->pixel_type) / 8;
+	gp_coord sx = x + GP_MAX(-dx, 0);
+	gp_coord sy = y + GP_MAX(-dy, 0);
+	gp_size rows = h - GP_ABS(dy);
+	size_t len = (w - GP_ABS(dx)) * bpp;
+	ptrdiff_t off = (ptrdiff_t)dy * pix->bytes_per_row + dx * (ptrdiff_t)bpp;
+	gp_size i;
+
+	for (i = 0; i < rows; i++) {
+		gp_size row = dy > 0 ? rows - 1 - i : i;
+		uint8_t *src = pix->pixels + (size_t)(sy + row) * pix->bytes_per_row + sx * bpp;
+
+		memmove(src + off, src, len);
+	}
+}
+
+void gp_move_rect_xywh(gp_pixmap *pix, gp_coord x, gp_coord y,
+                       gp_size w, gp_size h, gp_coord dx, gp_coord dy)
+{
+	if ((gp_size)GP_ABS(dx) >= w || (gp_size)GP_ABS(dy) >= h)
+		return;
+
+	/* Rotated and sub-byte pixmaps do not map rows to rows of bytes */
+	if (!pix->axes_swap && !pix->x_swap && !pix->y_swap &&
+	    !(gp_pixel_size(pix->pixel_type) % 8)) {
+		move_rect_rows(pix, x, y, w, h, dx, dy);
+		return;
+	}
+
+	if (dy)
+		move_rect_y(pix, x, y, w, h, dy);
+
+	if (dx)
+		move_rect_x(pix, x, y, w, h, dx);
+}
@@ -6,22 +6,61 @@
 
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <json-c/json.h>
 
 #include <core/gp_debug.h>
 #include <core/gp_common.h>
 #include <utils/gp_vec.h>
-#include <utils/gp_matrix.h>
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
 #include <gp_widget_json.h>
 
+/*
+ * Sparse cells are sorted by row and column so that appending rows appends at
+ * the end of the array. Returns an index of the cell or an index the cell
+ * would be inserted at.
+ */
+static unsigned int cell_search(struct gp_widget_grid *grid,
+                                unsigned int col, unsigned int row)
+{
+	unsigned int l = 0, r = grid->cells_cnt;
+
+	while (l < r) {
+		unsigned int mid = (l + r) / 2;
+		gp_widget_grid_cell *cell = &grid->cells[mid];
+
+		if (cell->row < row || (cell->row == row && cell->col < col))
+			l = mid + 1;
+		else
+			r = mid;
+	}
+
+	return l;
+}
+
+static int cell_match(struct gp_widget_grid *grid, unsigned int idx,
+                      unsigned int col, unsigned int row)
+{
+	return idx < grid->cells_cnt &&
+	       grid->cells[idx].col == col && grid->cells[idx].row == row;
+}
+
 static gp_widget *widget_grid_grid_get(struct gp_widget_grid *grid,
                                        unsigned int col, unsigned int row)
 {
-	return grid->widgets[gp_matrix_idx(grid->rows, col, row)];
+	unsigned int idx;
+
+	if (!grid->sparse)
+		return grid->widgets[col * grid->rows_cap + row];
+
+	idx = cell_search(grid, col, row);
+
+	if (!cell_match(grid, idx, col, row))
+		return NULL;
+
+	return grid->cells[idx].widget;
 }
 
 static gp_widget *widget_grid_get(gp_widget *self,
@@ -44,33 +83,241 @@ static void widget_grid_focused_offset(gp_widget *self,
 	offset->y = self->grid->rows_off[self->grid->focused_row];
 }
 
+static int cells_reserve(struct gp_widget_grid *g)
+{
+	gp_widget_grid_cell *cells;
+	unsigned int size;
+
+	if (g->cells_cnt < g->cells_size)
+		return 0;
+
+	size = GP_MAX(16u, 2 * g->cells_size);
+
+	cells = realloc(g->cells, size * sizeof(*cells));
+	if (!cells) {
+		GP_WARN("Malloc failed :-(");
+		return 1;
+	}
+
+	g->cells = cells;
+	g->cells_size = size;
+
+	return 0;
+}
+
+static gp_widget *sparse_put(struct gp_widget_grid *g, gp_widget *new,
+                             unsigned int col, unsigned int row)
+{
+	unsigned int idx = cell_search(g, col, row);
+	gp_widget *ret;
+
+	if (cell_match(g, idx, col, row)) {
+		ret = g->cells[idx].widget;
+
+		if (new) {
+			g->cells[idx].widget = new;
+			return ret;
+		}
+
+		g->cells_cnt--;
+		memmove(&g->cells[idx], &g->cells[idx+1],
+		        (g->cells_cnt - idx) * sizeof(*g->cells));
+
+		return ret;
+	}
+
+	if (!new || cells_reserve(g))
+		return NULL;
+
+	memmove(&g->cells[idx+1], &g->cells[idx],
+	        (g->cells_cnt - idx) * sizeof(*g->cells));
+
+	g->cells[idx].col = col;
+	g->cells[idx].row = row;
+	g->cells[idx].widget = new;
+	g->cells_cnt++;
+
+	return NULL;
+}
+
+/*
+ * The widgets in JSON are stored column by column, inserting them into the
+ * sparse storage one by one would move the rest of the array on each insert,
+ * so they are appended unsorted and sorted once the grid is filled.
+ */
+static void sparse_append(gp_widget *self, gp_widget *new,
+                          unsigned int col, unsigned int row)
+{
+	struct gp_widget_grid *g = self->grid;
+
+	if (cells_reserve(g)) {
+		gp_widget_free(new);
+		return;
+	}
+
+	g->cells[g->cells_cnt].col = col;
+	g->cells[g->cells_cnt].row = row;
+	g->cells[g->cells_cnt].widget = new;
+	g->cells_cnt++;
+
+	gp_widget_set_parent(new, self);
+}
+
+static int cell_cmp(const void *a, const void *b)
+{
+	const gp_widget_grid_cell *ca = a;
+	const gp_widget_grid_cell *cb = b;
+
+	if (ca->row != cb->row)
+		return ca->row < cb->row ? -1 : 1;
+
+	if (ca->col != cb->col)
+		return ca->col < cb->col ? -1 : 1;
+
+	return 0;
+}
+
+static void cells_sort(struct gp_widget_grid *g)
+{
+	qsort(g->cells, g->cells_cnt, sizeof(*g->cells), cell_cmp);
+}
+
 static struct gp_widget *widget_grid_put(gp_widget *self, gp_widget *new,
 		                         unsigned int x, unsigned int y)
 {
 	struct gp_widget_grid *g = self->grid;
-	size_t idx = gp_matrix_idx(g->rows, x, y);
+	gp_widget *ret;
 
-	gp_widget *ret = g->widgets[idx];
+	if (g->sparse) {
+		ret = sparse_put(g, new, x, y);
+	} else {
+		size_t idx = x * g->rows_cap + y;
 
-	g->widgets[idx] = new;
+		ret = g->widgets[idx];
+		g->widgets[idx] = new;
+	}
 
 	gp_widget_set_parent(new, self);
 
 	return ret;
 }
 
-void widget_grid_insert_rows(gp_widget *self, unsigned int row, unsigned int rows)
+/*
+ * Makes sure that a gp_vec has at least len elements, the pvec is a pointer
+ * to the vector pointer that is updated on success.
+ */
+static int vec_reserve(void *pvec, size_t len)
+{
+	void *vec;
+
+	memcpy(&vec, pvec, sizeof(vec));
+
+	if (gp_vec_len(vec) >= len)
+		return 0;
+
+	vec = gp_vec_resize(vec, len);
+	if (!vec) {
+		GP_WARN("Malloc failed :-(");
+		return 1;
+	}
+
+	memcpy(pvec, &vec, sizeof(vec));
+
+	return 0;
+}
+
+/*
+ * Makes space for n elements at off in an array of len elements, the new
+ * elements are zeroed.
+ */
+static void arr_ins(void *arr, size_t unit, size_t len, size_t off, size_t n)
+{
+	char *a = arr;
+
+	memmove(a + (off + n) * unit, a + off * unit, (len - off) * unit);
+	memset(a + off * unit, 0, n * unit);
+}
+
+static void arr_del(void *arr, size_t unit, size_t len, size_t off, size_t n)
+{
+	char *a = arr;
+
+	memmove(a + off * unit, a + (off + n) * unit, (len - off - n) * unit);
+}
+
+/*
+ * The storage grows geometrically so that a sequence of appends does
+ * amortized O(1) work per row or column.
+ */
+static int rows_reserve(struct gp_widget_grid *g, unsigned int rows)
+{
+	unsigned int cap, col;
+
+	if (rows <= g->rows_cap)
+		return 0;
+
+	cap = GP_MAX(rows, 2 * g->rows_cap);
+
+	if (vec_reserve(&g->rows_h, cap) ||
+	    vec_reserve(&g->rows_off, cap) ||
+	    vec_reserve(&g->row_padds, cap + 1) ||
+	    vec_reserve(&g->row_pfills, cap + 1) ||
+	    vec_reserve(&g->row_fills, cap))
+		return 1;
+
+	if (!g->sparse) {
+		if (vec_reserve(&g->widgets, (size_t)g->cols_cap * cap))
+			return 1;
+
+		/* move the columns apart, starting from the last one */
+		for (col = g->cols; col-- > 0;) {
+			memmove(g->widgets + col * cap, g->widgets + col * g->rows_cap,
+			        g->rows * sizeof(*g->widgets));
+		}
+	}
+
+	g->rows_cap = cap;
+
+	return 0;
+}
+
+static int cols_reserve(struct gp_widget_grid *g, unsigned int cols)
+{
+	unsigned int cap;
+
+	if (cols <= g->cols_cap)
+		return 0;
+
+	cap = GP_MAX(cols, 2 * g->cols_cap);
+
+	if (vec_reserve(&g->cols_w, cap) ||
+	    vec_reserve(&g->cols_off, cap) ||
+	    vec_reserve(&g->col_padds, cap + 1) ||
+	    vec_reserve(&g->col_pfills, cap + 1) ||
+	    vec_reserve(&g->col_fills, cap))
+		return 1;
+
+	if (!g->sparse && vec_reserve(&g->widgets, (size_t)cap * g->rows_cap))
+		return 1;
+
+	g->cols_cap = cap;
+
+	return 0;
+}
+
+static int widget_grid_insert_rows(gp_widget *self, unsigned int row, unsigned int rows)
 {
-	size_t i;
 	struct gp_widget_grid *g = self->grid;
+	unsigned int i;
 
-	g->widgets = gp_matrix_insert_rows(g->widgets, g->cols, g->rows, row, rows);
+	if (rows_reserve(g, g->rows + rows))
+		return 1;
 
-	g->rows_h = gp_vec_insert(g->rows_h, row, rows);
-	g->rows_off = gp_vec_insert(g->rows_off, row, rows);
-	g->row_padds = gp_vec_insert(g->row_padds, row, rows);
-	g->row_pfills = gp_vec_insert(g->row_pfills, row, rows);
-	g->row_fills = gp_vec_insert(g->row_fills, row, rows);
+	arr_ins(g->rows_h, sizeof(*g->rows_h), g->rows, row, rows);
+	arr_ins(g->rows_off, sizeof(*g->rows_off), g->rows, row, rows);
+	arr_ins(g->row_padds, 1, g->rows + 1, row, rows);
+	arr_ins(g->row_pfills, 1, g->rows + 1, row, rows);
+	arr_ins(g->row_fills, 1, g->rows, row, rows);
 
 	for (i = row; i < row + rows; i++)
 		g->row_padds[i] = 1;
@@ -78,7 +325,156 @@ void widget_grid_insert_rows(gp_widget *self, unsigned int row, unsigned int row
 	for (i = row; i < row + rows; i++)
 		g->row_fills[i] = 1;
 
+	if (g->sparse) {
+		for (i = cell_search(g, 0, row); i < g->cells_cnt; i++)
+			g->cells[i].row += rows;
+	} else {
+		for (i = 0; i < g->cols; i++) {
+			arr_ins(g->widgets + i * g->rows_cap, sizeof(*g->widgets),
+			        g->rows, row, rows);
+		}
+	}
+
+	if (g->focused_row >= row && g->focused_row < g->rows)
+		g->focused_row += rows;
+
 	g->rows += rows;
+
+	return 0;
+}
+
+static void widget_grid_delete_rows(gp_widget *self, unsigned int row, unsigned int rows)
+{
+	struct gp_widget_grid *g = self->grid;
+	unsigned int i, j, k;
+
+	if (g->sparse) {
+		i = cell_search(g, 0, row);
+		j = cell_search(g, 0, row + rows);
+
+		for (k = i; k < j; k++)
+			gp_widget_free(g->cells[k].widget);
+
+		memmove(&g->cells[i], &g->cells[j],
+		        (g->cells_cnt - j) * sizeof(*g->cells));
+
+		g->cells_cnt -= j - i;
+
+		for (k = i; k < g->cells_cnt; k++)
+			g->cells[k].row -= rows;
+	} else {
+		for (i = 0; i < g->cols; i++) {
+			gp_widget **col = g->widgets + i * g->rows_cap;
+
+			for (j = row; j < row + rows; j++)
+				gp_widget_free(col[j]);
+
+			arr_del(col, sizeof(*col), g->rows, row, rows);
+		}
+	}
+
+	arr_del(g->rows_h, sizeof(*g->rows_h), g->rows, row, rows);
+	arr_del(g->rows_off, sizeof(*g->rows_off), g->rows, row, rows);
+	arr_del(g->row_padds, 1, g->rows + 1, row, rows);
+	arr_del(g->row_pfills, 1, g->rows + 1, row, rows);
+	arr_del(g->row_fills, 1, g->rows, row, rows);
+
+	if (g->focused_row >= row + rows) {
+		g->focused_row -= rows;
+	} else if (g->focused_row >= row) {
+		g->focused_col = 0;
+		g->focused_row = 0;
+		g->focused = 0;
+	}
+
+	g->rows -= rows;
+}
+
+static int widget_grid_insert_cols(gp_widget *self, unsigned int col, unsigned int cols)
+{
+	struct gp_widget_grid *g = self->grid;
+	unsigned int i;
+
+	if (cols_reserve(g, g->cols + cols))
+		return 1;
+
+	arr_ins(g->cols_w, sizeof(*g->cols_w), g->cols, col, cols);
+	arr_ins(g->cols_off, sizeof(*g->cols_off), g->cols, col, cols);
+	arr_ins(g->col_padds, 1, g->cols + 1, col, cols);
+	arr_ins(g->col_pfills, 1, g->cols + 1, col, cols);
+	arr_ins(g->col_fills, 1, g->cols, col, cols);
+
+	for (i = col; i < col + cols; i++)
+		g->col_padds[i] = 1;
+
+	for (i = col; i < col + cols; i++)
+		g->col_fills[i] = 1;
+
+	if (g->sparse) {
+		for (i = 0; i < g->cells_cnt; i++) {
+			if (g->cells[i].col >= col)
+				g->cells[i].col += cols;
+		}
+	} else {
+		/* columns are contiguous blocks of rows_cap pointers */
+		arr_ins(g->widgets, g->rows_cap * sizeof(*g->widgets),
+		        g->cols, col, cols);
+	}
+
+	if (g->focused_col >= col && g->focused_col < g->cols)
+		g->focused_col += cols;
+
+	g->cols += cols;
+
+	return 0;
+}
+
+static void widget_grid_delete_cols(gp_widget *self, unsigned int col, unsigned int cols)
+{
+	struct gp_widget_grid *g = self->grid;
+	unsigned int i, j;
+
+	if (g->sparse) {
+		for (i = 0, j = 0; i < g->cells_cnt; i++) {
+			gp_widget_grid_cell *cell = &g->cells[i];
+
+			if (cell->col >= col && cell->col < col + cols) {
+				gp_widget_free(cell->widget);
+				continue;
+			}
+
+			if (cell->col >= col + cols)
+				cell->col -= cols;
+
+			g->cells[j++] = *cell;
+		}
+
+		g->cells_cnt = j;
+	} else {
+		for (i = col; i < col + cols; i++) {
+			for (j = 0; j < g->rows; j++)
+				gp_widget_free(g->widgets[i * g->rows_cap + j]);
+		}
+
+		arr_del(g->widgets, g->rows_cap * sizeof(*g->widgets),
+		        g->cols, col, cols);
+	}
+
+	arr_del(g->cols_w, sizeof(*g->cols_w), g->cols, col, cols);
+	arr_del(g->cols_off, sizeof(*g->cols_off), g->cols, col, cols);
+	arr_del(g->col_padds, 1, g->cols + 1, col, cols);
+	arr_del(g->col_pfills, 1, g->cols + 1, col, cols);
+	arr_del(g->col_fills, 1, g->cols, col, cols);
+
+	if (g->focused_col >= col + cols) {
+		g->focused_col -= cols;
+	} else if (g->focused_col >= col) {
+		g->focused_col = 0;
+		g->focused_row = 0;
+		g->focused = 0;
+	}
+
+	g->cols -= cols;
 }
 
 static unsigned int padd_size(const gp_widget_render_ctx *ctx, int padd)
@@ -86,31 +482,90 @@ static unsigned int padd_size(const gp_widget_render_ctx *ctx, int padd)
 	return ctx->padd * padd;
 }
 
+/*
+ * Empty cells do not contribute to the size, so sparse grids walk only the
+ * stored cells rather than looking up each of the cols * rows cells.
+ */
+static void max_min_wh(struct gp_widget_grid *grid, const gp_widget_render_ctx *ctx,
+                       unsigned int *max_w, unsigned int *max_h)
+{
+	unsigned int i, x, y;
+
+	*max_w = 0;
+	*max_h = 0;
+
+	if (grid->sparse) {
+		for (i = 0; i < grid->cells_cnt; i++) {
+			gp_widget *widget = grid->cells[i].widget;
+
+			*max_w = GP_MAX(*max_w, gp_widget_min_w(widget, ctx));
+			*max_h = GP_MAX(*max_h, gp_widget_min_h(widget, ctx));
+		}
+
+		return;
+	}
+
+	for (y = 0; y < grid->rows; y++) {
+		for (x = 0; x < grid->cols; x++) {
+			struct gp_widget *widget = widget_grid_grid_get(grid, x, y);
+
+			*max_w = GP_MAX(*max_w, gp_widget_min_w(widget, ctx));
+			*max_h = GP_MAX(*max_h, gp_widget_min_h(widget, ctx));
+		}
+	}
+}
+
 static unsigned int min_w_uniform(gp_widget *self, const gp_widget_render_ctx *ctx)
 {
 	struct gp_widget_grid *grid = self->grid;
 	unsigned int x, sum_min_w = padd_size(ctx, grid->col_padds[0]);
-	unsigned int max_cols_w = 0;
+	unsigned int max_cols_w, max_rows_h;
 
-	for (x = 0; x < grid->cols; x++) {
-		unsigned int y;
-		for (y = 0; y < grid->rows; y++) {
-			unsigned int min_w;
-			min_w = gp_widget_min_w(widget_grid_get(self, x, y), ctx);
-			max_cols_w = GP_MAX(max_cols_w, min_w);
-		}
+	max_min_wh(grid, ctx, &max_cols_w, &max_rows_h);
 
+	for (x = 0; x < grid->cols; x++)
 		sum_min_w += padd_size(ctx, grid->col_padds[x+1]);
-	}
 
 	return sum_min_w + grid->cols * max_cols_w;
 }
 
+static unsigned int min_w_sparse(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	struct gp_widget_grid *grid = self->grid;
+	unsigned int i, x, sum_min_w = padd_size(ctx, grid->col_padds[0]);
+	unsigned int *max_col_w;
+
+	max_col_w = calloc(grid->cols, sizeof(*max_col_w));
+	if (!max_col_w) {
+		GP_WARN("Malloc failed :-(");
+		return 0;
+	}
+
+	for (i = 0; i < grid->cells_cnt; i++) {
+		gp_widget_grid_cell *cell = &grid->cells[i];
+		unsigned int min_w = gp_widget_min_w(cell->widget, ctx);
+
+		max_col_w[cell->col] = GP_MAX(max_col_w[cell->col], min_w);
+	}
+
+	for (x = 0; x < grid->cols; x++) {
+		sum_min_w += max_col_w[x];
+		sum_min_w += padd_size(ctx, grid->col_padds[x+1]);
+	}
+
+	free(max_col_w);
+
+	return sum_min_w;
+}
+
 static unsigned int min_w_(gp_widget *self, const gp_widget_render_ctx *ctx)
 {
 	struct gp_widget_grid *grid = self->grid;
 	unsigned int x, sum_min_w = padd_size(ctx, grid->col_padds[0]);
 
+	if (grid->sparse)
+		return min_w_sparse(self, ctx);
+
 	for (x = 0; x < grid->cols; x++) {
 		unsigned int y, max_col_w = 0;
 		for (y = 0; y < grid->rows; y++) {
@@ -138,20 +593,38 @@ static unsigned int min_h_uniform(gp_widget *self, const gp_widget_render_ctx *c
 {
 	struct gp_widget_grid *grid = self->grid;
 	unsigned int y, sum_min_h = padd_size(ctx, grid->row_padds[0]);
-	unsigned int max_rows_h = 0;
+	unsigned int max_cols_w, max_rows_h;
 
-	for (y = 0; y < grid->rows; y++) {
-		unsigned int x;
-		for (x = 0; x < grid->cols; x++) {
+	max_min_wh(grid, ctx, &max_cols_w, &max_rows_h);
+
+	for (y = 0; y < grid->rows; y++)
+		sum_min_h += padd_size(ctx, grid->row_padds[y+1]);
+
+	return sum_min_h + grid->rows * max_rows_h;
+}
+
+/* Sparse cells are sorted by rows, cells in a row are next to each other */
+static unsigned int min_h_sparse(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	struct gp_widget_grid *grid = self->grid;
+	unsigned int i = 0, y, sum_min_h = padd_size(ctx, grid->row_padds[0]);
+
+	while (i < grid->cells_cnt) {
+		unsigned int row = grid->cells[i].row, max_row_h = 0;
+
+		for (; i < grid->cells_cnt && grid->cells[i].row == row; i++) {
 			unsigned int min_h;
-			min_h = gp_widget_min_h(widget_grid_get(self, x, y), ctx);
-			max_rows_h = GP_MAX(max_rows_h, min_h);
+			min_h = gp_widget_min_h(grid->cells[i].widget, ctx);
+			max_row_h = GP_MAX(max_row_h, min_h);
 		}
 
-		sum_min_h += padd_size(ctx, grid->row_padds[y+1]);
+		sum_min_h += max_row_h;
 	}
 
-	return sum_min_h + grid->rows * max_rows_h;
+	for (y = 0; y < grid->rows; y++)
+		sum_min_h += padd_size(ctx, grid->row_padds[y+1]);
+
+	return sum_min_h;
 }
 
 static unsigned int min_h_(gp_widget *self, const gp_widget_render_ctx *ctx)
@@ -159,6 +632,9 @@ static unsigned int min_h_(gp_widget *self, const gp_widget_render_ctx *ctx)
 	struct gp_widget_grid *grid = self->grid;
 	unsigned int y, sum_min_h = padd_size(ctx, grid->row_padds[0]);
 
+	if (grid->sparse)
+		return min_h_sparse(self, ctx);
+
 	for (y = 0; y < grid->rows; y++) {
 		unsigned int x, max_row_h = 0;
 		for (x = 0; x < grid->cols; x++) {
@@ -193,6 +669,22 @@ static void compute_cols_rows_min_wh(struct gp_widget_grid *grid,
 	for (x = 0; x < grid->cols; x++)
 		grid->cols_w[x] = 0;
 
+	if (grid->sparse) {
+		unsigned int i;
+
+		for (i = 0; i < grid->cells_cnt; i++) {
+			gp_widget_grid_cell *cell = &grid->cells[i];
+
+			x = cell->col;
+			y = cell->row;
+
+			grid->cols_w[x] = GP_MAX(grid->cols_w[x], gp_widget_min_w(cell->widget, ctx));
+			grid->rows_h[y] = GP_MAX(grid->rows_h[y], gp_widget_min_h(cell->widget, ctx));
+		}
+
+		return;
+	}
+
 	for (y = 0; y < grid->rows; y++) {
 		for (x = 0; x < grid->cols; x++) {
 			struct gp_widget *widget = widget_grid_grid_get(grid, x, y);
@@ -207,16 +699,9 @@ static void compute_cols_rows_min_uniform_wh(struct gp_widget_grid *grid,
                                              const gp_widget_render_ctx *ctx)
 {
 	unsigned int x, y;
-	unsigned int min_cols_w = 0, min_rows_h = 0;
+	unsigned int min_cols_w, min_rows_h;
 
-	for (y = 0; y < grid->rows; y++) {
-		for (x = 0; x < grid->cols; x++) {
-			struct gp_widget *widget = widget_grid_grid_get(grid, x, y);
-
-			min_cols_w = GP_MAX(min_cols_w, gp_widget_min_w(widget, ctx));
-			min_rows_h = GP_MAX(min_rows_h, gp_widget_min_h(widget, ctx));
-		}
-	}
+	max_min_wh(grid, ctx, &min_cols_w, &min_rows_h);
 
 	for (x = 0; x < grid->cols; x++)
 		grid->cols_w[x] = min_cols_w;
@@ -290,6 +775,21 @@ static void distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx, in
 	}
 
 	/* Place the widgets */
+	if (grid->sparse) {
+		unsigned int i;
+
+		for (i = 0; i < grid->cells_cnt; i++) {
+			gp_widget_grid_cell *cell = &grid->cells[i];
+
+			gp_widget_ops_distribute_size(cell->widget, ctx,
+			                              grid->cols_w[cell->col],
+			                              grid->rows_h[cell->row],
+			                              new_wh);
+		}
+
+		return;
+	}
+
 	for (y = 0; y < grid->rows; y++) {
 		for (x = 0; x < grid->cols; x++) {
 			struct gp_widget *widget = widget_grid_get(self, x, y);
@@ -386,56 +886,77 @@ static void fill_unused(gp_widget *widget, const gp_widget_render_ctx *ctx,
 	}
 }
 
-static void render(gp_widget *self, const gp_offset *offset,
-                   const gp_widget_render_ctx *ctx, int flags)
+static void render_cell(gp_widget *self, gp_widget *widget,
+                        unsigned int x, unsigned int y, const gp_offset *offset,
+                        const gp_widget_render_ctx *ctx, int flags)
 {
 	struct gp_widget_grid *grid = self->grid;
-	gp_coord cur_x, cur_y;
-	unsigned int x, y;
+	gp_coord cur_x = grid->cols_off[x] + offset->x;
+	gp_coord cur_y = grid->rows_off[y] + offset->y;
+
+	if (!widget) {
+		if (gp_widget_should_redraw(self, flags)) {
+			gp_fill_rect_xywh(ctx->buf, cur_x, cur_y,
+					  grid->cols_w[x], grid->rows_h[y],
+					  ctx->bg_color);
+		}
+		return;
+	}
 
 	if (gp_widget_should_redraw(self, flags)) {
-		fill_padding(self, offset, ctx);
-		gp_widget_ops_blit(ctx,
-		                   self->x + offset->x, self->y + offset->y,
-		                   self->w, self->h);
+		fill_unused(widget, ctx, cur_x, cur_y,
+		            grid->cols_w[x], grid->rows_h[y]);
 	}
 
-	for (y = 0; y < grid->rows; y++) {
-		cur_y = grid->rows_off[y] + offset->y;
+	if (!widget->redraw_child &&
+	    !gp_widget_should_redraw(widget, flags))
+		return;
 
-		for (x = 0; x < grid->cols; x++) {
-			cur_x = grid->cols_off[x] + offset->x;
+	GP_DEBUG(3, "Rendering widget %s [%u:%u]",
+	         gp_widget_type_id(widget), x, y);
 
-			struct gp_widget *widget = widget_grid_get(self, x, y);
+	gp_offset child_offset = {
+		.x = cur_x,
+		.y = cur_y,
+	};
 
-			if (!widget) {
-				if (gp_widget_should_redraw(self, flags)) {
-					gp_fill_rect_xywh(ctx->buf, cur_x, cur_y,
-							  grid->cols_w[x], grid->rows_h[y],
-							  ctx->bg_color);
-				}
-				continue;
-			}
+	gp_widget_ops_render(widget, &child_offset, ctx, flags);
+}
 
-			if (gp_widget_should_redraw(self, flags)) {
-				fill_unused(widget, ctx, cur_x, cur_y,
-				            grid->cols_w[x], grid->rows_h[y]);
-			}
+static void render(gp_widget *self, const gp_offset *offset,
+                   const gp_widget_render_ctx *ctx, int flags)
+{
+	struct gp_widget_grid *grid = self->grid;
+	unsigned int i, x, y;
 
-			if (!widget->redraw_child &&
-			    !gp_widget_should_redraw(widget, flags))
-				continue;
+	if (gp_widget_should_redraw(self, flags)) {
+		/* Clears the empty cells, these are not stored in sparse grid */
+		if (grid->sparse) {
+			gp_fill_rect_xywh(ctx->buf, self->x + offset->x,
+			                  self->y + offset->y, self->w, self->h,
+			                  ctx->bg_color);
+		}
 
-			GP_DEBUG(3, "Rendering widget %s [%u:%u]",
-			         gp_widget_type_id(widget), x, y);
+		fill_padding(self, offset, ctx);
+		gp_widget_ops_blit(ctx,
+		                   self->x + offset->x, self->y + offset->y,
+		                   self->w, self->h);
+	}
 
-			gp_offset child_offset = {
-				.x = cur_x,
-				.y = cur_y,
-			};
+	if (grid->sparse) {
+		for (i = 0; i < grid->cells_cnt; i++) {
+			gp_widget_grid_cell *cell = &grid->cells[i];
 
-			gp_widget_ops_render(widget, &child_offset, ctx, flags);
+			render_cell(self, cell->widget, cell->col, cell->row,
+			            offset, ctx, flags);
 		}
+
+		return;
+	}
+
+	for (y = 0; y < grid->rows; y++) {
+		for (x = 0; x < grid->cols; x++)
+			render_cell(self, widget_grid_get(self, x, y), x, y, offset, ctx, flags);
 	}
 /*
 	gp_pixel col = random();
@@ -623,22 +1144,33 @@ static int focus(gp_widget *self, int sel)
 	return 0;
 }
 
+/*
+ * The offsets are sorted since they are computed in distribute_size() as
+ * a prefix sum, hence we can bisect for the last cell that starts before the
+ * coordinate and check that the coordinate is not in the padding after it.
+ */
 static int coord_search(unsigned int coord,
                         unsigned int *sizes, unsigned int *offsets,
                         unsigned int len)
 {
-	unsigned int i;
+	unsigned int l = 0, r = len;
 
-	if (coord < offsets[0])
+	if (!len || coord < offsets[0])
 		return -1;
 
-	//TODO interval divison?
-	for (i = 0; i < len; i++) {
-		if (coord >= offsets[i] && coord <= offsets[i] + sizes[i])
-			return i;
+	while (r - l > 1) {
+		unsigned int mid = (l + r) / 2;
+
+		if (offsets[mid] <= coord)
+			l = mid;
+		else
+			r = mid;
 	}
 
-	return -1;
+	if (coord > offsets[l] + sizes[l])
+		return -1;
+
+	return l;
 }
 
 static int focus_xy(gp_widget *self, const gp_widget_render_ctx *ctx,
@@ -726,8 +1258,8 @@ static int get_uint8(const char *str, uint8_t *val, char **end,
 	return 0;
 }
 
-static void parse_strarray(const char *sarray, uint8_t *array, unsigned int len,
-                           const char *name)
+void gp_widget_grid_coefs_parse(const char *sarray, uint8_t *array,
+                                unsigned int len, const char *name)
 {
 	const char *str = sarray;
 	unsigned int i = 0;
@@ -820,10 +1352,12 @@ static void parse_strarray(const char *sarray, uint8_t *array, unsigned int len,
 	}
 }
 
-static gp_widget *json_to_grid(json_object *json, void **uids)
+static gp_widget *grid_new(unsigned int cols, unsigned int rows, int sparse);
+
+static gp_widget *json_to_grid(const gp_bjson *json, void **uids)
 {
 	int cols = 0, rows = 0, frame = 0;
-	json_object *widgets = NULL;
+	const gp_bjson *widgets = NULL;
 	const char *border = NULL;
 	const char *cpad = NULL;
 	const char *rpad = NULL;
@@ -832,32 +1366,35 @@ static gp_widget *json_to_grid(json_object *json, void **uids)
 	const char *cfill = NULL;
 	const char *rfill = NULL;
 	int uniform = 0;
+	int sparse = 0;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "cols"))
-			cols = json_object_get_int(val);
+			cols = gp_bjson_int(val);
 		else if (!strcmp(key, "rows"))
-			rows = json_object_get_int(val);
+			rows = gp_bjson_int(val);
 		else if (!strcmp(key, "widgets"))
 			widgets = val;
 		else if (!strcmp(key, "border"))
-			border = json_object_get_string(val);
+			border = gp_bjson_str(val);
 		else if (!strcmp(key, "cpad"))
-			cpad = json_object_get_string(val);
+			cpad = gp_bjson_str(val);
 		else if (!strcmp(key, "rpad"))
-			rpad = json_object_get_string(val);
+			rpad = gp_bjson_str(val);
 		else if (!strcmp(key, "cpadf"))
-			cpadf = json_object_get_string(val);
+			cpadf = gp_bjson_str(val);
 		else if (!strcmp(key, "rpadf"))
-			rpadf = json_object_get_string(val);
+			rpadf = gp_bjson_str(val);
 		else if (!strcmp(key, "cfill"))
-			cfill = json_object_get_string(val);
+			cfill = gp_bjson_str(val);
 		else if (!strcmp(key, "rfill"))
-			rfill = json_object_get_string(val);
+			rfill = gp_bjson_str(val);
 		else if (!strcmp(key, "frame"))
-			frame = !!json_object_get_int(val);
+			frame = !!gp_bjson_int(val);
 		else if (!strcmp(key, "uniform"))
 			uniform = 1;
+		else if (!strcmp(key, "sparse"))
+			sparse = !!gp_bjson_int(val);
 		else
 			GP_WARN("Invalid grid key '%s'", key);
 	}
@@ -873,19 +1410,19 @@ static gp_widget *json_to_grid(json_object *json, void **uids)
 		return NULL;
 	}
 
-	gp_widget *grid = gp_widget_grid_new(cols, rows);
+	gp_widget *grid = grid_new(cols, rows, sparse);
 	if (!grid)
 		return NULL;
 
 	grid->grid->frame = frame;
 	grid->grid->uniform = uniform;
 
-	parse_strarray(cpad, grid->grid->col_padds, cols+1, "Grid cpad");
-	parse_strarray(rpad, grid->grid->row_padds, rows+1, "Grid rpad");
-	parse_strarray(cpadf, grid->grid->col_pfills, cols+1, "Grid cpadf");
-	parse_strarray(rpadf, grid->grid->row_pfills, rows+1, "Grid rpadf");
-	parse_strarray(cfill, grid->grid->col_fills, cols, "Grid cfill");
-	parse_strarray(rfill, grid->grid->row_fills, rows, "Grid rfill");
+	gp_widget_grid_coefs_parse(cpad, grid->grid->col_padds, cols+1, "Grid cpad");
+	gp_widget_grid_coefs_parse(rpad, grid->grid->row_padds, rows+1, "Grid rpad");
+	gp_widget_grid_coefs_parse(cpadf, grid->grid->col_pfills, cols+1, "Grid cpadf");
+	gp_widget_grid_coefs_parse(rpadf, grid->grid->row_pfills, rows+1, "Grid rpadf");
+	gp_widget_grid_coefs_parse(cfill, grid->grid->col_fills, cols, "Grid cfill");
+	gp_widget_grid_coefs_parse(rfill, grid->grid->row_fills, rows, "Grid rfill");
 
 	if (border) {
 		if (!strcmp(border, "horiz")) {
@@ -906,7 +1443,7 @@ static gp_widget *json_to_grid(json_object *json, void **uids)
 		}
 	}
 
-	if (!json_object_is_type(widgets, json_type_array)) {
+	if (!gp_bjson_is_type(widgets, GP_BJSON_ARRAY)) {
 		GP_WARN("Grid key widgets has to be array!");
 		return grid;
 	}
@@ -915,29 +1452,64 @@ static gp_widget *json_to_grid(json_object *json, void **uids)
 
 	for (col = 0; col < cols; col++) {
 		for (row = 0; row < rows; row++) {
-			json_object *json_widget = json_object_array_get_idx(widgets, col * rows + row);
+			const gp_bjson *json_widget = gp_bjson_idx(widgets, col * rows + row);
 
 			if (!json_widget) {
 				GP_WARN("Not enough widgets to fill grid!");
-				return grid;
+				goto exit;
 			}
 
-			gp_widget *widget = gp_widget_from_json(json_widget, uids);
+			gp_widget *widget = gp_widget_from_bjson(json_widget, uids);
 
-			if (widget)
+			if (!widget)
+				continue;
+
+			if (grid->grid->sparse)
+				sparse_append(grid, widget, col, row);
+			else
 				gp_widget_grid_put(grid, col, row, widget);
 		}
 	}
 
-	if (json_object_array_get_idx(widgets, cols * rows))
+	if (gp_bjson_idx(widgets, cols * rows))
 		GP_WARN("Too many widgets in grid!");
 
+exit:
+	if (grid->grid->sparse)
+		cells_sort(grid->grid);
+
 	return grid;
 }
 
+static void for_each_child(gp_widget *self,
+                           void (*func)(gp_widget *child, void *priv),
+                           void *priv)
+{
+	struct gp_widget_grid *grid = self->grid;
+	unsigned int col, row, i;
+
+	if (grid->sparse) {
+		for (i = 0; i < grid->cells_cnt; i++)
+			func(grid->cells[i].widget, priv);
+		return;
+	}
+
+	for (col = 0; col < grid->cols; col++) {
+		for (row = 0; row < grid->rows; row++) {
+			gp_widget *widget = widget_grid_get(self, col, row);
+
+			if (widget)
+				func(widget, priv);
+		}
+	}
+}
+
 static void free_(gp_widget *self)
 {
-	gp_matrix_free(self->grid->widgets);
+	if (self->grid->sparse)
+		free(self->grid->cells);
+	else
+		gp_vec_free(self->grid->widgets);
 
 	gp_vec_free(self->grid->cols_w);
 	gp_vec_free(self->grid->rows_h);
@@ -949,8 +1521,6 @@ static void free_(gp_widget *self)
 	gp_vec_free(self->grid->row_pfills);
 	gp_vec_free(self->grid->col_fills);
 	gp_vec_free(self->grid->row_fills);
-
-	free(self);
 }
 
 struct gp_widget_ops gp_widget_grid_ops = {
@@ -962,11 +1532,12 @@ struct gp_widget_ops gp_widget_grid_ops = {
 	.focus = focus,
 	.focus_xy = focus_xy,
 	.distribute_size = distribute_size,
+	.for_each_child = for_each_child,
 	.from_json = json_to_grid,
 	.id = "grid",
 };
 
-gp_widget *gp_widget_grid_new(unsigned int cols, unsigned int rows)
+static gp_widget *grid_new(unsigned int cols, unsigned int rows, int sparse)
 {
 	unsigned int i;
 	gp_widget *ret;
@@ -977,7 +1548,12 @@ gp_widget *gp_widget_grid_new(unsigned int cols, unsigned int rows)
 
 	ret->grid->cols = cols;
 	ret->grid->rows = rows;
-	ret->grid->widgets = gp_matrix_new(cols, rows, sizeof(gp_widget*));
+	ret->grid->cols_cap = cols;
+	ret->grid->rows_cap = rows;
+	ret->grid->sparse = sparse;
+
+	if (!sparse)
+		ret->grid->widgets = gp_vec_new(cols * rows, sizeof(gp_widget*));
 
 	ret->grid->cols_w = gp_vec_new(cols, sizeof(unsigned int));
 	ret->grid->rows_h = gp_vec_new(rows, sizeof(unsigned int));
@@ -1005,6 +1581,16 @@ gp_widget *gp_widget_grid_new(unsigned int cols, unsigned int rows)
 	return ret;
 }
 
+gp_widget *gp_widget_grid_new(unsigned int cols, unsigned int rows)
+{
+	return grid_new(cols, rows, 0);
+}
+
+gp_widget *gp_widget_grid_sparse_new(unsigned int cols, unsigned int rows)
+{
+	return grid_new(cols, rows, 1);
+}
+
 static int assert_col_row(gp_widget *self, unsigned int col, unsigned int row)
 {
 	if (col >= self->grid->cols) {
@@ -1041,11 +1627,96 @@ gp_widget *gp_widget_grid_put(gp_widget *self, unsigned int col, unsigned int ro
 	return ret;
 }
 
-void gp_widget_grid_add_row(gp_widget *self)
+int gp_widget_grid_rows_ins(gp_widget *self, unsigned int row, unsigned int rows)
 {
-	widget_grid_insert_rows(self, self->grid->rows, 1);
+	GP_WIDGET_ASSERT(self, GP_WIDGET_GRID, 1);
+
+	if (row > self->grid->rows) {
+		GP_BUG("Invalid row index %u Grid %p %ux%u",
+			row, self, self->grid->cols, self->grid->rows);
+		return 1;
+	}
+
+	if (!rows)
+		return 0;
+
+	if (widget_grid_insert_rows(self, row, rows))
+		return 1;
 
 	gp_widget_resize(self);
+
+	return 0;
+}
+
+void gp_widget_grid_rows_del(gp_widget *self, unsigned int row, unsigned int rows)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_GRID, );
+
+	if (row > self->grid->rows || rows > self->grid->rows - row) {
+		GP_BUG("Invalid rows %u-%u Grid %p %ux%u",
+			row, row + rows, self, self->grid->cols, self->grid->rows);
+		return;
+	}
+
+	if (!rows)
+		return;
+
+	widget_grid_delete_rows(self, row, rows);
+
+	gp_widget_resize(self);
+}
+
+int gp_widget_grid_cols_ins(gp_widget *self, unsigned int col, unsigned int cols)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_GRID, 1);
+
+	if (col > self->grid->cols) {
+		GP_BUG("Invalid column index %u Grid %p %ux%u",
+			col, self, self->grid->cols, self->grid->rows);
+		return 1;
+	}
+
+	if (!cols)
+		return 0;
+
+	if (widget_grid_insert_cols(self, col, cols))
+		return 1;
+
+	gp_widget_resize(self);
+
+	return 0;
+}
+
+void gp_widget_grid_cols_del(gp_widget *self, unsigned int col, unsigned int cols)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_GRID, );
+
+	if (col > self->grid->cols || cols > self->grid->cols - col) {
+		GP_BUG("Invalid columns %u-%u Grid %p %ux%u",
+			col, col + cols, self, self->grid->cols, self->grid->rows);
+		return;
+	}
+
+	if (!cols)
+		return;
+
+	widget_grid_delete_cols(self, col, cols);
+
+	gp_widget_resize(self);
+}
+
+void gp_widget_grid_add_row(gp_widget *self)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_GRID, );
+
+	gp_widget_grid_rows_ins(self, self->grid->rows, 1);
+}
+
+void gp_widget_grid_add_col(gp_widget *self)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_GRID, );
+
+	gp_widget_grid_cols_ins(self, self->grid->cols, 1);
 }
 
 gp_widget *gp_widget_grid_rem(gp_widget *self, unsigned int col, unsigned int row)
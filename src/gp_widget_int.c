@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
@@ -108,7 +107,7 @@ void gp_widget_int_set_min(gp_widget *self, int min)
 }
 
 
-static gp_widget *json_to_int(enum gp_widget_type type, json_object *json, void **uids)
+static gp_widget *json_to_int(enum gp_widget_type type, const gp_bjson *json, void **uids)
 {
 	const char *dir = NULL;
 	int min = 0, max = 0, ival = 0, val_set = 0;
@@ -116,16 +115,16 @@ static gp_widget *json_to_int(enum gp_widget_type type, json_object *json, void
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "min"))
-			min = json_object_get_int(val);
+			min = gp_bjson_int(val);
 		else if (!strcmp(key, "max"))
-			max = json_object_get_int(val);
+			max = gp_bjson_int(val);
 		else if (!strcmp(key, "val")) {
-			ival = json_object_get_int(val);
+			ival = gp_bjson_int(val);
 			val_set = 1;
 		} else if (!strcmp(key, "dir") && type == GP_WIDGET_SLIDER)
-			dir = json_object_get_string(val);
+			dir = gp_bjson_str(val);
 		else
 			GP_WARN("Invalid int key '%s'", key);
 	}
@@ -313,7 +312,7 @@ static int spin_event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event
 	return 0;
 }
 
-static gp_widget *json_to_spin(json_object *json, void **uids)
+static gp_widget *json_to_spin(const gp_bjson *json, void **uids)
 {
 	return json_to_int(GP_WIDGET_SPINNER, json, uids);
 }
@@ -496,7 +495,7 @@ static int slider_event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_eve
 	return 0;
 }
 
-static gp_widget *json_to_slider(json_object *json, void **uids)
+static gp_widget *json_to_slider(const gp_bjson *json, void **uids)
 {
 	return json_to_int(GP_WIDGET_SLIDER, json, uids);
 }
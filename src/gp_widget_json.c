@@ -8,7 +8,9 @@
 
 #include <dlfcn.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <fcntl.h>
 
@@ -17,69 +19,69 @@
 #include <gp_widget.h>
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
-
-gp_widget *gp_widget_from_json(json_object *json, void **uids)
+#include <gp_bjson.h>
+
+enum common_key {
+	KEY_CALL,
+	KEY_TYPE,
+	KEY_UID,
+	KEY_ALIGN,
+	KEY_HALIGN,
+	KEY_VALIGN,
+	KEY_RETAIN,
+	KEY_ON_EVENT,
+	KEY_CNT,
+};
+
+static const char *const common_keys[KEY_CNT] = {
+	[KEY_CALL] = "call",
+	[KEY_TYPE] = "type",
+	[KEY_UID] = "uid",
+	[KEY_ALIGN] = "align",
+	[KEY_HALIGN] = "halign",
+	[KEY_VALIGN] = "valign",
+	[KEY_RETAIN] = "retain",
+	[KEY_ON_EVENT] = "on_event",
+};
+
+static int common_key(const char *key)
 {
-	json_object *json_type;
-	const char *type = "grid";
-	const char *uid;
-	char *uid_key = NULL;
-	unsigned int halign = 0;
-	unsigned int valign = 0;
-	int (*on_event)(gp_widget_event *) = NULL;
-
-	if (json_object_object_length(json) == 0)
-		return NULL;
-
-	if (json_object_object_get_ex(json, "call", &json_type)) {
-		const char *func_name = json_object_get_string(json_type);
-
-		if (!func_name) {
-			GP_WARN("Invalid call");
-			return NULL;
-		}
-
-		gp_widget *(*func)(void) = gp_widget_callback_addr(func_name);
+	int i;
 
-		if (!func) {
-			GP_WARN("Function call '%s' does not exist!", func_name);
-			return NULL;
-		}
-
-		GP_DEBUG(1, "Calling '%s'", func_name);
-
-		return func();
+	for (i = 0; i < KEY_CNT; i++) {
+		if (!strcmp(key, common_keys[i]))
+			return i;
 	}
 
-	if (json_object_object_get_ex(json, "type", &json_type)) {
-		type = json_object_get_string(json_type);
-
-		if (!type) {
-			GP_WARN("Invalid type");
-			return NULL;
-		}
-	}
-
-	if (json_object_object_get_ex(json, "uid", &json_type)) {
-		uid = json_object_get_string(json_type);
-
-		if (!uid) {
-			GP_WARN("Invalid uid");
-			return NULL;
-		}
+	return -1;
+}
 
-		if (uids)
-			uid_key = strdup(uid);
+int gp_widget_json_common_key(const char *key)
+{
+	return common_key(key) >= 0;
+}
 
-		GP_DEBUG(2, "Widget '%s' uid '%s'", type, uid);
+static void common_keys_get(const gp_bjson *json, const gp_bjson *keys[KEY_CNT])
+{
+	gp_bjson_foreach(json, key, val) {
+		int i = common_key(key);
 
-		json_object_object_del(json, "uid");
+		if (i >= 0)
+			keys[i] = val;
 	}
+}
+
+static unsigned int json_align(const gp_bjson *keys[KEY_CNT])
+{
+	unsigned int halign = 0;
+	unsigned int valign = 0;
 
-	if (json_object_object_get_ex(json, "align", &json_type)) {
-		const char *align_str = json_object_get_string(json_type);
+	if (keys[KEY_ALIGN]) {
+		const char *align_str = gp_bjson_str(keys[KEY_ALIGN]);
 
-		if (!strcmp(align_str, "center")) {
+		if (!align_str) {
+			GP_WARN("Align has to be a string!");
+		} else if (!strcmp(align_str, "center")) {
 			halign = GP_HCENTER;
 			valign = GP_VCENTER;
 		} else if (!strcmp(align_str, "fill")) {
@@ -92,17 +94,17 @@ gp_widget *gp_widget_from_json(json_object *json, void **uids)
 		} else {
 			GP_WARN("Invalid align=%s.", align_str);
 		}
-
-		json_object_object_del(json, "align");
 	}
 
-	if (json_object_object_get_ex(json, "halign", &json_type)) {
-		const char *halign_str = json_object_get_string(json_type);
+	if (keys[KEY_HALIGN]) {
+		const char *halign_str = gp_bjson_str(keys[KEY_HALIGN]);
 
 		if (halign)
 			GP_WARN("Only one of halign and align can be defined!");
 
-		if (!strcmp(halign_str, "center"))
+		if (!halign_str)
+			GP_WARN("Halign has to be a string!");
+		else if (!strcmp(halign_str, "center"))
 			halign = GP_HCENTER;
 		else if (!strcmp(halign_str, "left"))
 			halign = GP_LEFT;
@@ -112,17 +114,17 @@ gp_widget *gp_widget_from_json(json_object *json, void **uids)
 			halign = GP_HFILL;
 		else
 			GP_WARN("Invalid halign=%s.", halign_str);
-
-		json_object_object_del(json, "halign");
 	}
 
-	if (json_object_object_get_ex(json, "valign", &json_type)) {
-		const char *valign_str = json_object_get_string(json_type);
+	if (keys[KEY_VALIGN]) {
+		const char *valign_str = gp_bjson_str(keys[KEY_VALIGN]);
 
 		if (valign)
 			GP_WARN("Only one of valign and align can be defined!");
 
-		if (!strcmp(valign_str, "center"))
+		if (!valign_str)
+			GP_WARN("Valign has to be a string!");
+		else if (!strcmp(valign_str, "center"))
 			valign = GP_VCENTER;
 		else if (!strcmp(valign_str, "top"))
 			valign = GP_TOP;
@@ -132,21 +134,98 @@ gp_widget *gp_widget_from_json(json_object *json, void **uids)
 			valign = GP_VFILL;
 		else
 			GP_WARN("Invalid valign=%s.", valign_str);
+	}
+
+	return halign | valign;
+}
+
+static void *json_on_event(const gp_bjson *keys[KEY_CNT])
+{
+	const char *on_event_str;
+	void *on_event;
+
+	if (!keys[KEY_ON_EVENT])
+		return NULL;
+
+	on_event_str = gp_bjson_str(keys[KEY_ON_EVENT]);
+	if (!on_event_str) {
+		GP_WARN("On_event has to be a string!");
+		return NULL;
+	}
+
+	on_event = gp_widget_callback_addr(on_event_str);
+
+	if (!on_event)
+		GP_WARN("No on_event function '%s' defined", on_event_str);
+
+	return on_event;
+}
+
+gp_widget *gp_widget_from_bjson(const gp_bjson *json, void **uids)
+{
+	const gp_bjson *keys[KEY_CNT] = {};
+	const char *type = "grid";
+	const char *uid;
+	char *uid_key = NULL;
+	unsigned int align;
+	int (*on_event)(gp_widget_event *);
+	int retain = 0;
+
+	if (gp_bjson_len(json) == 0 || !gp_bjson_is_type(json, GP_BJSON_OBJECT))
+		return NULL;
+
+	common_keys_get(json, keys);
+
+	if (keys[KEY_CALL]) {
+		const char *func_name = gp_bjson_str(keys[KEY_CALL]);
+
+		if (!func_name) {
+			GP_WARN("Invalid call");
+			return NULL;
+		}
+
+		gp_widget *(*func)(void) = gp_widget_callback_addr(func_name);
+
+		if (!func) {
+			GP_WARN("Function call '%s' does not exist!", func_name);
+			return NULL;
+		}
+
+		GP_DEBUG(1, "Calling '%s'", func_name);
 
-		json_object_object_del(json, "valign");
+		return func();
 	}
 
-	if (json_object_object_get_ex(json, "on_event", &json_type)) {
-		const char *on_event_str = json_object_get_string(json_type);
+	if (keys[KEY_TYPE]) {
+		type = gp_bjson_str(keys[KEY_TYPE]);
 
-		on_event = gp_widget_callback_addr(on_event_str);
+		if (!type) {
+			GP_WARN("Invalid type");
+			return NULL;
+		}
+	}
 
-		if (!on_event)
-			GP_WARN("No on_event function '%s' defined", on_event_str);
+	if (keys[KEY_UID]) {
+		uid = gp_bjson_str(keys[KEY_UID]);
+
+		if (!uid) {
+			GP_WARN("Invalid uid");
+			return NULL;
+		}
+
+		if (uids)
+			uid_key = strdup(uid);
 
-		json_object_object_del(json, "on_event");
+		GP_DEBUG(2, "Widget '%s' uid '%s'", type, uid);
 	}
 
+	align = json_align(keys);
+
+	if (keys[KEY_RETAIN])
+		retain = gp_bjson_bool(keys[KEY_RETAIN]);
+
+	on_event = json_on_event(keys);
+
 	const struct gp_widget_ops *ops = gp_widget_ops_by_id(type);
 
 	if (!ops) {
@@ -159,8 +238,6 @@ gp_widget *gp_widget_from_json(json_object *json, void **uids)
 		goto err;
 	}
 
-	json_object_object_del(json, "type");
-
 	gp_widget *wid = ops->from_json(json, uids);
 	if (!wid)
 		goto err;
@@ -175,10 +252,13 @@ gp_widget *gp_widget_from_json(json_object *json, void **uids)
 		gp_htable_put(*uids, wid, uid_key);
 	}
 
-	wid->align = halign | valign;
+	wid->align = align;
 
 	wid->on_event = on_event;
 
+	if (retain)
+		gp_widget_retain(wid, 1);
+
 	gp_widget_send_event(wid, GP_WIDGET_EVENT_NEW);
 
 	return wid;
@@ -189,14 +269,135 @@ err:
 
 static void *ld_handle;
 
+struct callback_tables {
+	const gp_widget_callback **tables;
+	unsigned int cnt;
+	/* open addressing hash, size is power of two, built on first lookup */
+	const gp_widget_callback **hash;
+	unsigned int hash_size;
+	int dirty;
+};
+
+static struct callback_tables callbacks;
+
+static unsigned int callback_hash(const char *name)
+{
+	unsigned int h = 2166136261u;
+
+	while (*name) {
+		h ^= (unsigned char)*name++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+void gp_widget_callbacks_register(const gp_widget_callback *table)
+{
+	const gp_widget_callback **tables;
+
+	tables = realloc(callbacks.tables, (callbacks.cnt + 1) * sizeof(*tables));
+	if (!tables) {
+		GP_WARN("Malloc failed :-(");
+		return;
+	}
+
+	tables[callbacks.cnt++] = table;
+	callbacks.tables = tables;
+	callbacks.dirty = 1;
+}
+
+static void callbacks_hash_build(void)
+{
+	unsigned int i, cnt = 0, size = 16;
+	const gp_widget_callback *cb;
+
+	callbacks.dirty = 0;
+
+	for (i = 0; i < callbacks.cnt; i++) {
+		for (cb = callbacks.tables[i]; cb->name; cb++)
+			cnt++;
+	}
+
+	/* Keep the load factor under one half */
+	while (size < 2 * cnt)
+		size *= 2;
+
+	free(callbacks.hash);
+
+	callbacks.hash = calloc(size, sizeof(*callbacks.hash));
+	if (!callbacks.hash) {
+		GP_WARN("Malloc failed :-(");
+		callbacks.hash_size = 0;
+		return;
+	}
+
+	callbacks.hash_size = size;
+
+	for (i = 0; i < callbacks.cnt; i++) {
+		for (cb = callbacks.tables[i]; cb->name; cb++) {
+			unsigned int h = callback_hash(cb->name) & (size - 1);
+
+			while (callbacks.hash[h] && strcmp(callbacks.hash[h]->name, cb->name))
+				h = (h + 1) & (size - 1);
+
+			if (callbacks.hash[h])
+				GP_WARN("Duplicate callback '%s'", cb->name);
+
+			callbacks.hash[h] = cb;
+		}
+	}
+
+	GP_DEBUG(1, "Hashed %u callbacks from %u tables", cnt, callbacks.cnt);
+}
+
+static void *callbacks_lookup(const char *fn_name)
+{
+	unsigned int h;
+
+	if (!fn_name)
+		return NULL;
+
+	if (callbacks.dirty)
+		callbacks_hash_build();
+
+	if (!callbacks.hash_size)
+		return NULL;
+
+	h = callback_hash(fn_name) & (callbacks.hash_size - 1);
+
+	while (callbacks.hash[h]) {
+		if (!strcmp(callbacks.hash[h]->name, fn_name))
+			return callbacks.hash[h]->addr;
+
+		h = (h + 1) & (callbacks.hash_size - 1);
+	}
+
+	return NULL;
+}
+
 void *gp_widget_callback_addr(const char *fn_name)
 {
+	void *addr;
+
+	if (!fn_name) {
+		GP_WARN("Callback name has to be a string!");
+		return NULL;
+	}
+
+	addr = callbacks_lookup(fn_name);
+
+	if (addr) {
+		GP_DEBUG(3, "Function '%s' address is %p (registered)", fn_name, addr);
+		return addr;
+	}
+
 	if (!ld_handle)
 		return NULL;
 
 	dlerror();
 
-	void *addr = dlsym(ld_handle, fn_name);
+	addr = dlsym(ld_handle, fn_name);
 
 	GP_DEBUG(3, "Function '%s' address is %p", fn_name, addr);
 
@@ -208,24 +409,143 @@ void *gp_widget_callback_addr(const char *fn_name)
 	return addr;
 }
 
-static gp_widget *gp_widgets_from_json(json_object *json, void **uids)
+gp_widget *gp_widget_from_json(json_object *json, void **uids)
 {
+	gp_bjson_hdr *hdr = gp_bjson_compile(json);
 	gp_widget *ret;
 
+	if (!hdr)
+		return NULL;
+
+	ret = gp_widget_from_bjson(gp_bjson_root(hdr), uids);
+
+	free(hdr);
+
+	return ret;
+}
+
+/*
+ * Opens the handle callbacks are looked up in, returns non-zero if the handle
+ * has been opened and has to be closed by ld_close().
+ *
+ * Deferred and reloaded layouts may be loaded from callbacks while a layout
+ * is being loaded, in that case the handle is already open.
+ */
+static int ld_open(void)
+{
+	if (ld_handle)
+		return 0;
+
 	ld_handle = dlopen(NULL, RTLD_LAZY);
 
-	if (!ld_handle)
+	if (!ld_handle) {
 		GP_WARN("Failed to dlopen()");
+		return 0;
+	}
 
-	ret = gp_widget_from_json(json, uids);
+	return 1;
+}
+
+static void ld_close(int opened)
+{
+	if (!opened)
+		return;
 
 	dlclose(ld_handle);
 
 	ld_handle = NULL;
+}
+
+gp_widget *gp_widget_layout_from_bjson(const gp_bjson *json, void **uids)
+{
+	int opened = ld_open();
+	gp_widget *ret;
+
+	ret = gp_widget_from_bjson(json, uids);
+
+	ld_close(opened);
+
+	return ret;
+}
+
+void gp_widget_json_apply_common(gp_widget *self, const gp_bjson *json)
+{
+	const gp_bjson *keys[KEY_CNT] = {};
+	unsigned int align;
+	int opened;
+
+	if (!self)
+		return;
+
+	common_keys_get(json, keys);
+
+	align = json_align(keys);
+
+	if (self->align != align) {
+		self->align = align;
+		gp_widget_resize(self);
+	}
+
+	opened = ld_open();
+	self->on_event = json_on_event(keys);
+	ld_close(opened);
+
+	gp_widget_retain(self, keys[KEY_RETAIN] && gp_bjson_bool(keys[KEY_RETAIN]));
+
+	gp_widget_redraw(self);
+}
+
+struct gp_widget_lazy {
+	void **uids;
+	gp_bjson_hdr *json;
+};
+
+gp_widget_lazy *gp_widget_lazy_new(const gp_bjson *json, void **uids)
+{
+	gp_widget_lazy *ret = malloc(sizeof(*ret));
+
+	if (!ret) {
+		GP_WARN("Malloc failed :-(");
+		return NULL;
+	}
+
+	ret->json = gp_bjson_dup(json);
+	if (!ret->json) {
+		free(ret);
+		return NULL;
+	}
+
+	ret->uids = uids;
 
 	return ret;
 }
 
+gp_widget *gp_widget_lazy_load(gp_widget_lazy *self)
+{
+	gp_widget *ret;
+
+	if (!self)
+		return NULL;
+
+	GP_DEBUG(1, "Loading deferred layout (%u bytes)",
+	         (unsigned int)self->json->size);
+
+	ret = gp_widget_layout_from_bjson(gp_bjson_root(self->json), self->uids);
+
+	gp_widget_lazy_free(self);
+
+	return ret;
+}
+
+void gp_widget_lazy_free(gp_widget_lazy *self)
+{
+	if (!self)
+		return;
+
+	free(self->json);
+	free(self);
+}
+
 static void print_err(const char *path, const char *err, size_t bytes_consumed)
 {
 	FILE *f;
@@ -271,28 +591,25 @@ err:
 	GP_WARN("json_tokener_parse_ex(): %s: %zu", err, bytes_consumed);
 }
 
-gp_widget *gp_widget_layout_json(const char *path, void **uids)
+static json_object *json_load(const char *path)
 {
 	struct json_tokener *tok;
 	int fd;
 	json_object *json = NULL;
 	char buf[2048];
-	size_t size, bytes_consumed = 0;
-	gp_widget *ret = NULL;
-
-	if (uids)
-		*uids = NULL;
+	ssize_t size;
+	size_t bytes_consumed = 0;
 
 	fd = open(path, O_RDONLY);
 	if (fd < 0) {
 		GP_WARN("Failed to open '%s': %s", path, strerror(errno));
-		goto err;
+		return NULL;
 	}
 
 	tok = json_tokener_new();
 	if (!tok) {
 		GP_WARN("json_tokener_new() failed :-(");
-		goto err1;
+		goto err;
 	}
 
 	while ((size = read(fd, buf, sizeof(buf))) > 0) {
@@ -306,27 +623,80 @@ gp_widget *gp_widget_layout_json(const char *path, void **uids)
 		case json_tokener_continue:
 		break;
 		case json_tokener_success:
-			if ((size_t)tok->char_offset != size) {
+			if (tok->char_offset != size) {
 				print_err(path, "garbage after end", bytes_consumed + 1);
-				goto err2;
+				goto err1;
 			}
 
 			goto done;
 		default:
 			print_err(path, json_tokener_error_desc(err), bytes_consumed);
-			goto err2;
+			goto err1;
 		}
 	}
-done:
-	ret = gp_widgets_from_json(json, uids);
-err2:
+
+	GP_WARN("Unexpected end of '%s'", path);
+err1:
 	if (json)
 		json_object_put(json);
-
+	json = NULL;
+done:
 	json_tokener_free(tok);
-err1:
-	close(fd);
 err:
+	close(fd);
+	return json;
+}
+
+gp_bjson_hdr *gp_widget_layout_compile(const char *path)
+{
+	json_object *json = json_load(path);
+	gp_bjson_hdr *hdr;
+
+	if (!json)
+		return NULL;
+
+	hdr = gp_bjson_compile(json);
+
+	json_object_put(json);
+
+	return hdr;
+}
+
+gp_widget *gp_widget_layout_json(const char *path, void **uids)
+{
+	gp_bjson_hdr *hdr;
+	gp_widget *ret;
+
+	if (uids)
+		*uids = NULL;
+
+	hdr = gp_widget_layout_compile(path);
+	if (!hdr)
+		return NULL;
+
+	ret = gp_widget_layout_from_bjson(gp_bjson_root(hdr), uids);
+
+	free(hdr);
+
+	return ret;
+}
+
+gp_widget *gp_widget_layout_bjson(const char *path, void **uids)
+{
+	const gp_bjson_hdr *hdr;
+	gp_widget *ret;
+
+	if (uids)
+		*uids = NULL;
+
+	hdr = gp_bjson_map(path);
+	if (!hdr)
+		return NULL;
+
+	ret = gp_widget_layout_from_bjson(gp_bjson_root(hdr), uids);
+
+	gp_bjson_unmap(hdr);
+
 	return ret;
 }
 
@@ -0,0 +1,333 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <string.h>
+
+#include <core/gp_debug.h>
+#include <core/gp_common.h>
+#include <input/gp_timer.h>
+#include <input/gp_time_stamp.h>
+#include <gp_widget_timer.h>
+#include <gp_widget_trace.h>
+#include <gp_widget_kinetic.h>
+#include "gp_clock.h"
+
+/* velocity decay per second in 1/1000 of the velocity per millisecond */
+#define KINETIC_FRICTION 4
+/* velocity in pixels per second the motion stops at */
+#define KINETIC_MIN_VELOCITY 30
+#define KINETIC_MAX_VELOCITY 20000
+/* the longest time step a single frame advances the motion by in ms */
+#define KINETIC_MAX_DT 100
+
+static gp_widget_kinetic *moving;
+static uint32_t frame_period = 1000 / 60;
+static uint64_t last_frame;
+
+static uint64_t frame_start;
+static int frame_pending;
+
+static gp_widget_kinetic_stats stats;
+
+static uint32_t frame_callback(gp_timer *self);
+
+static gp_timer frame_timer = {
+	.id = "kinetic frame timer",
+	.callback = frame_callback,
+};
+
+static int timer_running;
+
+static int clamp_velocity(int v)
+{
+	return GP_MAX(-KINETIC_MAX_VELOCITY, GP_MIN(v, KINETIC_MAX_VELOCITY));
+}
+
+/*
+ * Advances a fling along one axis, returns the distance in whole pixels and
+ * keeps the rest for the next frame.
+ */
+static gp_coord fling_step(int *v, int *rem, unsigned int dt)
+{
+	int d = *v * (int)dt + *rem;
+
+	*rem = d % 1000;
+	*v -= *v * KINETIC_FRICTION * (int)dt / 1000;
+
+	return d / 1000;
+}
+
+static int is_slow(gp_widget_kinetic *self)
+{
+	return GP_ABS(self->vx) < KINETIC_MIN_VELOCITY &&
+	       GP_ABS(self->vy) < KINETIC_MIN_VELOCITY;
+}
+
+/*
+ * Moves the widget for a single frame.
+ *
+ * Returns non-zero if the widget is still moving.
+ */
+static int kinetic_step(gp_widget_kinetic *self, unsigned int dt, int *moved)
+{
+	gp_coord dx = self->drag_x;
+	gp_coord dy = self->drag_y;
+
+	self->drag_x = 0;
+	self->drag_y = 0;
+
+	if (self->dragging) {
+		/* velocity the fling starts with is averaged over last frames */
+		self->vx = clamp_velocity((self->vx + dx * 1000 / (int)dt) / 2);
+		self->vy = clamp_velocity((self->vy + dy * 1000 / (int)dt) / 2);
+	} else {
+		dx += fling_step(&self->vx, &self->rem_x, dt);
+		dy += fling_step(&self->vy, &self->rem_y, dt);
+	}
+
+	if (dx) {
+		if (self->move(self->widget, dx, 0)) {
+			*moved = 1;
+		} else {
+			self->vx = 0;
+			self->rem_x = 0;
+		}
+	}
+
+	if (dy) {
+		if (self->move(self->widget, 0, dy)) {
+			*moved = 1;
+		} else {
+			self->vy = 0;
+			self->rem_y = 0;
+		}
+	}
+
+	if (!is_slow(self) || dx || dy)
+		return 1;
+
+	if (!self->dragging) {
+		self->vx = 0;
+		self->vy = 0;
+		self->rem_x = 0;
+		self->rem_y = 0;
+	}
+
+	return 0;
+}
+
+static uint32_t frame_callback(gp_timer *self)
+{
+	gp_widget_kinetic **i = &moving;
+	uint64_t now = gp_time_stamp();
+	uint64_t dt = GP_MIN(now - last_frame, (uint64_t)KINETIC_MAX_DT);
+	int moved = 0;
+
+	(void)self;
+
+	frame_start = gp_clock_us();
+	last_frame = now;
+
+	if (!dt)
+		dt = 1;
+
+	while (*i) {
+		gp_widget_kinetic *kinetic = *i;
+
+		if (kinetic_step(kinetic, dt, &moved)) {
+			i = &kinetic->next;
+			continue;
+		}
+
+		kinetic->active = 0;
+		*i = kinetic->next;
+	}
+
+	frame_pending = moved;
+
+	if (!moving) {
+		GP_DEBUG(3, "Kinetic scrolling stopped");
+		timer_running = 0;
+		return 0;
+	}
+
+	return frame_period;
+}
+
+static void kinetic_start(gp_widget_kinetic *self)
+{
+	if (self->active)
+		return;
+
+	self->active = 1;
+	self->next = moving;
+	moving = self;
+
+	if (timer_running)
+		return;
+
+	GP_DEBUG(3, "Kinetic scrolling started");
+
+	last_frame = gp_time_stamp();
+	frame_timer.expires = frame_period;
+	gp_widgets_timer_ins(&frame_timer);
+	timer_running = 1;
+}
+
+void gp_widget_kinetic_init(gp_widget_kinetic *self, struct gp_widget *widget,
+                            int (*move)(struct gp_widget *self,
+                                        gp_coord x_off, gp_coord y_off))
+{
+	memset(self, 0, sizeof(*self));
+
+	self->widget = widget;
+	self->move = move;
+}
+
+static int btn_event(gp_widget_kinetic *self, gp_event *ev)
+{
+	if (ev->val != GP_BTN_LEFT)
+		return 0;
+
+	switch (ev->code) {
+	case GP_EV_KEY_DOWN:
+		self->dragging = 0;
+		self->vx = 0;
+		self->vy = 0;
+		self->rem_x = 0;
+		self->rem_y = 0;
+	break;
+	case GP_EV_KEY_UP:
+		if (!self->dragging)
+			break;
+
+		self->dragging = 0;
+
+		if (!is_slow(self))
+			kinetic_start(self);
+	break;
+	}
+
+	return 0;
+}
+
+static int drag_event(gp_widget_kinetic *self, gp_event *ev)
+{
+	if (!gp_event_get_key(ev, GP_BTN_LEFT))
+		return 0;
+
+	/* the content follows the pointer */
+	self->drag_x -= ev->rel.rx;
+	self->drag_y -= ev->rel.ry;
+	self->dragging = 1;
+
+	kinetic_start(self);
+
+	return 1;
+}
+
+static int wheel_event(gp_widget_kinetic *self, gp_event *ev, gp_size wheel_step)
+{
+	/*
+	 * The fling distance is velocity / friction, the velocity is chosen
+	 * so that each wheel step scrolls by wheel_step.
+	 */
+	int v = -ev->val * (int)wheel_step * KINETIC_FRICTION;
+
+	/* change of the direction stops the previous fling */
+	if ((v < 0) != (self->vy < 0))
+		self->vy = 0;
+
+	self->dragging = 0;
+
+	self->vy = clamp_velocity(self->vy + v);
+
+	kinetic_start(self);
+
+	return 1;
+}
+
+int gp_widget_kinetic_event(gp_widget_kinetic *self, gp_event *ev,
+                            gp_size wheel_step)
+{
+	switch (ev->type) {
+	case GP_EV_KEY:
+		return btn_event(self, ev);
+	case GP_EV_REL:
+		switch (ev->code) {
+		case GP_EV_REL_POS:
+			return drag_event(self, ev);
+		case GP_EV_REL_WHEEL:
+			return wheel_event(self, ev, wheel_step);
+		}
+	break;
+	}
+
+	return 0;
+}
+
+void gp_widget_kinetic_stop(gp_widget_kinetic *self)
+{
+	gp_widget_kinetic **i;
+
+	self->vx = 0;
+	self->vy = 0;
+	self->dragging = 0;
+
+	if (!self->active)
+		return;
+
+	for (i = &moving; *i; i = &(*i)->next) {
+		if (*i == self) {
+			*i = self->next;
+			break;
+		}
+	}
+
+	self->active = 0;
+}
+
+void gp_widget_kinetic_rate_set(unsigned int fps)
+{
+	if (!fps || fps > 1000) {
+		GP_WARN("Invalid frame rate %u", fps);
+		return;
+	}
+
+	frame_period = 1000 / fps;
+}
+
+void gp_widget_kinetic_frame_end(void)
+{
+	unsigned int us;
+
+	if (!frame_pending)
+		return;
+
+	frame_pending = 0;
+
+	us = gp_clock_us() - frame_start;
+
+	stats.frames++;
+	stats.last_frame_us = us;
+	stats.max_frame_us = GP_MAX(stats.max_frame_us, us);
+	stats.sum_frame_us += us;
+
+	if (us > frame_period * 1000) {
+		GP_DEBUG(2, "Kinetic frame took %uus, budget is %uus",
+		         us, frame_period * 1000);
+		stats.frames_late++;
+	}
+
+	gp_widget_trace(GP_WIDGET_TRACE_FRAME, 0, 0, us, NULL);
+}
+
+const gp_widget_kinetic_stats *gp_widget_kinetic_stats_get(void)
+{
+	return &stats;
+}
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <utils/gp_vec_str.h>
 
@@ -24,11 +23,14 @@ static unsigned int min_w(gp_widget *self, const gp_widget_render_ctx *ctx)
 {
 	unsigned int max_width;
 	const gp_text_style *font = label_font(self, ctx);
+	gp_text_cache *cache = &self->label->width_cache;
 
-	if (self->label->width)
-		max_width = gp_text_max_width_chars(font, self->label->set, self->label->width);
-	else
-		max_width = gp_text_width(font, self->label->text);
+	if (self->label->width) {
+		max_width = gp_text_cache_max_width_chars(cache, font, self->label->set,
+		                                          self->label->width);
+	} else {
+		max_width = gp_text_cache_width(cache, font, self->label->text);
+	}
 
 	if (self->label->frame)
 		max_width += 2 * ctx->padd;
@@ -42,29 +44,23 @@ static unsigned int min_h(gp_widget *self, const gp_widget_render_ctx *ctx)
 	return 2 * ctx->padd + gp_text_ascent(ctx->font);
 }
 
-static void render(gp_widget *self, const gp_offset *offset,
-                   const gp_widget_render_ctx *ctx, int flags)
+static void draw(gp_widget *self, const gp_widget_render_ctx *ctx,
+                 gp_pixmap *buf, gp_coord x, gp_coord y)
 {
-	(void) flags;
 	unsigned int align;
-
-	unsigned int x = self->x + offset->x;
-	unsigned int y = self->y + offset->y;
 	unsigned int w = self->w;
 	unsigned int h = self->h;
 
-	gp_widget_ops_blit(ctx, x, y, w, h);
-
 	gp_text_style *font = self->label->bold ? ctx->font_bold : ctx->font;
 
 	if (self->label->frame) {
-		gp_fill_rrect_xywh(ctx->buf, x, y, w, h, ctx->bg_color,
+		gp_fill_rrect_xywh(buf, x, y, w, h, ctx->bg_color,
 		                   ctx->fg_color, ctx->text_color);
 
 		x += ctx->padd;
 		w -= 2 * ctx->padd;
 	} else {
-		gp_fill_rect_xywh(ctx->buf, x, y, w, h, ctx->bg_color);
+		gp_fill_rect_xywh(buf, x, y, w, h, ctx->bg_color);
 	}
 
 	if (self->label->ralign) {
@@ -74,12 +70,31 @@ static void render(gp_widget *self, const gp_offset *offset,
 		align = GP_ALIGN_RIGHT;
 	}
 
-	gp_text(ctx->buf, font, x, y + ctx->padd,
+	gp_text(buf, font, x, y + ctx->padd,
 		align|GP_VALIGN_BELOW,
 		ctx->text_color, ctx->bg_color, self->label->text);
 }
 
-static gp_widget *json_to_label(json_object *json, void **uids)
+static void render(gp_widget *self, const gp_offset *offset,
+                   const gp_widget_render_ctx *ctx, int flags)
+{
+	(void) flags;
+
+	unsigned int x = self->x + offset->x;
+	unsigned int y = self->y + offset->y;
+
+	gp_widget_ops_blit(ctx, x, y, self->w, self->h);
+
+	gp_widget_surface_cache_render(&self->label->surface, self, ctx, x, y, draw);
+}
+
+static void free_(gp_widget *self)
+{
+	gp_widget_surface_cache_free(&self->label->surface);
+	gp_vec_free(self->label->text);
+}
+
+static gp_widget *json_to_label(const gp_bjson *json, void **uids)
 {
 	const char *label = NULL;
 	int bold = 0;
@@ -89,17 +104,17 @@ static gp_widget *json_to_label(json_object *json, void **uids)
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "text"))
-			label = json_object_get_string(val);
+			label = gp_bjson_str(val);
 		else if (!strcmp(key, "bold"))
-			bold = json_object_get_boolean(val);
+			bold = gp_bjson_bool(val);
 		else if (!strcmp(key, "size"))
-			size = json_object_get_int(val);
+			size = gp_bjson_int(val);
 		else if (!strcmp(key, "ralign"))
-			ralign = json_object_get_boolean(val);
+			ralign = gp_bjson_bool(val);
 		else if (!strcmp(key, "frame"))
-			frame = json_object_get_boolean(val);
+			frame = gp_bjson_bool(val);
 		else
 			GP_WARN("Invalid label key '%s'", key);
 	}
@@ -121,6 +136,7 @@ struct gp_widget_ops gp_widget_label_ops = {
 	.min_w = min_w,
 	.min_h = min_h,
 	.render = render,
+	.free = free_,
 	.from_json = json_to_label,
 	.id = "label",
 };
@@ -149,11 +165,14 @@ void gp_widget_label_set(gp_widget *self, const char *text)
 
 	self->label->text = gp_vec_printf(self->label->text, "%s", text);
 
+	gp_widget_surface_cache_invalidate(&self->label->surface);
 	gp_widget_redraw(self);
 
 	if (self->label->width)
 		return;
 
+	gp_text_cache_invalidate(&self->label->width_cache);
+
 	try_resize(self);
 }
 
@@ -220,6 +239,12 @@ int gp_widget_label_printf(gp_widget *self, const char *fmt, ...)
 	self->label->text = gp_vec_vprintf(self->label->text, fmt, ap);
 	va_end(ap);
 
+	gp_widget_surface_cache_invalidate(&self->label->surface);
+	gp_widget_redraw(self);
+
+	if (!self->label->width)
+		gp_text_cache_invalidate(&self->label->width_cache);
+
 	try_resize(self);
 
 	return 0;
@@ -0,0 +1,693 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <gp_widgets.h>
+#include <gp_widget_ops.h>
+#include <gp_widget_render.h>
+#include <gp_widget_json.h>
+
+/* Measured heights are averaged over at most this many items */
+#define EST_MAX_CNT 1024
+
+static gp_size scrollbar_size(const gp_widget_render_ctx *ctx)
+{
+	return gp_text_ascent(ctx->font) + ctx->padd;
+}
+
+static unsigned int min_w(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	struct gp_widget_list *list = self->list;
+
+	return GP_MAX(list->min_w, list->items_w) + scrollbar_size(ctx);
+}
+
+static unsigned int min_h(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	(void)ctx;
+
+	return self->list->min_h;
+}
+
+static gp_size view_w(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	return self->w - scrollbar_size(ctx);
+}
+
+static gp_coord max_y_off(gp_widget *self)
+{
+	struct gp_widget_list *list = self->list;
+	unsigned long content_h = (unsigned long)list->item_cnt * list->est_h;
+
+	if (content_h <= self->h)
+		return 0;
+
+	return content_h - self->h;
+}
+
+static void est_add(struct gp_widget_list *list, gp_size h)
+{
+	if (list->est_cnt >= EST_MAX_CNT) {
+		list->est_sum /= 2;
+		list->est_cnt /= 2;
+	}
+
+	list->est_sum += h;
+	list->est_cnt++;
+
+	list->est_h = GP_MAX(1u, (list->est_sum + list->est_cnt/2) / list->est_cnt);
+}
+
+static int items_resize(struct gp_widget_list *list, unsigned int cnt)
+{
+	gp_widget_list_item *bound, *tmp;
+	unsigned int size;
+
+	if (cnt <= list->items_size)
+		return 0;
+
+	size = GP_MAX(16u, 2 * list->items_size);
+
+	bound = realloc(list->bound, size * sizeof(*bound));
+	if (!bound)
+		goto err;
+
+	list->bound = bound;
+
+	tmp = realloc(list->tmp, size * sizeof(*tmp));
+	if (!tmp)
+		goto err;
+
+	list->tmp = tmp;
+	list->items_size = size;
+
+	return 0;
+err:
+	GP_WARN("Malloc failed :-(");
+	return 1;
+}
+
+static void item_focus_out(gp_widget *self)
+{
+	struct gp_widget_list *list = self->list;
+
+	if (!list->focused)
+		return;
+
+	gp_widget_ops_render_focus(list->focused, GP_FOCUS_OUT);
+	list->focused = NULL;
+}
+
+static void pool_put(gp_widget *self, gp_widget *item)
+{
+	struct gp_widget_list *list = self->list;
+
+	if (item == list->focused)
+		item_focus_out(self);
+
+	if (list->pool_cnt >= list->pool_size) {
+		unsigned int size = GP_MAX(16u, 2 * list->pool_size);
+		gp_widget **pool = realloc(list->pool, size * sizeof(*pool));
+
+		if (!pool) {
+			GP_WARN("Malloc failed :-(");
+			gp_widget_free(item);
+			return;
+		}
+
+		list->pool = pool;
+		list->pool_size = size;
+	}
+
+	list->pool[list->pool_cnt++] = item;
+}
+
+/*
+ * Returns an item widget for an index, the item that was bound to the index
+ * is reused, otherwise an item from the pool or a new item is set to the
+ * index.
+ */
+static gp_widget *item_get(gp_widget *self, const gp_widget_render_ctx *ctx,
+                           unsigned int idx, int *new_wh)
+{
+	struct gp_widget_list *list = self->list;
+	gp_widget *item;
+
+	if (idx >= list->first && idx - list->first < list->bound_cnt) {
+		item = list->bound[idx - list->first].widget;
+
+		if (item) {
+			list->bound[idx - list->first].widget = NULL;
+			return item;
+		}
+	}
+
+	if (list->pool_cnt) {
+		item = list->pool[--list->pool_cnt];
+	} else {
+		item = list->model->item_new(self);
+		if (!item)
+			return NULL;
+
+		gp_widget_set_parent(item, self);
+	}
+
+	list->model->item_set(self, item, idx);
+
+	est_add(list, gp_widget_min_h(item, ctx));
+
+	if (gp_widget_min_w(item, ctx) > list->items_w) {
+		list->items_w = gp_widget_min_w(item, ctx);
+		gp_widget_resize(self);
+	}
+
+	*new_wh = 1;
+
+	return item;
+}
+
+static gp_widget *item_place(gp_widget *self, const gp_widget_render_ctx *ctx,
+                             unsigned int idx, int new_wh)
+{
+	gp_widget *item = item_get(self, ctx, idx, &new_wh);
+
+	if (!item)
+		return NULL;
+
+	gp_widget_ops_distribute_size(item, ctx,
+	                              GP_MAX(view_w(self, ctx), item->min_w),
+	                              item->min_h, new_wh);
+
+	return item;
+}
+
+/*
+ * Binds and places the items that are visible at the current offset.
+ *
+ * The first visible item is estimated from the offset, the items that follow
+ * are placed by their real heights. At the end of the list the estimate may be
+ * off, so the last item is aligned with the bottom.
+ */
+static void layout_items(gp_widget *self, const gp_widget_render_ctx *ctx, int new_wh)
+{
+	struct gp_widget_list *list = self->list;
+	gp_widget_list_item *tmp;
+	unsigned int i, first, cnt = 0;
+	gp_coord y, h = self->h;
+	gp_widget *item;
+
+	if (list->y_off > max_y_off(self))
+		list->y_off = max_y_off(self);
+
+	first = list->est_h ? list->y_off / list->est_h : 0;
+	first = GP_MIN(first, list->item_cnt);
+	y = (gp_coord)first * list->est_h - list->y_off;
+
+	/*
+	 * Items that are most likely out of the view are put into the pool
+	 * first so that they are reused for the items scrolled into the view.
+	 */
+	for (i = 0; i < list->bound_cnt; i++) {
+		unsigned int idx = list->first + i;
+
+		if (idx >= first && idx < first + list->bound_cnt)
+			continue;
+
+		pool_put(self, list->bound[i].widget);
+		list->bound[i].widget = NULL;
+	}
+
+	while (y < h && first + cnt < list->item_cnt) {
+		if (items_resize(list, cnt + 1))
+			break;
+
+		item = item_place(self, ctx, first + cnt, new_wh);
+		if (!item)
+			break;
+
+		list->tmp[cnt].widget = item;
+		list->tmp[cnt].y = y;
+		y += item->min_h;
+		cnt++;
+	}
+
+	if (cnt && y < h && first + cnt == list->item_cnt) {
+		gp_coord shift = h - y;
+
+		while (first > 0 && list->tmp[0].y + shift > 0) {
+			if (items_resize(list, cnt + 1))
+				break;
+
+			item = item_place(self, ctx, first - 1, new_wh);
+			if (!item)
+				break;
+
+			memmove(list->tmp + 1, list->tmp, cnt * sizeof(*list->tmp));
+			list->tmp[0].widget = item;
+			list->tmp[0].y = list->tmp[1].y - item->min_h;
+			first--;
+			cnt++;
+		}
+
+		if (list->tmp[0].y + shift > 0)
+			shift = -list->tmp[0].y;
+
+		for (i = 0; i < cnt; i++)
+			list->tmp[i].y += shift;
+
+		list->y_off = max_y_off(self);
+	}
+
+	for (i = 0; i < list->bound_cnt; i++) {
+		if (list->bound[i].widget)
+			pool_put(self, list->bound[i].widget);
+	}
+
+	tmp = list->bound;
+	list->bound = list->tmp;
+	list->tmp = tmp;
+
+	list->first = first;
+	list->bound_cnt = cnt;
+
+	GP_DEBUG(4, "List %p items %u-%u bound, %u pooled, est_h %u",
+	         self, first, first + cnt, list->pool_cnt, list->est_h);
+}
+
+static void unbind_items(gp_widget *self)
+{
+	struct gp_widget_list *list = self->list;
+	unsigned int i;
+
+	for (i = 0; i < list->bound_cnt; i++)
+		pool_put(self, list->bound[i].widget);
+
+	list->bound_cnt = 0;
+}
+
+static void distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx, int new_wh)
+{
+	layout_items(self, ctx, new_wh);
+}
+
+/*
+ * The items are bound and placed right away, only the visible items are
+ * touched so there is no need to wait for the next layout recalculation.
+ */
+static void relayout(gp_widget *self)
+{
+	const gp_widget_render_ctx *ctx = gp_widgets_render_ctx();
+
+	gp_widget_redraw(self);
+	gp_widget_redraw_children(self);
+
+	/* Not placed yet, items are bound in distribute_size() */
+	if (self->w <= scrollbar_size(ctx))
+		return;
+
+	layout_items(self, ctx, 0);
+}
+
+static int set_y_off(gp_widget *self, gp_coord y_off)
+{
+	struct gp_widget_list *list = self->list;
+
+	y_off = GP_MAX(0, GP_MIN(y_off, max_y_off(self)));
+
+	if (list->y_off == y_off)
+		return 0;
+
+	list->y_off = y_off;
+
+	relayout(self);
+
+	return 1;
+}
+
+static void for_each_child(gp_widget *self,
+                           void (*func)(gp_widget *child, void *priv),
+                           void *priv)
+{
+	struct gp_widget_list *list = self->list;
+	unsigned int i;
+
+	for (i = 0; i < list->bound_cnt; i++)
+		func(list->bound[i].widget, priv);
+}
+
+static void draw_scroll_bar(gp_widget *self, const gp_widget_render_ctx *ctx,
+                            gp_coord x, gp_coord y, gp_size h, gp_size size)
+{
+	struct gp_widget_list *list = self->list;
+	gp_size asc = gp_text_ascent(ctx->font);
+	gp_coord pos = 0;
+
+	gp_fill_rect_xywh(ctx->buf, x, y, size, h, ctx->bg_color);
+
+	gp_vline_xyh(ctx->buf, x + ctx->padd + asc/2, y, h, ctx->text_color);
+
+	gp_size max_off = max_y_off(self);
+
+	if (max_off)
+		pos = ((h - asc) * list->y_off + max_off/2) / max_off;
+
+	gp_pixel col = list->area_focused ? ctx->sel_color : ctx->text_color;
+
+	gp_fill_rrect_xywh(ctx->buf, x + ctx->padd, y + pos, asc, asc, ctx->bg_color, ctx->fg_color, col);
+}
+
+static void render(gp_widget *self, const gp_offset *offset,
+                   const gp_widget_render_ctx *ctx, int flags)
+{
+	struct gp_widget_list *list = self->list;
+	gp_coord x = self->x + offset->x;
+	gp_coord y = self->y + offset->y;
+	gp_size w = view_w(self, ctx);
+	gp_size h = self->h;
+	int redraw = gp_widget_should_redraw(self, flags);
+	unsigned int i;
+
+	if (redraw) {
+		gp_widget_ops_blit(ctx, x, y, self->w, self->h);
+		gp_fill_rect_xywh(ctx->buf, x, y, w, h, ctx->bg_color);
+		draw_scroll_bar(self, ctx, x + w, y, h, scrollbar_size(ctx));
+		flags |= GP_WIDGET_REDRAW;
+	}
+
+	gp_bbox view = gp_bbox_pack(x, y, w, h);
+
+	for (i = 0; i < list->bound_cnt; i++) {
+		gp_offset item_offset = {
+			.x = 0,
+			.y = list->bound[i].y,
+		};
+
+		gp_widget_ops_render_clip(list->bound[i].widget, &item_offset,
+		                          ctx, flags, view, !redraw);
+	}
+}
+
+static gp_coord item_y(gp_widget *self, gp_widget *item)
+{
+	struct gp_widget_list *list = self->list;
+	unsigned int i;
+
+	for (i = 0; i < list->bound_cnt; i++) {
+		if (list->bound[i].widget == item)
+			return list->bound[i].y;
+	}
+
+	return 0;
+}
+
+static void scrollbar_event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
+{
+	gp_size asc = gp_text_ascent(ctx->font);
+	gp_size gh = self->h - asc;
+	gp_coord y = ev->cursor_y - asc/2;
+
+	if (!gh)
+		return;
+
+	y = GP_MAX(0, GP_MIN(y, (gp_coord)gh));
+
+	set_y_off(self, ((long)y * max_y_off(self) + gh/2) / gh);
+}
+
+static int area_event(gp_widget *self, gp_event *ev)
+{
+	struct gp_widget_list *list = self->list;
+
+	if (ev->type != GP_EV_KEY)
+		return 0;
+
+	if (ev->code == GP_EV_KEY_UP)
+		return 0;
+
+	switch (ev->val) {
+	case GP_KEY_UP:
+		set_y_off(self, list->y_off - list->est_h);
+		return 1;
+	case GP_KEY_DOWN:
+		set_y_off(self, list->y_off + list->est_h);
+		return 1;
+	case GP_KEY_PAGE_UP:
+		set_y_off(self, list->y_off - self->h);
+		return 1;
+	case GP_KEY_PAGE_DOWN:
+		set_y_off(self, list->y_off + self->h);
+		return 1;
+	case GP_KEY_HOME:
+		set_y_off(self, 0);
+		return 1;
+	case GP_KEY_END:
+		set_y_off(self, max_y_off(self));
+		return 1;
+	}
+
+	return 0;
+}
+
+static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
+{
+	struct gp_widget_list *list = self->list;
+
+	if (ev->cursor_x >= view_w(self, ctx)) {
+		if (gp_event_get_key(ev, GP_BTN_LEFT) ||
+		    ev->type == GP_EV_ABS) {
+			scrollbar_event(self, ctx, ev);
+			return 1;
+		}
+	}
+
+	if (list->area_focused)
+		return area_event(self, ev);
+
+	if (!list->focused)
+		return 0;
+
+	return gp_widget_ops_event_offset(list->focused, ctx, ev, 0,
+	                                  item_y(self, list->focused));
+}
+
+static void area_focus_out(gp_widget *self)
+{
+	struct gp_widget_list *list = self->list;
+
+	if (!list->area_focused)
+		return;
+
+	list->area_focused = 0;
+	gp_widget_redraw(self);
+}
+
+static int area_focus_in(gp_widget *self)
+{
+	struct gp_widget_list *list = self->list;
+
+	item_focus_out(self);
+
+	if (list->area_focused)
+		return 0;
+
+	list->area_focused = 1;
+	gp_widget_redraw(self);
+
+	return 1;
+}
+
+static int focus_xy(gp_widget *self, const gp_widget_render_ctx *ctx,
+                    unsigned int x, unsigned int y)
+{
+	struct gp_widget_list *list = self->list;
+	unsigned int i;
+
+	if (x >= view_w(self, ctx)) {
+		area_focus_in(self);
+		return 1;
+	}
+
+	for (i = 0; i < list->bound_cnt; i++) {
+		gp_widget *item = list->bound[i].widget;
+		gp_coord item_y = list->bound[i].y;
+
+		if ((gp_coord)y < item_y || (gp_coord)y >= item_y + (gp_coord)item->h)
+			continue;
+
+		if (!gp_widget_ops_render_focus_xy(item, ctx, x, y - item_y))
+			return 0;
+
+		if (list->focused != item)
+			item_focus_out(self);
+
+		area_focus_out(self);
+		list->focused = item;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static int focus(gp_widget *self, int sel)
+{
+	struct gp_widget_list *list = self->list;
+
+	if (sel == GP_FOCUS_OUT) {
+		item_focus_out(self);
+		area_focus_out(self);
+		return 1;
+	}
+
+	if (list->focused && gp_widget_ops_render_focus(list->focused, sel))
+		return 1;
+
+	return area_focus_in(self);
+}
+
+static void free_(gp_widget *self)
+{
+	struct gp_widget_list *list = self->list;
+	unsigned int i;
+
+	for (i = 0; i < list->pool_cnt; i++)
+		gp_widget_free(list->pool[i]);
+
+	free(list->pool);
+	free(list->bound);
+	free(list->tmp);
+}
+
+static gp_widget *json_to_list(const gp_bjson *json, void **uids)
+{
+	const gp_widget_list_model *model = NULL;
+	int min_w = 0, min_h = 0;
+
+	(void)uids;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "min_w"))
+			min_w = gp_bjson_int(val);
+		else if (!strcmp(key, "min_h"))
+			min_h = gp_bjson_int(val);
+		else if (!strcmp(key, "model"))
+			model = gp_widget_callback_addr(gp_bjson_str(val));
+		else
+			GP_WARN("Invalid list key '%s'", key);
+	}
+
+	if (min_w < 0 || min_h <= 0) {
+		GP_WARN("min_w must be >= 0 and min_h must be > 0");
+		return NULL;
+	}
+
+	if (!model) {
+		GP_WARN("Missing or invalid list model");
+		return NULL;
+	}
+
+	return gp_widget_list_new(min_w, min_h, model, NULL);
+}
+
+struct gp_widget_ops gp_widget_list_ops = {
+	.min_w = min_w,
+	.min_h = min_h,
+	.render = render,
+	.event = event,
+	.focus_xy = focus_xy,
+	.focus = focus,
+	.distribute_size = distribute_size,
+	.for_each_child = for_each_child,
+	.free = free_,
+	.from_json = json_to_list,
+	.id = "list",
+};
+
+gp_widget *gp_widget_list_new(gp_size min_w, gp_size min_h,
+                              const gp_widget_list_model *model, void *priv)
+{
+	gp_widget *ret;
+
+	if (!model || !model->item_cnt || !model->item_new || !model->item_set) {
+		GP_WARN("Invalid list model");
+		return NULL;
+	}
+
+	ret = gp_widget_new(GP_WIDGET_LIST, sizeof(struct gp_widget_list));
+	if (!ret)
+		return NULL;
+
+	ret->list->min_w = min_w;
+	ret->list->min_h = min_h;
+	ret->list->model = model;
+	ret->list->priv = priv;
+
+	ret->list->item_cnt = model->item_cnt(ret);
+
+	return ret;
+}
+
+void gp_widget_list_refresh(gp_widget *self)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_LIST, );
+
+	self->list->item_cnt = self->list->model->item_cnt(self);
+
+	unbind_items(self);
+	relayout(self);
+}
+
+void gp_widget_list_item_refresh(gp_widget *self, unsigned int idx)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_LIST, );
+
+	struct gp_widget_list *list = self->list;
+
+	if (idx < list->first || idx - list->first >= list->bound_cnt)
+		return;
+
+	list->model->item_set(self, list->bound[idx - list->first].widget, idx);
+}
+
+void gp_widget_list_show(gp_widget *self, unsigned int idx)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_LIST, );
+
+	struct gp_widget_list *list = self->list;
+
+	if (idx >= list->item_cnt)
+		return;
+
+	if (idx >= list->first && idx - list->first < list->bound_cnt) {
+		gp_widget_list_item *item = &list->bound[idx - list->first];
+
+		if (item->y < 0) {
+			set_y_off(self, list->y_off + item->y);
+			return;
+		}
+
+		if (item->y + (gp_coord)item->widget->h > (gp_coord)self->h)
+			set_y_off(self, list->y_off + item->y + item->widget->h - self->h);
+
+		return;
+	}
+
+	if (idx < list->first)
+		set_y_off(self, (gp_coord)idx * list->est_h);
+	else
+		set_y_off(self, (gp_coord)(idx + 1) * list->est_h - self->h);
+}
+
+int gp_widget_list_move(gp_widget *self, gp_coord y_off)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_LIST, 0);
+
+	return set_y_off(self, self->list->y_off + y_off);
+}
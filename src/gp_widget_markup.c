@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <utils/gp_vec_str.h>
 
@@ -31,6 +30,22 @@ static gp_text_style *get_font(const gp_widget_render_ctx *ctx, int attrs)
 	return ctx->font;
 }
 
+static gp_text_cache *elem_cache(gp_widget *self, const gp_markup_elem *e)
+{
+	return &self->markup->widths[e - gp_markup_first(self->markup->markup)];
+}
+
+static gp_size elem_width(gp_widget *self, const gp_widget_render_ctx *ctx,
+                          const gp_markup_elem *e)
+{
+	const char *str = gp_markup_elem_str(e);
+
+	if (!str)
+		return 0;
+
+	return gp_text_cache_width(elem_cache(self, e), get_font(ctx, e->attrs), str);
+}
+
 static unsigned int min_w(gp_widget *self, const gp_widget_render_ctx *ctx)
 {
 	unsigned int max_width = 0;
@@ -38,11 +53,7 @@ static unsigned int min_w(gp_widget *self, const gp_widget_render_ctx *ctx)
 	gp_markup_elem *e;
 
 	for (e = gp_markup_first(self->markup->markup); e; e = gp_markup_next(e)) {
-		const gp_text_style *font = get_font(ctx, e->attrs);
-		const char *str = gp_markup_elem_str(e);
-
-		if (str)
-			width += gp_text_width(font, str);
+		width += elem_width(self, ctx, e);
 
 		if (e->type == GP_MARKUP_NEWLINE) {
 			max_width = GP_MAX(max_width, width);
@@ -78,18 +89,16 @@ static unsigned int min_h(gp_widget *self, const gp_widget_render_ctx *ctx)
 	return ctx->padd + height + max_h + (max_h ? ctx->padd : 0);
 }
 
-static void line_bbox(const gp_markup_elem *e, const gp_widget_render_ctx *ctx,
-                      gp_size *w, gp_size *h)
+static void line_bbox(gp_widget *self, const gp_markup_elem *e,
+                      const gp_widget_render_ctx *ctx, gp_size *w, gp_size *h)
 {
 	gp_size width = 0;
 	gp_size height = 0;
 
 	while (e->type != GP_MARKUP_END && e->type != GP_MARKUP_NEWLINE) {
 		const gp_text_style *font = get_font(ctx, e->attrs);
-		const char *str = gp_markup_elem_str(e);
 
-		if (str)
-			width += gp_text_width(font, str);
+		width += elem_width(self, ctx, e);
 
 		height = GP_MAX(height, gp_text_ascent(font));
 
@@ -100,18 +109,10 @@ static void line_bbox(const gp_markup_elem *e, const gp_widget_render_ctx *ctx,
 	*h = height;
 }
 
-static void render(gp_widget *self, const gp_offset *offset,
-                   const gp_widget_render_ctx *ctx, int flags)
+static void draw(gp_widget *self, const gp_widget_render_ctx *ctx,
+                 gp_pixmap *buf, gp_coord x, gp_coord y)
 {
-	(void) flags;
-
-	unsigned int x = self->x + offset->x;
-	unsigned int y = self->y + offset->y;
-	unsigned int w = self->w;
-	unsigned int h = self->h;
-
-	gp_widget_ops_blit(ctx, x, y, w, h);
-	gp_fill_rect_xywh(ctx->buf, x, y, w, h, ctx->bg_color);
+	gp_fill_rect_xywh(buf, x, y, self->w, self->h, ctx->bg_color);
 
 	gp_markup_elem *e = gp_markup_first(self->markup->markup);
 
@@ -119,7 +120,7 @@ static void render(gp_widget *self, const gp_offset *offset,
 		gp_coord cur_x = x;
 		gp_size w, h;
 
-		line_bbox(e, ctx, &w, &h);
+		line_bbox(self, e, ctx, &w, &h);
 
 		while (e->type != GP_MARKUP_NEWLINE) {
 			const gp_text_style *font = get_font(ctx, e->attrs);
@@ -140,16 +141,16 @@ static void render(gp_widget *self, const gp_offset *offset,
 
 			if (e->attrs & GP_MARKUP_INVERSE) {
 				unsigned int str_h = gp_text_ascent(font) + ctx->padd;
-				unsigned int str_w = gp_text_width(font, str);
+				unsigned int str_w = elem_width(self, ctx, e);
 				unsigned int str_y = cur_y + ctx->padd - str_h;
 
 				GP_SWAP(fg, bg);
 
-				gp_fill_rect_xywh(ctx->buf, cur_x, str_y,
+				gp_fill_rect_xywh(buf, cur_x, str_y,
 				                  str_w, gp_text_height(font), bg);
 			}
 
-			cur_x += gp_text(ctx->buf, font, cur_x, cur_y,
+			cur_x += gp_text(buf, font, cur_x, cur_y,
 			                 GP_ALIGN_RIGHT | GP_VALIGN_BASELINE,
 			                 fg, bg, str);
 
@@ -161,6 +162,19 @@ static void render(gp_widget *self, const gp_offset *offset,
 	}
 }
 
+static void render(gp_widget *self, const gp_offset *offset,
+                   const gp_widget_render_ctx *ctx, int flags)
+{
+	(void) flags;
+
+	unsigned int x = self->x + offset->x;
+	unsigned int y = self->y + offset->y;
+
+	gp_widget_ops_blit(ctx, x, y, self->w, self->h);
+
+	gp_widget_surface_cache_render(&self->markup->surface, self, ctx, x, y, draw);
+}
+
 static void try_resize(gp_widget *self)
 {
 	const gp_widget_render_ctx *ctx = gp_widgets_render_ctx();
@@ -182,25 +196,29 @@ void gp_widget_markup_refresh(gp_widget *self)
 			continue;
 
 		e->var = self->markup->get(var_id++, e->var);
+
+		gp_text_cache_invalidate(elem_cache(self, e));
 	}
 
+	gp_widget_surface_cache_invalidate(&self->markup->surface);
+
 	try_resize(self);
 
 	gp_widget_redraw(self);
 }
 
-static gp_widget *json_to_markup(json_object *json, void **uids)
+static gp_widget *json_to_markup(const gp_bjson *json, void **uids)
 {
 	const char *markup = NULL;
 	char *(*get)(unsigned int var_id, char *old_val) = NULL;
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "text"))
-			markup = json_object_get_string(val);
+			markup = gp_bjson_str(val);
 		else if (!strcmp(key, "get"))
-			get = gp_widget_callback_addr(json_object_get_string(val));
+			get = gp_widget_callback_addr(gp_bjson_str(val));
 		else
 			GP_WARN("Invalid markup key '%s'", key);
 	}
@@ -215,10 +233,20 @@ static gp_widget *json_to_markup(json_object *json, void **uids)
 	return ret;
 }
 
+static void free_(gp_widget *self)
+{
+	gp_widget_surface_cache_free(&self->markup->surface);
+	gp_markup_free(self->markup->markup);
+
+	if (!self->arena)
+		free(self->markup->widths);
+}
+
 struct gp_widget_ops gp_widget_markup_ops = {
 	.min_w = min_w,
 	.min_h = min_h,
 	.render = render,
+	.free = free_,
 	.from_json = json_to_markup,
 	.id = "markup",
 };
@@ -229,10 +257,16 @@ gp_widget *gp_widget_markup_new(const char *markup_str,
 	size_t payload_size = sizeof(struct gp_widget_markup);
 	gp_widget *ret;
 	gp_markup *markup = gp_markup_parse(markup_str);
+	gp_text_cache *widths;
+	gp_markup_elem *e;
+	size_t elems = 1;
 
 	if (!markup)
 		return NULL;
 
+	for (e = gp_markup_first(markup); e->type != GP_MARKUP_END; e++)
+		elems++;
+
 	ret = gp_widget_new(GP_WIDGET_MARKUP, payload_size);
 	if (!ret) {
 		gp_markup_free(markup);
@@ -242,6 +276,15 @@ gp_widget *gp_widget_markup_new(const char *markup_str,
 	ret->markup->get = get;
 	ret->markup->markup = markup;
 
+	widths = gp_widget_arena_malloc(elems * sizeof(*widths));
+	if (!widths) {
+		gp_widget_free(ret);
+		return NULL;
+	}
+
+	memset(widths, 0, elems * sizeof(*widths));
+	ret->markup->widths = widths;
+
 	return ret;
 }
 
@@ -280,6 +323,9 @@ void gp_widget_markup_set_var(gp_widget *self, unsigned int var_id, const char *
 	var->var = gp_vec_vprintf(var->var, fmt, va);
 	va_end(va);
 
+	gp_text_cache_invalidate(elem_cache(self, var));
+	gp_widget_surface_cache_invalidate(&self->markup->surface);
+
 	try_resize(self);
 
 	gp_widget_redraw(self);
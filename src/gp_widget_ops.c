@@ -13,6 +13,7 @@
 #include <gp_widget_event.h>
 #include <gp_widget_ops.h>
 #include <gp_widget_render.h>
+#include <gp_widget_surface_cache.h>
 
 extern struct gp_widget_ops gp_widget_grid_ops;
 extern struct gp_widget_ops gp_widget_tabs_ops;
@@ -31,6 +32,7 @@ extern struct gp_widget_ops gp_widget_frame_ops;
 extern struct gp_widget_ops gp_widget_markup_ops;
 extern struct gp_widget_ops gp_widget_switch_ops;
 extern struct gp_widget_ops gp_widget_overlay_ops;
+extern struct gp_widget_ops gp_widget_list_ops;
 
 static struct gp_widget_ops *widget_ops[] = {
 	[GP_WIDGET_GRID]        = &gp_widget_grid_ops,
@@ -50,6 +52,7 @@ static struct gp_widget_ops *widget_ops[] = {
 	[GP_WIDGET_MARKUP]      = &gp_widget_markup_ops,
 	[GP_WIDGET_SWITCH]      = &gp_widget_switch_ops,
 	[GP_WIDGET_OVERLAY]     = &gp_widget_overlay_ops,
+	[GP_WIDGET_LIST]        = &gp_widget_list_ops,
 };
 
 const struct gp_widget_ops *gp_widget_ops(gp_widget *self)
@@ -91,6 +94,13 @@ const char *gp_widget_type_name(enum gp_widget_type type)
 	return widget_ops[type]->id;
 }
 
+static void free_child(gp_widget *self, void *priv)
+{
+	(void) priv;
+
+	gp_widget_free(self);
+}
+
 void gp_widget_free(gp_widget *self)
 {
 	const struct gp_widget_ops *ops;
@@ -98,50 +108,84 @@ void gp_widget_free(gp_widget *self)
 	if (!self)
 		return;
 
+	gp_widget_ops_for_each_child(self, free_child, NULL);
+
+	gp_widget_render_timer_cancel(self);
+	free(self->timer);
+
+	gp_widget_retain(self, 0);
+
 	ops = gp_widget_ops(self);
-	if (!ops->free)
-		free(self);
-	else
+	if (ops->free)
 		ops->free(self);
+
+	if (!self->arena)
+		free(self);
 }
 
-unsigned int gp_widget_min_w(gp_widget *self, const gp_widget_render_ctx *ctx)
+static gp_widget_layout_stats layout_stats = {
+	.gen = 1,
+};
+
+const gp_widget_layout_stats *gp_widget_layout_stats_get(void)
 {
-	const struct gp_widget_ops *ops;
+	return &layout_stats;
+}
 
-	if (!self)
-		return 0;
+static void layout_gen_inc(void)
+{
+	/* zero is reserved for never measured widgets */
+	if (!++layout_stats.gen)
+		layout_stats.gen = 1;
+}
 
-	if (self->no_resize)
-		return self->min_w;
+static void widget_measure(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	const struct gp_widget_ops *ops = gp_widget_ops(self);
 
-	ops = gp_widget_ops(self);
-	if (!ops->min_w) {
+	layout_stats.measure_calls++;
+
+	if (ops->min_w)
+		self->min_w = ops->min_w(self, ctx);
+	else
 		GP_WARN("%s->min_w() not implemented!", ops->id);
-		return 0;
-	}
 
-	self->min_w = ops->min_w(self, ctx);
-	return self->min_w;
+	if (ops->min_h)
+		self->min_h = ops->min_h(self, ctx);
+	else
+		GP_WARN("%s->min_h() not implemented!", ops->id);
+
+	self->min_gen = layout_stats.gen;
 }
 
-unsigned int gp_widget_min_h(gp_widget *self, const gp_widget_render_ctx *ctx)
+/*
+ * The cached minimal size is valid either if there was no change in the
+ * subtree or if the widget was measured already in this layout generation.
+ */
+static int min_size_valid(gp_widget *self)
 {
-	const struct gp_widget_ops *ops;
+	return self->no_resize || self->min_gen == layout_stats.gen;
+}
 
+unsigned int gp_widget_min_w(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
 	if (!self)
 		return 0;
 
-	if (self->no_resize)
-		return self->min_h;
+	if (!min_size_valid(self))
+		widget_measure(self, ctx);
 
-	ops = gp_widget_ops(self);
-	if (!ops->min_h) {
-		GP_WARN("%s->min_h() not implemented!", ops->id);
+	return self->min_w;
+}
+
+unsigned int gp_widget_min_h(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	if (!self)
 		return 0;
-	}
 
-	self->min_h = ops->min_h(self, ctx);
+	if (!min_size_valid(self))
+		widget_measure(self, ctx);
+
 	return self->min_h;
 }
 
@@ -185,13 +229,19 @@ static const char *valign_to_str(int align)
 	}
 }
 
-static void widget_resize(gp_widget *self,
-                          unsigned int w, unsigned int h)
+/*
+ * Places widget into w x h cell, returns non-zero if widget position or size
+ * has changed.
+ */
+static int widget_resize(gp_widget *self,
+                         unsigned int w, unsigned int h)
 {
 	unsigned int dw = w - self->min_w;
 	unsigned int dh = h - self->min_h;
-
-	self->redraw = 1;
+	unsigned int old_x = self->x;
+	unsigned int old_y = self->y;
+	unsigned int old_w = self->w;
+	unsigned int old_h = self->h;
 
 	switch (GP_HALIGN_MASK & self->align) {
 	case GP_HCENTER_WEAK:
@@ -235,19 +285,101 @@ static void widget_resize(gp_widget *self,
 	         self->min_w, self->min_h,
 		 halign_to_str(self->align), valign_to_str(self->align),
 		 w, h, self->x, self->y, self->w, self->h);
+
+	return self->x != old_x || self->y != old_y ||
+	       self->w != old_w || self->h != old_h;
 }
 
-void gp_widget_ops_distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx,
-                                   unsigned int w, unsigned int h,
-                                   int new_wh)
+struct children_check {
+	const gp_widget_render_ctx *ctx;
+	int min_changed;
+};
+
+static void child_min_changed(gp_widget *self, void *priv)
 {
-	const struct gp_widget_ops *ops = gp_widget_ops(self);
+	struct children_check *check = priv;
 
-	if (self->no_resize && !new_wh)
+	if (self->no_resize)
 		return;
 
+	/* Makes sure that min size was measured in this layout generation */
+	gp_widget_min_w(self, check->ctx);
+
+	/*
+	 * Compared with the size the parent layout was computed for, the min
+	 * size may have changed and changed back between two distributions.
+	 */
+	if (self->min_w != self->dist_min_w || self->min_h != self->dist_min_h)
+		check->min_changed = 1;
+}
+
+static int children_min_changed(gp_widget *self, const gp_widget_render_ctx *ctx)
+{
+	struct children_check check = {
+		.ctx = ctx,
+	};
+
+	gp_widget_ops_for_each_child(self, child_min_changed, &check);
+
+	return check.min_changed;
+}
+
+static void distribute_children(gp_widget *self, const gp_widget_render_ctx *ctx,
+                                int new_wh, int moved);
+
+static void child_min_distributed(gp_widget *self, void *priv)
+{
+	(void)priv;
+
+	self->dist_min_w = self->min_w;
+	self->dist_min_h = self->min_h;
+}
+
+static void relayout_dirty_child(gp_widget *self, void *ctx)
+{
+	if (self->no_resize)
+		return;
+
+	distribute_children(self, ctx, 0, 0);
+}
+
+static void distribute_children(gp_widget *self, const gp_widget_render_ctx *ctx,
+                                int new_wh, int moved)
+{
+	const struct gp_widget_ops *ops = gp_widget_ops(self);
+
 	self->no_resize = 1;
 
+	if (!ops->distribute_size)
+		goto done;
+
+	/*
+	 * If neither the container nor minimal sizes of its children has
+	 * changed the children stay where they are and we only descend into
+	 * subtrees that were marked for resize.
+	 */
+	if (!new_wh && !moved && !self->redistribute &&
+	    !children_min_changed(self, ctx)) {
+		gp_widget_ops_for_each_child(self, relayout_dirty_child, (void*)ctx);
+		goto done;
+	}
+
+	layout_stats.distribute_calls++;
+
+	ops->distribute_size(self, ctx, new_wh);
+
+	gp_widget_ops_for_each_child(self, child_min_distributed, NULL);
+
+	gp_widget_redraw(self);
+	gp_widget_redraw_children(self);
+done:
+	self->redistribute = 0;
+}
+
+void gp_widget_ops_distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx,
+                                   unsigned int w, unsigned int h,
+                                   int new_wh)
+{
 	if (self->min_w > w) {
 		GP_WARN("%p (%s) min_w=%u > w=%u",
 			self, gp_widget_type_id(self),
@@ -265,13 +397,35 @@ void gp_widget_ops_distribute_size(gp_widget *self, const gp_widget_render_ctx *
 	unsigned int old_w = self->w;
 	unsigned int old_h = self->h;
 
-	widget_resize(self, w, h);
+	int moved = widget_resize(self, w, h);
+
+	/* Nothing has changed in the subtree */
+	if (!moved && !new_wh && self->no_resize)
+		return;
 
 	if (self->w != old_w || self->h != old_h)
 		gp_widget_send_event(self, GP_WIDGET_EVENT_RESIZE, ctx);
 
-	if (ops->distribute_size)
-		ops->distribute_size(self, ctx, 1);
+	if (moved || new_wh)
+		gp_widget_redraw(self);
+
+	distribute_children(self, ctx, new_wh, moved);
+}
+
+void gp_widget_ops_for_each_child(gp_widget *self,
+                                  void (*func)(gp_widget *child, void *priv),
+                                  void *priv)
+{
+	const struct gp_widget_ops *ops;
+
+	if (!self)
+		return;
+
+	ops = gp_widget_ops(self);
+	if (!ops->for_each_child)
+		return;
+
+	ops->for_each_child(self, func, priv);
 }
 
 void gp_widget_calc_size(gp_widget *self, const gp_widget_render_ctx *ctx,
@@ -285,6 +439,9 @@ void gp_widget_calc_size(gp_widget *self, const gp_widget_render_ctx *ctx,
 
 	GP_DEBUG(1, "Recalculating layout %p", self);
 
+	unsigned long measure_calls = layout_stats.measure_calls;
+	unsigned long distribute_calls = layout_stats.distribute_calls;
+
 	gp_widget_min_w(self, ctx);
 	gp_widget_min_h(self, ctx);
 
@@ -296,6 +453,134 @@ void gp_widget_calc_size(gp_widget *self, const gp_widget_render_ctx *ctx,
 	h = GP_MAX(h, 1u);
 
 	gp_widget_ops_distribute_size(self, ctx, w, h, new_wh);
+
+	layout_stats.relayouts++;
+	layout_stats.last_measure_calls = layout_stats.measure_calls - measure_calls;
+	layout_stats.last_distribute_calls = layout_stats.distribute_calls - distribute_calls;
+
+	GP_DEBUG(1, "Layout %p recalculated, %u widgets measured, %u distributed",
+	         self, layout_stats.last_measure_calls,
+	         layout_stats.last_distribute_calls);
+}
+
+void gp_widget_retain(gp_widget *self, int retain)
+{
+	if (!retain) {
+		if (!self->retained)
+			return;
+
+		gp_widget_surface_cache_free(self->retained);
+		free(self->retained);
+		self->retained = NULL;
+		return;
+	}
+
+	if (self->retained)
+		return;
+
+	self->retained = calloc(1, sizeof(*self->retained));
+	if (!self->retained)
+		GP_WARN("Malloc failed :-(");
+}
+
+gp_bbox gp_widget_ops_surface_blit(const gp_widget_render_ctx *ctx,
+                                   const gp_pixmap *surface,
+                                   gp_coord x, gp_coord y, gp_bbox rect)
+{
+	gp_coord x0 = GP_MAX(x + rect.x, 0);
+	gp_coord y0 = GP_MAX(y + rect.y, 0);
+	gp_coord x1 = GP_MIN(x + rect.x + (gp_coord)rect.w, (gp_coord)gp_pixmap_w(ctx->buf));
+	gp_coord y1 = GP_MIN(y + rect.y + (gp_coord)rect.h, (gp_coord)gp_pixmap_h(ctx->buf));
+
+	if (ctx->bbox) {
+		x0 = GP_MAX(x0, ctx->bbox->x);
+		y0 = GP_MAX(y0, ctx->bbox->y);
+		x1 = GP_MIN(x1, ctx->bbox->x + (gp_coord)ctx->bbox->w);
+		y1 = GP_MIN(y1, ctx->bbox->y + (gp_coord)ctx->bbox->h);
+	}
+
+	if (x0 >= x1 || y0 >= y1)
+		return gp_bbox_pack(0, 0, 0, 0);
+
+	gp_blit_xywh(surface, x0 - x, y0 - y, x1 - x0, y1 - y0, ctx->buf, x0, y0);
+
+	return gp_bbox_pack(x0, y0, x1 - x0, y1 - y0);
+}
+
+/*
+ * Blits a part of the retained surface and marks it as damaged, the rectangle
+ * coordinates are relative to the surface.
+ */
+static void retained_blit(const gp_widget_render_ctx *ctx, const gp_pixmap *surface,
+                          gp_coord x, gp_coord y, gp_bbox rect)
+{
+	gp_bbox blit = gp_widget_ops_surface_blit(ctx, surface, x, y, rect);
+
+	if (gp_bbox_empty(blit))
+		return;
+
+	gp_widget_ops_blit(ctx, blit.x, blit.y, blit.w, blit.h);
+}
+
+/*
+ * Renders the dirty part of the subtree into the retained surface and blits
+ * the changes, or the whole surface if parent asked for a redraw.
+ *
+ * Returns zero if there is no surface and the widget has to be rendered
+ * directly.
+ */
+static int render_retained(gp_widget *self, const gp_offset *offset,
+                           const gp_widget_render_ctx *ctx, int flags)
+{
+	const struct gp_widget_ops *ops = gp_widget_ops(self);
+	gp_coord x = (gp_coord)self->x + offset->x;
+	gp_coord y = (gp_coord)self->y + offset->y;
+	gp_widget_render_ctx surface_ctx = *ctx;
+	gp_widget_damage damage;
+	gp_pixmap *surface;
+	int render_flags = 0;
+	unsigned int i;
+
+	gp_offset surface_offset = {
+		.x = -(gp_coord)self->x,
+		.y = -(gp_coord)self->y,
+	};
+
+	surface = gp_widget_surface_cache_get(self->retained, ctx, self->w, self->h);
+	if (!surface) {
+		surface = gp_widget_surface_cache_alloc(self->retained, ctx,
+		                                        self->w, self->h);
+		if (!surface)
+			return 0;
+
+		render_flags = GP_WIDGET_REDRAW;
+		flags = GP_WIDGET_REDRAW;
+	}
+
+	if (self->redraw_children) {
+		self->redraw_children = 0;
+		render_flags |= GP_WIDGET_REDRAW_CHILDREN;
+	}
+
+	gp_widget_damage_init(&damage, GP_WIDGET_DAMAGE_MAX,
+	                      ctx->flip ? ctx->flip->merge_dist : 0);
+
+	surface_ctx.buf = surface;
+	surface_ctx.bbox = NULL;
+	surface_ctx.flip = &damage;
+
+	if (render_flags || self->redraw || self->redraw_child)
+		ops->render(self, &surface_offset, &surface_ctx, render_flags);
+
+	if (flags & GP_WIDGET_REDRAW) {
+		retained_blit(ctx, surface, x, y, gp_bbox_pack(0, 0, self->w, self->h));
+		return 1;
+	}
+
+	for (i = 0; i < damage.cnt; i++)
+		retained_blit(ctx, surface, x, y, damage.rects[i]);
+
+	return 1;
 }
 
 void gp_widget_ops_render(gp_widget *self, const gp_offset *offset,
@@ -333,15 +618,21 @@ void gp_widget_ops_render(gp_widget *self, const gp_offset *offset,
 	         self, ops->id, self->type, x, y, self->x, self->y,
 	         self->w, self->h, flags);
 
+	if (self->retained && render_retained(self, offset, ctx, flags))
+		goto done;
+
 	if (self->redraw_children) {
 		self->redraw_children = 0;
 		flags |= GP_WIDGET_REDRAW_CHILDREN;
 	}
 
 	ops->render(self, offset, ctx, flags);
-
-	if (ctx->flip)
-		GP_DEBUG(3, "render bbox " GP_BBOX_FMT, GP_BBOX_PARS(*ctx->flip));
+done:
+	/* Merging the damage is not free, do it only when it's printed */
+	if (ctx->flip && gp_get_debug_level() >= 3) {
+		GP_DEBUG(3, "render damage %u rects bbox " GP_BBOX_FMT, ctx->flip->cnt,
+		         GP_BBOX_PARS(gp_widget_damage_bbox(ctx->flip)));
+	}
 
 	self->redraw = 0;
 	self->redraw_child = 0;
@@ -349,6 +640,70 @@ void gp_widget_ops_render(gp_widget *self, const gp_offset *offset,
 	//gp_rect_xywh(render->buf, x, y, self->w, self->h, 0x00ff00);
 }
 
+/*
+ * Adds damage, in the clipped buffer coordinates, clipped to the bbox to the
+ * parent damage list.
+ */
+static void blit_clip_damage(const gp_widget_render_ctx *ctx,
+                             const gp_widget_damage *damage,
+                             gp_coord x, gp_coord y, gp_bbox clip)
+{
+	unsigned int i;
+
+	for (i = 0; i < damage->cnt; i++) {
+		gp_bbox rect = damage->rects[i];
+
+		if (!gp_bbox_intersects(rect, clip))
+			continue;
+
+		rect = gp_bbox_intersection(rect, clip);
+
+		if (gp_bbox_empty(rect))
+			continue;
+
+		gp_widget_ops_blit(ctx, rect.x + x, rect.y + y, rect.w, rect.h);
+	}
+}
+
+void gp_widget_ops_render_clip(gp_widget *self, const gp_offset *offset,
+                               const gp_widget_render_ctx *ctx, int flags,
+                               gp_bbox rect, int blit_damage)
+{
+	gp_widget_render_ctx clip_ctx = *ctx;
+	gp_widget_damage damage;
+	gp_pixmap clip_buf;
+	gp_bbox clip_bbox = rect;
+
+	if (ctx->bbox) {
+		if (!gp_bbox_intersects(*ctx->bbox, rect))
+			return;
+
+		clip_bbox = gp_bbox_intersection(*ctx->bbox, rect);
+
+		if (gp_bbox_empty(clip_bbox))
+			return;
+	}
+
+	clip_bbox.x -= rect.x;
+	clip_bbox.y -= rect.y;
+
+	gp_sub_pixmap(ctx->buf, &clip_buf, rect.x, rect.y, rect.w, rect.h);
+
+	clip_ctx.bbox = &clip_bbox;
+	clip_ctx.buf = &clip_buf;
+	clip_ctx.flip = NULL;
+
+	if (ctx->flip && blit_damage) {
+		gp_widget_damage_init(&damage, ctx->flip->max, ctx->flip->merge_dist);
+		clip_ctx.flip = &damage;
+	}
+
+	gp_widget_ops_render(self, offset, &clip_ctx, flags);
+
+	if (clip_ctx.flip)
+		blit_clip_damage(ctx, &damage, rect.x, rect.y, clip_bbox);
+}
+
 static void focus_widget(gp_widget *self, int sel)
 {
 	if (!self)
@@ -543,16 +898,25 @@ int gp_widget_ops_event_offset(gp_widget *self, const gp_widget_render_ctx *ctx,
 void gp_widget_render(gp_widget *self, const gp_widget_render_ctx *ctx, int new_wh)
 {
 	GP_DEBUG(1, "rendering layout %p", self);
+
+	gp_widget_trace(GP_WIDGET_TRACE_LAYOUT, GP_WIDGET_TRACE_START, 0, 0, self);
+
 	gp_widget_calc_size(self, ctx,
 	                    gp_pixmap_w(ctx->buf),
 	                    gp_pixmap_h(ctx->buf), new_wh);
 
+	gp_widget_trace(GP_WIDGET_TRACE_LAYOUT, GP_WIDGET_TRACE_END, 0, 0, self);
+
 	gp_offset offset = {
 		.x = 0,
 		.y = 0,
 	};
 
+	gp_widget_trace(GP_WIDGET_TRACE_RENDER, GP_WIDGET_TRACE_START, 0, 0, self);
+
 	gp_widget_ops_render(self, &offset, ctx, 0);
+
+	gp_widget_trace(GP_WIDGET_TRACE_RENDER, GP_WIDGET_TRACE_END, 0, 0, self);
 }
 
 void gp_widget_redraw_child(gp_widget *self)
@@ -594,7 +958,7 @@ void gp_widget_redraw_children(gp_widget *self)
 	gp_widget_redraw_child(self);
 }
 
-void gp_widget_resize(gp_widget *self)
+static void mark_resize(gp_widget *self)
 {
 	if (!self)
 		return;
@@ -606,5 +970,36 @@ void gp_widget_resize(gp_widget *self)
 
 	self->no_resize = 0;
 
-	gp_widget_resize(self->parent);
+	mark_resize(self->parent);
+}
+
+static void subtree_no_resize_clear(gp_widget *self, void *priv)
+{
+	self->no_resize = 0;
+	self->redistribute = 1;
+
+	gp_widget_ops_for_each_child(self, subtree_no_resize_clear, priv);
+}
+
+void gp_widget_resize_subtree(gp_widget *self)
+{
+	if (!self)
+		return;
+
+	gp_widget_ops_for_each_child(self, subtree_no_resize_clear, NULL);
+
+	gp_widget_resize(self);
+}
+
+void gp_widget_resize(gp_widget *self)
+{
+	if (!self)
+		return;
+
+	/* Minimal sizes measured so far may depend on the changed widget */
+	layout_gen_inc();
+
+	self->redistribute = 1;
+
+	mark_resize(self);
 }
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <utils/gp_vec.h>
 
@@ -97,13 +96,48 @@ static void render(gp_widget *self, const gp_offset *offset,
 	}
 }
 
-static gp_widget *json_to_overlay(json_object *json, void **uids)
+static int stack_pos_is_invalid(gp_widget *self, unsigned int stack_pos)
+{
+	if (stack_pos >= gp_widget_overlay_widgets(self)) {
+		GP_WARN("Invalid stack_pos %u", stack_pos);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void json_hidden(gp_widget *self, const gp_bjson *hidden)
 {
-	json_object *widgets = NULL;
+	unsigned int i;
+
+	if (!gp_bjson_is_type(hidden, GP_BJSON_ARRAY)) {
+		GP_WARN("Hidden has to be array of integers!");
+		return;
+	}
 
-	json_object_object_foreach(json, key, val) {
+	for (i = 0; i < gp_bjson_len(hidden); i++) {
+		int pos = gp_bjson_int(gp_bjson_idx(hidden, i));
+
+		if (pos < 0 || stack_pos_is_invalid(self, pos))
+			continue;
+
+		self->overlay->stack[pos].hidden = 1;
+	}
+}
+
+static gp_widget *json_to_overlay(const gp_bjson *json, void **uids)
+{
+	const gp_bjson *widgets = NULL;
+	const gp_bjson *hidden = NULL;
+	int lazy = 0;
+
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "widgets"))
 			widgets = val;
+		else if (!strcmp(key, "hidden"))
+			hidden = val;
+		else if (!strcmp(key, "lazy"))
+			lazy = gp_bjson_bool(val);
 		else
 			GP_WARN("Invalid overlay key '%s'", key);
 	}
@@ -113,58 +147,66 @@ static gp_widget *json_to_overlay(json_object *json, void **uids)
 		return NULL;
 	}
 
-	if (!json_object_is_type(widgets, json_type_array)) {
+	if (!gp_bjson_is_type(widgets, GP_BJSON_ARRAY)) {
 		GP_WARN("Widgets has to be array of strings!");
 		return NULL;
 	}
 
-	unsigned int i, stack_size = json_object_array_length(widgets);
+	unsigned int i, stack_size = gp_bjson_len(widgets);
 
 	gp_widget *ret = gp_widget_overlay_new(stack_size);
 	if (!ret)
 		return NULL;
 
+	if (hidden)
+		json_hidden(ret, hidden);
+
 	for (i = 0; i < stack_size; i++) {
-		json_object *json_widget = json_object_array_get_idx(widgets, i);
+		struct gp_widget_overlay_elem *elem = &ret->overlay->stack[i];
+		const gp_bjson *json_widget = gp_bjson_idx(widgets, i);
 
-		ret->overlay->stack[i].widget = gp_widget_from_json(json_widget, uids);
+		if (lazy && elem->hidden) {
+			elem->lazy = gp_widget_lazy_new(json_widget, uids);
+			if (elem->lazy)
+				continue;
+		}
 
-		gp_widget_set_parent(ret->switch_->layouts[i], ret);
+		elem->widget = gp_widget_from_bjson(json_widget, uids);
+
+		gp_widget_set_parent(elem->widget, ret);
 	}
 
 	return ret;
 }
 
-static gp_widget *focus_widget_by_xy(gp_widget *self, unsigned int x, unsigned int y)
+static int widget_contains(gp_widget *widget, unsigned int x, unsigned int y)
 {
-	int i;
-
-	for (i = gp_widget_overlay_widgets(self) - 1; i > 0; i--) {
-		gp_widget *widget = self->overlay->stack[i].widget;
+	return x >= widget->x && y >= widget->y &&
+	       x < widget->x + widget->w &&
+	       y < widget->y + widget->h;
+}
 
-		if (!widget)
-			continue;
+static void for_each_child(gp_widget *self,
+                           void (*func)(gp_widget *child, void *priv),
+                           void *priv)
+{
+	unsigned int i;
+	struct gp_widget_overlay *o = self->overlay;
 
-		if (x >= widget->x && y >= widget->y &&
-		    x < widget->x + widget->w &&
-		    y < widget->y + widget->w) {
-			self->overlay->focused = i;
-			return widget;
-		}
+	for (i = 0; i < gp_widget_overlay_widgets(self); i++) {
+		if (o->stack[i].widget)
+			func(o->stack[i].widget, priv);
 	}
-
-	return NULL;
 }
 
 static void free_(gp_widget *self)
 {
 	unsigned int i;
-	struct gp_widget_overlay *o = self->overlay;
 
 	for (i = 0; i < gp_widget_overlay_widgets(self); i++)
-		gp_widget_free(o->stack[i].widget);
+		gp_widget_lazy_free(self->overlay->stack[i].lazy);
 
-	gp_vec_free(o->stack);
+	gp_vec_free(self->overlay->stack);
 }
 
 static int focus(gp_widget *self, int sel)
@@ -172,7 +214,7 @@ static int focus(gp_widget *self, int sel)
 	int i;
 
 	if (self->overlay->focused < 0) {
-		for (i = gp_widget_overlay_widgets(self) - 1; i > 0; i--) {
+		for (i = gp_widget_overlay_widgets(self) - 1; i >= 0; i--) {
 			gp_widget *widget = self->overlay->stack[i].widget;
 
 			if (self->overlay->stack[i].hidden)
@@ -191,21 +233,42 @@ static int focus(gp_widget *self, int sel)
 	return gp_widget_ops_render_focus(get_focused_widget(self), sel);
 }
 
+/*
+ * Passes the focus to the topmost visible widget under the cursor.
+ */
 static int focus_xy(gp_widget *self, const gp_widget_render_ctx *ctx,
                     unsigned int x, unsigned int y)
 {
-	gp_widget *widget = focus_widget_by_xy(self, x, y);
+	int i;
 
-	if (!widget)
-		return 0;
+	for (i = gp_widget_overlay_widgets(self) - 1; i >= 0; i--) {
+		gp_widget *widget = self->overlay->stack[i].widget;
 
-	return gp_widget_ops_render_focus_xy(widget, ctx, x, y);
+		if (!widget || self->overlay->stack[i].hidden)
+			continue;
+
+		if (!widget_contains(widget, x, y))
+			continue;
+
+		if (!gp_widget_ops_render_focus_xy(widget, ctx, x, y))
+			return 0;
+
+		if (self->overlay->focused != i)
+			gp_widget_ops_render_focus(get_focused_widget(self), GP_FOCUS_OUT);
+
+		self->overlay->focused = i;
+
+		return 1;
+	}
+
+	return 0;
 }
 
 struct gp_widget_ops gp_widget_overlay_ops = {
 	.min_w = min_w,
 	.min_h = min_h,
 	.distribute_size = distribute_size,
+	.for_each_child = for_each_child,
 	.event = event,
 	.focus = focus,
 	.focus_xy = focus_xy,
@@ -226,7 +289,7 @@ gp_widget *gp_widget_overlay_new(unsigned int stack_size)
 	ret->overlay->stack = gp_vec_new(stack_size, sizeof(struct gp_widget_overlay_elem));
 
 	if (!ret->overlay->stack) {
-		free(ret);
+		gp_widget_free(ret);
 		return NULL;
 	}
 
@@ -242,16 +305,6 @@ unsigned int gp_widget_overlay_widgets(gp_widget *self)
 	return gp_vec_len(self->overlay->stack);
 }
 
-static int stack_pos_is_invalid(gp_widget *self, unsigned int stack_pos)
-{
-	if (stack_pos >= gp_widget_overlay_widgets(self)) {
-		GP_WARN("Invalid stack_pos %u", stack_pos);
-		return 1;
-	}
-
-	return 0;
-}
-
 void gp_widget_overlay_hide(gp_widget *self, unsigned int stack_pos)
 {
 	struct gp_widget_overlay *o = self->overlay;
@@ -281,6 +334,15 @@ void gp_widget_overlay_show(gp_widget *self, unsigned int stack_pos)
 	if (!o->stack[stack_pos].hidden)
 		return;
 
+	if (o->stack[stack_pos].lazy) {
+		o->stack[stack_pos].widget = gp_widget_lazy_load(o->stack[stack_pos].lazy);
+		o->stack[stack_pos].lazy = NULL;
+
+		gp_widget_set_parent(o->stack[stack_pos].widget, self);
+
+		gp_widget_resize(self);
+	}
+
 	o->stack[stack_pos].hidden = 0;
 
 	gp_widget_redraw_children(self);
@@ -296,6 +358,9 @@ gp_widget *gp_widget_overlay_put(gp_widget *self, unsigned int stack_pos,
 	if (stack_pos_is_invalid(self, stack_pos))
 		return NULL;
 
+	gp_widget_lazy_free(self->overlay->stack[stack_pos].lazy);
+	self->overlay->stack[stack_pos].lazy = NULL;
+
 	ret = self->overlay->stack[stack_pos].widget;
 	self->overlay->stack[stack_pos].widget = child;
 
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
@@ -99,7 +98,7 @@ static int check_max(double max)
 	return 0;
 }
 
-static gp_widget *json_to_pbar(json_object *json, void **uids)
+static gp_widget *json_to_pbar(const gp_bjson *json, void **uids)
 {
 	double val = 0, max = 100;
 	const char *type = NULL;
@@ -108,15 +107,15 @@ static gp_widget *json_to_pbar(json_object *json, void **uids)
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, jval) {
+	gp_widget_json_foreach(json, key, jval) {
 		if (!strcmp(key, "val"))
-			val = json_object_get_double(jval);
+			val = gp_bjson_double(jval);
 		else if (!strcmp(key, "ptype"))
-			type = json_object_get_string(jval);
+			type = gp_bjson_str(jval);
 		else if (!strcmp(key, "max"))
-			max = json_object_get_double(jval);
+			max = gp_bjson_double(jval);
 		else if (!strcmp(key, "inverse"))
-			inverse = json_object_get_boolean(jval);
+			inverse = gp_bjson_bool(jval);
 		else
 			GP_WARN("Invalid int pbar '%s'", key);
 	}
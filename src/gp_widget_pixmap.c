@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
@@ -88,18 +87,18 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 	return 0;
 }
 
-static gp_widget *json_to_pixmap(json_object *json, void **uids)
+static gp_widget *json_to_pixmap(const gp_bjson *json, void **uids)
 {
 	unsigned int w = 0;
 	unsigned int h = 0;
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "w"))
-			w = json_object_get_int(val);
+			w = gp_bjson_int(val);
 		else if (!strcmp(key, "h"))
-			h = json_object_get_int(val);
+			h = gp_bjson_int(val);
 		else
 			GP_WARN("Invalid pixmap key '%s'", key);
 	}
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
@@ -159,18 +158,18 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 	return 0;
 }
 
-static gp_widget *json_to_radiobutton(json_object *json, void **uids)
+static gp_widget *json_to_radiobutton(const gp_bjson *json, void **uids)
 {
-	json_object *labels = NULL;
+	const gp_bjson *labels = NULL;
 	int sel_label = 0;
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "buttons"))
 			labels = val;
 		else if (!strcmp(key, "selected"))
-			sel_label = json_object_get_int(val);
+			sel_label = gp_bjson_int(val);
 		else
 			GP_WARN("Invalid radiobutton key '%s'", key);
 	}
@@ -180,12 +179,12 @@ static gp_widget *json_to_radiobutton(json_object *json, void **uids)
 		return NULL;
 	}
 
-	if (!json_object_is_type(labels, json_type_array)) {
+	if (!gp_bjson_is_type(labels, GP_BJSON_ARRAY)) {
 		GP_WARN("Buttons has to be array of strings!");
 		return NULL;
 	}
 
-	unsigned int i, label_cnt = json_object_array_length(labels);
+	unsigned int i, label_cnt = gp_bjson_len(labels);
 	const char *labels_arr[label_cnt];
 
 	if (sel_label < 0 || (unsigned int)sel_label >= label_cnt) {
@@ -194,8 +193,8 @@ static gp_widget *json_to_radiobutton(json_object *json, void **uids)
 	}
 
 	for (i = 0; i < label_cnt; i++) {
-		json_object *label = json_object_array_get_idx(labels, i);
-		labels_arr[i] = json_object_get_string(label);
+		const gp_bjson *label = gp_bjson_idx(labels, i);
+		labels_arr[i] = gp_bjson_str(label);
 
 		if (!labels_arr[i])
 			GP_WARN("Button %i must be string!", i);
@@ -0,0 +1,767 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include <core/gp_debug.h>
+#include <core/gp_common.h>
+#include <utils/gp_fds.h>
+
+#include <gp_widgets.h>
+#include <gp_widget_ops.h>
+#include <gp_widget_reload.h>
+#include "gp_clock.h"
+
+/*
+ * A subtree to be created again, replacements are applied only after the
+ * whole layout has been compared so that all UIDs of the removed widgets are
+ * dropped before UIDs of the new widgets are added.
+ */
+struct replace {
+	gp_widget *parent;
+	unsigned int idx;
+	const gp_bjson *old;
+	const gp_bjson *new;
+	gp_widget *widget;
+};
+
+/*
+ * UIDs removed before the replacements are built, restored if any of the
+ * replacements fails to build and the old layout is kept.
+ */
+struct removed_uid {
+	const char *uid;
+	gp_widget *widget;
+};
+
+/*
+ * An in-place change, either common keys to be applied to a widget or a
+ * deferred widget to be swapped for a new one. The changes are applied only
+ * after all replacements have been built so that a failed patch leaves the
+ * layout untouched.
+ */
+struct edit {
+	gp_widget *widget;
+	gp_widget_lazy **lazy;
+	const gp_bjson *json;
+	gp_widget_lazy *new_lazy;
+};
+
+struct patch {
+	void **uids;
+	struct replace *replaced;
+	unsigned int cnt;
+	unsigned int size;
+	struct edit *edits;
+	unsigned int edits_cnt;
+	unsigned int edits_size;
+	struct removed_uid *removed;
+	unsigned int removed_cnt;
+	unsigned int removed_size;
+	gp_widget_reload_stats stats;
+};
+
+static const char *json_type(const gp_bjson *json)
+{
+	const gp_bjson *type = gp_bjson_get(json, "type");
+
+	return type ? gp_bjson_str(type) : "grid";
+}
+
+static const char *json_uid(const gp_bjson *json)
+{
+	return gp_bjson_str(gp_bjson_get(json, "uid"));
+}
+
+static int str_equal(const char *a, const char *b)
+{
+	if (!a || !b)
+		return a == b;
+
+	return !strcmp(a, b);
+}
+
+/*
+ * Returns the key a container keeps its children JSON in, NULL for widgets
+ * without children.
+ */
+static const char *children_key(gp_widget *self)
+{
+	switch (self->type) {
+	case GP_WIDGET_GRID:
+	case GP_WIDGET_TABS:
+	case GP_WIDGET_SWITCH:
+	case GP_WIDGET_OVERLAY:
+		return "widgets";
+	case GP_WIDGET_FRAME:
+	case GP_WIDGET_SCROLL_AREA:
+		return "widget";
+	default:
+		return NULL;
+	}
+}
+
+static unsigned int children_cnt(const gp_bjson *children)
+{
+	if (gp_bjson_is_type(children, GP_BJSON_OBJECT))
+		return 1;
+
+	return gp_bjson_len(children);
+}
+
+static const gp_bjson *children_idx(const gp_bjson *children, unsigned int idx)
+{
+	if (gp_bjson_is_type(children, GP_BJSON_OBJECT))
+		return children;
+
+	return gp_bjson_idx(children, idx);
+}
+
+static gp_widget *child_get(gp_widget *self, unsigned int idx)
+{
+	switch (self->type) {
+	case GP_WIDGET_GRID:
+		return gp_widget_grid_get(self, idx / self->grid->rows,
+		                          idx % self->grid->rows);
+	case GP_WIDGET_TABS:
+		return self->tabs->widgets[idx];
+	case GP_WIDGET_SWITCH:
+		return self->switch_->layouts[idx];
+	case GP_WIDGET_OVERLAY:
+		return self->overlay->stack[idx].widget;
+	case GP_WIDGET_FRAME:
+		return self->frame->child;
+	case GP_WIDGET_SCROLL_AREA:
+		return self->scroll->child;
+	default:
+		return NULL;
+	}
+}
+
+static gp_widget *child_put(gp_widget *self, unsigned int idx, gp_widget *child)
+{
+	switch (self->type) {
+	case GP_WIDGET_GRID:
+		return gp_widget_grid_put(self, idx / self->grid->rows,
+		                          idx % self->grid->rows, child);
+	case GP_WIDGET_TABS:
+		return gp_widget_tabs_put(self, idx, child);
+	case GP_WIDGET_SWITCH:
+		return gp_widget_switch_put(self, idx, child);
+	case GP_WIDGET_OVERLAY:
+		return gp_widget_overlay_put(self, idx, child);
+	case GP_WIDGET_FRAME:
+		return gp_widget_frame_put(self, child);
+	case GP_WIDGET_SCROLL_AREA:
+		return gp_widget_scroll_area_put(self, child);
+	default:
+		return NULL;
+	}
+}
+
+static gp_widget_lazy **child_lazy(gp_widget *self, unsigned int idx)
+{
+	switch (self->type) {
+	case GP_WIDGET_TABS:
+		return self->tabs->lazy ? &self->tabs->lazy[idx] : NULL;
+	case GP_WIDGET_SWITCH:
+		return self->switch_->lazy ? &self->switch_->lazy[idx] : NULL;
+	case GP_WIDGET_OVERLAY:
+		return &self->overlay->stack[idx].lazy;
+	default:
+		return NULL;
+	}
+}
+
+static unsigned int child_slots(gp_widget *self)
+{
+	switch (self->type) {
+	case GP_WIDGET_GRID:
+		return self->grid->cols * self->grid->rows;
+	case GP_WIDGET_TABS:
+		return self->tabs->count;
+	case GP_WIDGET_SWITCH:
+		return gp_widget_switch_layouts(self);
+	case GP_WIDGET_OVERLAY:
+		return gp_widget_overlay_widgets(self);
+	case GP_WIDGET_FRAME:
+	case GP_WIDGET_SCROLL_AREA:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Compares the widget specific keys, i.e. all keys but the common ones and
+ * the key with the children.
+ */
+static int own_keys_equal(const gp_bjson *old, const gp_bjson *new,
+                          const char *children)
+{
+	unsigned int old_cnt = 0, new_cnt = 0;
+
+	gp_widget_json_foreach(old, key, val) {
+		if (children && !strcmp(key, children))
+			continue;
+
+		if (!gp_bjson_equal(val, gp_bjson_get(new, key)))
+			return 0;
+
+		old_cnt++;
+	}
+
+	gp_widget_json_foreach(new, key, val) {
+		if (children && !strcmp(key, children))
+			continue;
+
+		new_cnt++;
+	}
+
+	return old_cnt == new_cnt;
+}
+
+static int common_keys_equal(const gp_bjson *old, const gp_bjson *new)
+{
+	static const char *const keys[] = {
+		"align", "halign", "valign", "on_event", "retain"
+	};
+	unsigned int i;
+
+	for (i = 0; i < GP_ARRAY_SIZE(keys); i++) {
+		if (!gp_bjson_equal(gp_bjson_get(old, keys[i]), gp_bjson_get(new, keys[i])))
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Makes sure there is a space for one more element in an array, the parr is a
+ * pointer to the array pointer that is updated on reallocation.
+ */
+static int arr_reserve(void *parr, unsigned int cnt, unsigned int *size,
+                       size_t unit)
+{
+	unsigned int new_size;
+	void *arr;
+
+	if (cnt < *size)
+		return 0;
+
+	new_size = *size ? 2 * *size : 16;
+
+	memcpy(&arr, parr, sizeof(arr));
+
+	arr = realloc(arr, new_size * unit);
+	if (!arr) {
+		GP_WARN("Malloc failed :-(");
+		return 1;
+	}
+
+	memcpy(parr, &arr, sizeof(arr));
+	*size = new_size;
+
+	return 0;
+}
+
+static void replace(struct patch *p, gp_widget *parent, unsigned int idx,
+                    const gp_bjson *old, const gp_bjson *new)
+{
+	if (arr_reserve(&p->replaced, p->cnt, &p->size, sizeof(*p->replaced)))
+		return;
+
+	p->replaced[p->cnt++] = (struct replace) {
+		.parent = parent,
+		.idx = idx,
+		.old = old,
+		.new = new,
+	};
+}
+
+static void edit(struct patch *p, gp_widget *widget, gp_widget_lazy **lazy,
+                 const gp_bjson *json)
+{
+	if (arr_reserve(&p->edits, p->edits_cnt, &p->edits_size, sizeof(*p->edits)))
+		return;
+
+	p->edits[p->edits_cnt++] = (struct edit) {
+		.widget = widget,
+		.lazy = lazy,
+		.json = json,
+	};
+}
+
+/*
+ * Returns non-zero if the widget cannot be patched and has to be created
+ * again.
+ */
+static int diff(struct patch *p, gp_widget *self,
+                const gp_bjson *old, const gp_bjson *new)
+{
+	const gp_bjson *old_children, *new_children;
+	const char *children;
+	unsigned int i, cnt;
+
+	if (!self)
+		return 1;
+
+	if (gp_bjson_get(old, "call") || gp_bjson_get(new, "call"))
+		return 1;
+
+	if (!str_equal(json_type(old), json_type(new)) ||
+	    !str_equal(json_uid(old), json_uid(new)))
+		return 1;
+
+	children = children_key(self);
+
+	if (!own_keys_equal(old, new, children))
+		return 1;
+
+	if (children) {
+		old_children = gp_bjson_get(old, children);
+		new_children = gp_bjson_get(new, children);
+
+		if (gp_bjson_type(old_children) != gp_bjson_type(new_children))
+			return 1;
+
+		cnt = children_cnt(old_children);
+
+		if (cnt != children_cnt(new_children) || cnt > child_slots(self))
+			return 1;
+
+		for (i = 0; i < cnt; i++) {
+			const gp_bjson *old_child = children_idx(old_children, i);
+			const gp_bjson *new_child = children_idx(new_children, i);
+			gp_widget_lazy **lazy;
+
+			if (gp_bjson_equal(old_child, new_child)) {
+				p->stats.kept++;
+				continue;
+			}
+
+			lazy = child_lazy(self, i);
+
+			if (lazy && *lazy) {
+				edit(p, NULL, lazy, new_child);
+				p->stats.rebuilt++;
+				continue;
+			}
+
+			if (diff(p, child_get(self, i), old_child, new_child))
+				replace(p, self, i, old_child, new_child);
+		}
+	}
+
+	if (common_keys_equal(old, new)) {
+		p->stats.kept++;
+		return 0;
+	}
+
+	edit(p, self, NULL, new);
+	p->stats.patched++;
+
+	return 0;
+}
+
+static void uid_removed(struct patch *p, const char *uid, gp_widget *widget)
+{
+	if (arr_reserve(&p->removed, p->removed_cnt, &p->removed_size,
+	                sizeof(*p->removed)))
+		return;
+
+	p->removed[p->removed_cnt++] = (struct removed_uid) {
+		.uid = uid,
+		.widget = widget,
+	};
+}
+
+/*
+ * Removes UIDs of a subtree, the removed UIDs are recorded if p is not NULL.
+ */
+static void uids_remove(void **uids, const gp_bjson *json, struct patch *p)
+{
+	const char *uid;
+
+	if (!gp_bjson_is_type(json, GP_BJSON_OBJECT))
+		return;
+
+	uid = json_uid(json);
+	if (uid) {
+		gp_widget *widget = gp_htable_rem(*uids, uid);
+
+		if (widget && p)
+			uid_removed(p, uid, widget);
+	}
+
+	gp_bjson_foreach(json, key, val) {
+		if (!strcmp(key, "widget")) {
+			uids_remove(uids, val, p);
+			continue;
+		}
+
+		if (!strcmp(key, "widgets")) {
+			unsigned int i;
+
+			for (i = 0; i < gp_bjson_len(val); i++)
+				uids_remove(uids, gp_bjson_idx(val, i), p);
+		}
+	}
+}
+
+static void uids_restore(struct patch *p)
+{
+	unsigned int i;
+
+	for (i = 0; i < p->removed_cnt; i++) {
+		char *uid = strdup(p->removed[i].uid);
+
+		if (!uid) {
+			GP_WARN("Malloc failed :-(");
+			continue;
+		}
+
+		gp_htable_put(*p->uids, p->removed[i].widget, uid);
+	}
+}
+
+/*
+ * Empty objects, e.g. empty grid cells, are valid and create no widget.
+ */
+static int json_empty(const gp_bjson *json)
+{
+	return !gp_bjson_is_type(json, GP_BJSON_OBJECT) || !gp_bjson_len(json);
+}
+
+static void lazies_free(struct patch *p)
+{
+	unsigned int i;
+
+	for (i = 0; i < p->edits_cnt; i++)
+		gp_widget_lazy_free(p->edits[i].new_lazy);
+}
+
+/*
+ * Creates all replacements and new deferred widgets, returns non-zero and
+ * frees whatever was created if any of them fails, in which case the layout
+ * is left untouched.
+ */
+static int replacements_build(struct patch *p)
+{
+	int uids = p->uids && *p->uids;
+	unsigned int i;
+
+	for (i = 0; i < p->edits_cnt; i++) {
+		struct edit *e = &p->edits[i];
+
+		if (!e->lazy)
+			continue;
+
+		e->new_lazy = gp_widget_lazy_new(e->json, p->uids);
+		if (!e->new_lazy) {
+			lazies_free(p);
+			return 1;
+		}
+	}
+
+	if (uids) {
+		for (i = 0; i < p->cnt; i++)
+			uids_remove(p->uids, p->replaced[i].old, p);
+	}
+
+	for (i = 0; i < p->cnt; i++) {
+		struct replace *r = &p->replaced[i];
+
+		r->widget = gp_widget_layout_from_bjson(r->new, p->uids);
+
+		if (!r->widget && !json_empty(r->new))
+			goto err;
+	}
+
+	return 0;
+err:
+	/* the failed subtree may have registered some UIDs as well */
+	do {
+		struct replace *r = &p->replaced[i];
+
+		if (p->uids && *p->uids)
+			uids_remove(p->uids, r->new, NULL);
+
+		gp_widget_free(r->widget);
+	} while (i--);
+
+	if (uids)
+		uids_restore(p);
+
+	lazies_free(p);
+
+	return 1;
+}
+
+static void edits_apply(struct patch *p)
+{
+	unsigned int i;
+
+	for (i = 0; i < p->edits_cnt; i++) {
+		struct edit *e = &p->edits[i];
+
+		if (!e->lazy) {
+			gp_widget_json_apply_common(e->widget, e->json);
+			continue;
+		}
+
+		gp_widget_lazy_free(*e->lazy);
+		*e->lazy = e->new_lazy;
+	}
+}
+
+gp_widget *gp_widget_layout_patch(gp_widget *layout, const gp_bjson *old,
+                                  const gp_bjson *new, void **uids,
+                                  gp_widget_reload_stats *stats)
+{
+	struct patch p = {.uids = uids};
+	gp_widget *ret = layout;
+	unsigned int i;
+
+	if (gp_bjson_equal(old, new)) {
+		p.stats.kept++;
+		goto exit;
+	}
+
+	if (diff(&p, layout, old, new))
+		replace(&p, NULL, 0, old, new);
+
+	if (replacements_build(&p)) {
+		GP_WARN("Failed to create the new layout, keeping the old one");
+		ret = NULL;
+		goto free;
+	}
+
+	edits_apply(&p);
+
+	for (i = 0; i < p.cnt; i++) {
+		struct replace *r = &p.replaced[i];
+
+		p.stats.rebuilt++;
+
+		if (!r->parent) {
+			gp_widget_free(layout);
+			ret = r->widget;
+			continue;
+		}
+
+		gp_widget *prev = child_put(r->parent, r->idx, r->widget);
+
+		if (prev)
+			prev->parent = NULL;
+
+		gp_widget_free(prev);
+
+		gp_widget_redraw_children(r->parent);
+	}
+
+	GP_DEBUG(1, "Layout patched: %u kept, %u patched, %u rebuilt",
+	         p.stats.kept, p.stats.patched, p.stats.rebuilt);
+free:
+	free(p.replaced);
+	free(p.removed);
+	free(p.edits);
+exit:
+	if (stats)
+		*stats = p.stats;
+
+	return ret;
+}
+
+struct watch {
+	char *path;
+	/* file name in the watched directory */
+	const char *name;
+	void **uids;
+	gp_widget *layout;
+	gp_bjson_hdr *json;
+	int fd;
+	struct watch *next;
+};
+
+static struct watch *watches;
+
+static void watch_reload(struct watch *self)
+{
+	uint64_t start = gp_clock_us();
+	gp_bjson_hdr *json;
+	gp_widget *layout;
+
+	json = gp_widget_layout_compile(self->path);
+	if (!json) {
+		GP_WARN("Failed to reload '%s', keeping the old layout", self->path);
+		return;
+	}
+
+	layout = gp_widget_layout_patch(self->layout, gp_bjson_root(self->json),
+	                                gp_bjson_root(json), self->uids, NULL);
+	if (!layout) {
+		free(json);
+		return;
+	}
+
+	if (layout != self->layout) {
+		gp_widget_layout_replace(layout);
+		self->layout = layout;
+	}
+
+	free(self->json);
+	self->json = json;
+
+	GP_DEBUG(1, "Layout '%s' reloaded in %lluus", self->path,
+	         (unsigned long long)(gp_clock_us() - start));
+}
+
+static int watch_event(struct gp_fd *self, struct pollfd *pfd)
+{
+	struct watch *watch = self->priv;
+	long buf[1024];
+	ssize_t size;
+	int changed = 0;
+
+	while ((size = read(pfd->fd, buf, sizeof(buf))) > 0) {
+		char *pos = (char *)buf;
+
+		while (pos < (char *)buf + size) {
+			struct inotify_event *ev = (void *)pos;
+
+			if (ev->len && !strcmp(ev->name, watch->name))
+				changed = 1;
+
+			pos += sizeof(*ev) + ev->len;
+		}
+	}
+
+	if (changed)
+		watch_reload(watch);
+
+	return 0;
+}
+
+/*
+ * The directory is watched rather than the file itself since editors tend to
+ * replace the file by renaming a new one over it.
+ */
+static int watch_start(struct watch *self)
+{
+	char *slash = strrchr(self->path, '/');
+	const char *dir = ".";
+	int fd, ret;
+
+	fd = inotify_init1(IN_NONBLOCK);
+	if (fd < 0) {
+		GP_WARN("inotify_init(): %s", strerror(errno));
+		return 1;
+	}
+
+	if (slash) {
+		*slash = 0;
+		dir = slash == self->path ? "/" : self->path;
+	}
+
+	ret = inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+
+	if (slash)
+		*slash = '/';
+
+	if (ret < 0) {
+		GP_WARN("inotify_add_watch(): %s", strerror(errno));
+		close(fd);
+		return 1;
+	}
+
+	self->name = slash ? slash + 1 : self->path;
+	self->fd = fd;
+
+	gp_fds_add(gp_widgets_fds, fd, POLLIN, watch_event, self);
+
+	self->next = watches;
+	watches = self;
+
+	return 0;
+}
+
+static void watch_free(struct watch *self)
+{
+	free(self->json);
+	free(self->path);
+	free(self);
+}
+
+gp_widget *gp_widget_layout_json_watch(const char *path, void **uids)
+{
+	struct watch *watch;
+
+	if (uids)
+		*uids = NULL;
+
+	watch = calloc(1, sizeof(*watch));
+	if (!watch) {
+		GP_WARN("Malloc failed :-(");
+		return NULL;
+	}
+
+	watch->path = strdup(path);
+	if (!watch->path) {
+		GP_WARN("Malloc failed :-(");
+		goto err;
+	}
+
+	watch->json = gp_widget_layout_compile(path);
+	if (!watch->json)
+		goto err;
+
+	watch->uids = uids;
+	watch->layout = gp_widget_layout_from_bjson(gp_bjson_root(watch->json), uids);
+
+	if (!watch->layout)
+		goto err;
+
+	if (watch_start(watch)) {
+		gp_widget *ret = watch->layout;
+
+		GP_WARN("Failed to watch '%s', reload disabled", path);
+		watch_free(watch);
+		return ret;
+	}
+
+	return watch->layout;
+err:
+	watch_free(watch);
+	return NULL;
+}
+
+void gp_widget_layout_unwatch(gp_widget *layout)
+{
+	struct watch **i;
+
+	for (i = &watches; *i; i = &(*i)->next) {
+		struct watch *watch = *i;
+
+		if (watch->layout != layout)
+			continue;
+
+		*i = watch->next;
+
+		gp_fds_rem(gp_widgets_fds, watch->fd);
+		close(watch->fd);
+		watch_free(watch);
+		return;
+	}
+
+	GP_WARN("Layout %p is not watched", layout);
+}
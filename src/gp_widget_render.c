@@ -7,6 +7,7 @@
  */
 
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <core/gp_debug.h>
@@ -17,6 +18,11 @@
 #include <gp_widget_render.h>
 #include <gp_widget_ops.h>
 #include <gp_key_repeat_timer.h>
+#include <gp_widget_trace.h>
+#include <gp_widget_timer.h>
+#include <gp_widget_kinetic.h>
+#include <gp_text_cache.h>
+#include <gp_widget_surface_cache.h>
 
 static struct gp_text_style font = {
 	.pixel_xmul = 1,
@@ -57,6 +63,9 @@ static struct gp_widget_render_ctx ctx = {
 
 static gp_pixel fill_color;
 
+static unsigned int damage_max_rects = 8;
+static gp_size damage_merge_dist = 16;
+
 static int font_size = 16;
 static gp_font_face *render_font;
 static gp_font_face *render_font_bold;
@@ -172,6 +181,8 @@ static void init_fonts(void)
 void gp_widget_render_init(void)
 {
 	init_fonts();
+	gp_text_cache_flush();
+	gp_widget_surface_cache_flush();
 
 	ctx.padd = 2 * gp_text_descent(ctx.font);
 }
@@ -187,69 +198,77 @@ void gp_widget_render_zoom(int zoom_inc)
 	font_size += zoom_inc;
 
 	gp_widget_render_init();
-	gp_widget_resize(app_layout);
+	gp_widget_resize_subtree(app_layout);
 	gp_widget_redraw(app_layout);
 }
 
-static void timer_event(gp_event *ev)
+static uint32_t timer_callback(gp_timer *self)
 {
-	struct gp_widget *widget = ev->tmr->priv;
+	gp_widget *widget = self->priv;
+	gp_event ev = {
+		.type = GP_EV_TMR,
+		.tmr = self,
+	};
+
+	widget->timer_running = 0;
 
-	gp_widget_ops_event(widget, &ctx, ev);
+	gp_widget_ops_event(widget, &ctx, &ev);
 
-	ev->tmr->priv = NULL;
+	return 0;
 }
 
-static struct gp_timer timers[10];
+static gp_timer *widget_timer(gp_widget *self)
+{
+	if (self->timer)
+		return self->timer;
+
+	self->timer = calloc(1, sizeof(gp_timer));
+	if (!self->timer) {
+		GP_WARN("Failed to allocate timer for widget %p (%s)",
+		        self, gp_widget_type_id(self));
+		return NULL;
+	}
+
+	self->timer->id = gp_widget_type_id(self);
+	self->timer->priv = self;
+	self->timer->callback = timer_callback;
+
+	return self->timer;
+}
 
 void gp_widget_render_timer(gp_widget *self, int flags, unsigned int timeout_ms)
 {
-	unsigned int i;
-
-	for (i = 0; i < GP_ARRAY_SIZE(timers); i++) {
-		if (timers[i].priv == self) {
-			if (flags & GP_TIMER_RESCHEDULE) {
-				gp_backend_rem_timer(backend, &timers[i]);
-				timers[i].expires = timeout_ms;
-				gp_backend_add_timer(backend, &timers[i]);
-				return;
-			}
+	gp_timer *timer;
 
+	if (self->timer_running) {
+		if (!(flags & GP_TIMER_RESCHEDULE)) {
 			GP_WARN("Timer for widget %p (%s) allready running!",
 			        self, gp_widget_type_id(self));
 			return;
 		}
 
-		if (!timers[i].priv)
-			break;
+		gp_widgets_timer_rem(self->timer);
+		self->timer_running = 0;
 	}
 
-	if (i >= GP_ARRAY_SIZE(timers)) {
-		GP_WARN("All %zu timers used!", GP_ARRAY_SIZE(timers));
-		gp_timer_queue_dump(backend->timers);
-	}
+	timer = widget_timer(self);
+	if (!timer)
+		return;
 
-	timers[i].expires = timeout_ms;
-	timers[i].id = gp_widget_type_id(self);
-	timers[i].priv = self;
+	timer->expires = timeout_ms;
+	timer->period = 0;
 
-	gp_backend_add_timer(backend, &timers[i]);
+	gp_widgets_timer_ins(timer);
+	self->timer_running = 1;
 }
 
 void gp_widget_render_timer_cancel(gp_widget *self)
 {
-	unsigned int i;
-
-	for (i = 0; i < GP_ARRAY_SIZE(timers); i++) {
-		if (timers[i].priv == self) {
-			gp_backend_rem_timer(backend, &timers[i]);
-			timers[i].priv = NULL;
-			return;
-		}
+	if (!self->timer_running)
+		return;
 
-		if (!timers[i].priv)
-			break;
-	}
+	gp_widgets_timer_rem(self->timer);
+	self->timer_running = 0;
 }
 
 void gp_widgets_redraw(struct gp_widget *layout)
@@ -259,8 +278,10 @@ void gp_widgets_redraw(struct gp_widget *layout)
 		return;
 	}
 
-	if (!layout->redraw && !layout->redraw_child)
+	if (!layout->redraw && !layout->redraw_child) {
+		gp_widget_kinetic_frame_end();
 		return;
+	}
 
 	if (gp_pixmap_w(backend->pixmap) < layout->w ||
 	    gp_pixmap_h(backend->pixmap) < layout->h) {
@@ -271,24 +292,53 @@ void gp_widgets_redraw(struct gp_widget *layout)
 	    gp_pixmap_h(backend->pixmap) == 0)
 		return;
 
-	gp_bbox flip = {};
+	gp_widget_damage flip;
+	unsigned int i;
+
+	gp_widget_damage_init(&flip, damage_max_rects, damage_merge_dist);
 
 	ctx.flip = &flip;
 	gp_widget_render(layout, &ctx, 0);
 	ctx.flip = NULL;
 
-	if (gp_bbox_empty(flip))
-		return;
+	gp_widget_trace(GP_WIDGET_TRACE_FLIP, 0, 0, flip.cnt, layout);
+
+	for (i = 0; i < flip.cnt; i++) {
+		gp_bbox *rect = &flip.rects[i];
 
-	GP_DEBUG(1, "Updating area " GP_BBOX_FMT, GP_BBOX_PARS(flip));
+		GP_DEBUG(1, "Updating area " GP_BBOX_FMT, GP_BBOX_PARS(*rect));
+
+		gp_backend_update_rect_xywh(backend, rect->x, rect->y, rect->w, rect->h);
+	}
 
-	gp_backend_update_rect_xywh(backend, flip.x, flip.y, flip.w, flip.h);
+	gp_widget_kinetic_frame_end();
+}
+
+void gp_widgets_damage_set(unsigned int max_rects, gp_size merge_dist)
+{
+	damage_max_rects = max_rects;
+	damage_merge_dist = merge_dist;
 }
 
 static char *backend_init_str = "x11";
 
 void gp_widget_timer_queue_switch(gp_timer **);
 
+static void render_ctx_init(gp_pixmap *buf)
+{
+	ctx.buf = buf;
+	ctx.pixel_type = buf->pixel_type;
+
+	ctx.bg_color = gp_rgb_to_pixmap_pixel(0xdd, 0xdd, 0xdd, ctx.buf);
+	ctx.fg_color = gp_rgb_to_pixmap_pixel(0xee, 0xee, 0xee, ctx.buf);
+	ctx.fg2_color = gp_rgb_to_pixmap_pixel(0x77, 0xbb, 0xff, ctx.buf);
+	ctx.sel_color = gp_rgb_to_pixmap_pixel(0x11, 0x99, 0xff, ctx.buf);
+	ctx.alert_color = gp_rgb_to_pixmap_pixel(0xff, 0x55, 0x55, ctx.buf);
+	fill_color = gp_rgb_to_pixmap_pixel(0x44, 0x44, 0x44, ctx.buf);
+
+	gp_widget_surface_cache_flush();
+}
+
 void gp_widgets_layout_init(gp_widget *layout, const char *win_tittle)
 {
 	gp_widget_render_init();
@@ -301,15 +351,7 @@ void gp_widgets_layout_init(gp_widget *layout, const char *win_tittle)
 
 	gp_key_repeat_timer_init(&backend->event_queue, &backend->timers);
 
-	ctx.buf = backend->pixmap;
-	ctx.pixel_type = backend->pixmap->pixel_type;
-
-	ctx.bg_color = gp_rgb_to_pixmap_pixel(0xdd, 0xdd, 0xdd, ctx.buf);
-	ctx.fg_color = gp_rgb_to_pixmap_pixel(0xee, 0xee, 0xee, ctx.buf);
-	ctx.fg2_color = gp_rgb_to_pixmap_pixel(0x77, 0xbb, 0xff, ctx.buf);
-	ctx.sel_color = gp_rgb_to_pixmap_pixel(0x11, 0x99, 0xff, ctx.buf);
-	ctx.alert_color = gp_rgb_to_pixmap_pixel(0xff, 0x55, 0x55, ctx.buf);
-	fill_color = gp_rgb_to_pixmap_pixel(0x44, 0x44, 0x44, ctx.buf);
+	render_ctx_init(backend->pixmap);
 
 	gp_widget_calc_size(layout, &ctx, 0, 0, 1);
 
@@ -333,6 +375,72 @@ void gp_widgets_layout_init(gp_widget *layout, const char *win_tittle)
 	gp_backend_flip(backend);
 }
 
+const gp_widget_render_ctx *gp_widgets_offscreen_init(gp_pixel_type pixel_type)
+{
+	gp_pixmap *buf;
+
+	if (backend) {
+		GP_WARN("Backend already initialized!");
+		return NULL;
+	}
+
+	buf = gp_pixmap_alloc(1, 1, pixel_type);
+	if (!buf) {
+		GP_WARN("Failed to allocate offscreen pixmap");
+		return NULL;
+	}
+
+	gp_widget_render_init();
+
+	gp_pixmap_free(ctx.buf);
+	render_ctx_init(buf);
+
+	return &ctx;
+}
+
+gp_pixmap *gp_widgets_offscreen_render(gp_widget *layout,
+                                       gp_widget_damage *damage, int new_wh)
+{
+	if (!layout || backend)
+		return NULL;
+
+	gp_widget_calc_size(layout, &ctx, gp_pixmap_w(ctx.buf),
+	                    gp_pixmap_h(ctx.buf), new_wh);
+
+	if (gp_pixmap_w(ctx.buf) != layout->w ||
+	    gp_pixmap_h(ctx.buf) != layout->h) {
+		gp_pixmap *buf = gp_pixmap_alloc(layout->w, layout->h, ctx.pixel_type);
+
+		if (!buf) {
+			GP_WARN("Failed to allocate offscreen pixmap %ux%u",
+			        layout->w, layout->h);
+			return NULL;
+		}
+
+		gp_pixmap_free(ctx.buf);
+		ctx.buf = buf;
+		gp_fill(ctx.buf, fill_color);
+		new_wh = 1;
+	}
+
+	ctx.flip = damage;
+	gp_widget_render(layout, &ctx, new_wh);
+	ctx.flip = NULL;
+
+	gp_widget_kinetic_frame_end();
+
+	return ctx.buf;
+}
+
+void gp_widgets_offscreen_exit(void)
+{
+	if (backend)
+		return;
+
+	gp_pixmap_free(ctx.buf);
+	ctx.buf = NULL;
+}
+
 const gp_widget_render_ctx *gp_widgets_render_ctx(void)
 {
 	return &ctx;
@@ -391,9 +499,10 @@ int gp_widgets_event(gp_event *ev, gp_widget *layout)
 		}
 	break;
 	case GP_EV_TMR:
-		timer_event(ev);
-		handled = 1;
-	break;
+		/* Widget timers have callbacks, this is an application timer */
+		if (app_event_callback)
+			app_event_callback(ev);
+		return 0;
 	}
 
 	if (handled)
@@ -410,19 +519,97 @@ int gp_widgets_event(gp_event *ev, gp_widget *layout)
 	return 0;
 }
 
-int gp_widgets_process_events(gp_widget *layout)
+#define EVENT_BATCH 64
+
+static unsigned long events_merged;
+
+unsigned long gp_widgets_events_merged(void)
+{
+	return events_merged;
+}
+
+static int is_rel_pos(gp_event *ev)
+{
+	return ev->type == GP_EV_REL && ev->code == GP_EV_REL_POS;
+}
+
+static int is_resize(gp_event *ev)
+{
+	return ev->type == GP_EV_SYS && ev->code == GP_EV_SYS_RESIZE;
+}
+
+/*
+ * Merges consecutive relative pointer motions and drops all but the last
+ * resize in the batch, the order of the rest of the events is preserved.
+ *
+ * Returns number of events left in the batch.
+ */
+static unsigned int coalesce_events(gp_event *evs, unsigned int cnt)
 {
-	gp_event ev;
-
-	while (gp_backend_poll_event(backend, &ev)) {
-		gp_event_dump(&ev);
-		fflush(stdout);
-		if (gp_widgets_event(&ev, layout)) {
-			gp_backend_exit(backend);
-			exit(0);
+	unsigned int i, ret = 0;
+	int last_resize = -1;
+
+	for (i = 0; i < cnt; i++) {
+		if (is_resize(&evs[i]))
+			last_resize = i;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		gp_event *ev = &evs[i];
+
+		if (is_resize(ev) && (int)i != last_resize)
+			continue;
+
+		if (ret && is_rel_pos(ev) && is_rel_pos(&evs[ret-1])) {
+			gp_event *prev = &evs[ret-1];
+			int32_t rx = prev->rel.rx + ev->rel.rx;
+			int32_t ry = prev->rel.ry + ev->rel.ry;
+
+			*prev = *ev;
+			prev->rel.rx = rx;
+			prev->rel.ry = ry;
+			continue;
 		}
+
+		if (ret != i)
+			evs[ret] = *ev;
+
+		ret++;
 	}
 
+	return ret;
+}
+
+int gp_widgets_process_events(gp_widget *layout)
+{
+	gp_event evs[EVENT_BATCH];
+	unsigned int i, polled, cnt;
+
+	do {
+		for (polled = 0; polled < EVENT_BATCH; polled++) {
+			if (!gp_backend_poll_event(backend, &evs[polled]))
+				break;
+		}
+
+		cnt = coalesce_events(evs, polled);
+
+		if (cnt != polled) {
+			GP_DEBUG(4, "Merged %u input events", polled - cnt);
+			events_merged += polled - cnt;
+		}
+
+		for (i = 0; i < cnt; i++) {
+			gp_event *ev = &evs[i];
+
+			gp_widget_trace(GP_WIDGET_TRACE_INPUT, ev->type, ev->code, ev->val, NULL);
+
+			if (gp_widgets_event(ev, layout)) {
+				gp_backend_exit(backend);
+				exit(0);
+			}
+		}
+	} while (polled == EVENT_BATCH);
+
 	return 0;
 }
 
@@ -432,6 +619,8 @@ static void print_options(int exit_val)
 	printf("\t-b backend init string (pass -b help for options)\n");
 	printf("\t-f fonts\n\t\tdefault\n\t\thaxor-15\n\t\thaxor-16\n\t\thaxor-17\n");
 	printf("\t-i input_string\n");
+	printf("\t-t trace buffer size, trace is printed on exit\n");
+	printf("\t-c surface cache budget in kB\n");
 	exit(exit_val);
 }
 
@@ -439,11 +628,14 @@ void gp_widgets_getopt(int *argc, char **argv[])
 {
 	int opt;
 
-	while ((opt = getopt(*argc, *argv, "b:f:hi:")) != -1) {
+	while ((opt = getopt(*argc, *argv, "b:c:f:hi:t:")) != -1) {
 		switch (opt) {
 		case 'b':
 			backend_init_str = optarg;
 		break;
+		case 'c':
+			gp_widget_surface_cache_budget_set(1024 * (size_t)atoi(optarg));
+		break;
 		case 'h':
 			print_options(0);
 		break;
@@ -453,6 +645,9 @@ void gp_widgets_getopt(int *argc, char **argv[])
 		case 'i':
 			input_str = optarg;
 		break;
+		case 't':
+			gp_widget_trace_init(atoi(optarg), 1);
+		break;
 		default:
 			print_options(1);
 		}
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
@@ -177,19 +176,106 @@ static void draw_horiz_scroll_bar(gp_widget *self, const gp_widget_render_ctx *c
 	gp_fill_rrect_xywh(ctx->buf, x + pos, y + ctx->padd, asc, asc, ctx->bg_color, ctx->fg_color, col);
 }
 
-static void render(gp_widget *self, const gp_offset *offset,
-                   const gp_widget_render_ctx *ctx, int flags)
+static void for_each_child(gp_widget *self,
+                           void (*func)(gp_widget *child, void *priv),
+                           void *priv)
+{
+	if (self->scroll->child)
+		func(self->scroll->child, priv);
+}
+
+/*
+ * Renders the child into a rectangle inside of the scroll area viewport.
+ *
+ * The x, y coordinates are relative to the viewport top left corner.
+ *
+ * Unless the whole scroll area is repainted, the child damage is passed to
+ * the parent clipped to the rectangle and the parent bbox.
+ */
+static void render_child(gp_widget *self, const gp_offset *offset,
+                         const gp_widget_render_ctx *ctx, int flags,
+                         gp_coord x, gp_coord y, gp_size w, gp_size h)
 {
 	struct gp_widget_scroll_area *area = self->scroll;
-	gp_widget_render_ctx child_ctx = *ctx;
-	gp_pixmap child_buf;
 	gp_offset child_offset = {
-		.x = -area->x_off,
-		.y = -area->y_off,
+		.x = -area->x_off - x,
+		.y = -area->y_off - y,
 	};
+	gp_bbox rect = gp_bbox_pack(offset->x + self->x + x,
+	                            offset->y + self->y + y, w, h);
+
+	gp_widget_ops_render_clip(area->child, &child_offset, ctx, flags, rect,
+	                          !flags && !self->redraw);
+}
+
+/*
+ * Moves the already rendered content by the difference between the current
+ * and last rendered offsets and renders only the newly exposed strips.
+ *
+ * The one pixel wide frame is not moved since it's drawn over the child.
+ *
+ * Returns non-zero if the content has to be rendered from scratch.
+ */
+static int scroll_child(gp_widget *self, const gp_offset *offset,
+                        const gp_widget_render_ctx *ctx, gp_size w, gp_size h)
+{
+	struct gp_widget_scroll_area *area = self->scroll;
+	gp_coord dx = area->rendered_x_off - area->x_off;
+	gp_coord dy = area->rendered_y_off - area->y_off;
+	gp_coord x = self->x + offset->x;
+	gp_coord y = self->y + offset->y;
+
+	if (w <= 2 || h <= 2)
+		return 1;
+
+	gp_size iw = w - 2;
+	gp_size ih = h - 2;
 
-	//TODO!!!
-	gp_widget_ops_blit(ctx, self->x + offset->x, self->y + offset->y, self->w, self->h);
+	if (GP_ABS(dx) >= (gp_coord)iw || GP_ABS(dy) >= (gp_coord)ih)
+		return 1;
+
+	if (!gp_widget_ops_can_move(ctx, x + 1, y + 1, iw, ih))
+		return 1;
+
+	GP_DEBUG(3, "Scroll area %p moving content by %ix%i", self, dx, dy);
+
+	gp_move_rect_xywh(ctx->buf, x + 1, y + 1, iw, ih, dx, dy);
+
+	/*
+	 * Widgets that asked for redraw have to be repainted at the new
+	 * position first, the exposed strips are repainted fully afterwards.
+	 */
+	render_child(self, offset, ctx, 0, 0, 0, w, h);
+
+	if (dy > 0)
+		render_child(self, offset, ctx, GP_WIDGET_REDRAW, 1, 1, iw, dy);
+
+	if (dy < 0)
+		render_child(self, offset, ctx, GP_WIDGET_REDRAW, 1, 1 + ih + dy, iw, -dy);
+
+	if (dx > 0)
+		render_child(self, offset, ctx, GP_WIDGET_REDRAW, 1, 1, dx, ih);
+
+	if (dx < 0)
+		render_child(self, offset, ctx, GP_WIDGET_REDRAW, 1 + iw + dx, 1, -dx, ih);
+
+	return 0;
+}
+
+static void render(gp_widget *self, const gp_offset *offset,
+                   const gp_widget_render_ctx *ctx, int flags)
+{
+	struct gp_widget_scroll_area *area = self->scroll;
+	int scrolled = area->scrolled;
+
+	area->scrolled = 0;
+
+	/*
+	 * Only the changed parts of the child are blitted when nothing but
+	 * the child has changed, see render_child().
+	 */
+	if (flags || self->redraw)
+		gp_widget_ops_blit(ctx, self->x + offset->x, self->y + offset->y, self->w, self->h);
 
 	gp_size w = self->w;
 	gp_size h = self->h;
@@ -205,20 +291,17 @@ static void render(gp_widget *self, const gp_offset *offset,
 		draw_horiz_scroll_bar(self, ctx, self->x + offset->x, self->y + offset->y + h, w, size);
 	}
 
-	gp_sub_pixmap(ctx->buf, &child_buf,
-	              offset->x + self->x,
-	              offset->y + self->y,
-		      w, h);
+	if (!scrolled || (flags & (GP_WIDGET_REDRAW | GP_WIDGET_REDRAW_CHILDREN)) ||
+	    scroll_child(self, offset, ctx, w, h)) {
+		if (scrolled)
+			flags |= GP_WIDGET_REDRAW;
 
-	//TODO: Combine with passed down bbox?
-	gp_bbox child_bbox = gp_bbox_pack(0, 0, w, h);
+		render_child(self, offset, ctx, flags, 0, 0, w, h);
+	}
 
-	child_ctx.bbox = &child_bbox;
-	child_ctx.buf = &child_buf;
-	//TODO: Propagate flip
-	child_ctx.flip = NULL;
+	area->rendered_x_off = area->x_off;
+	area->rendered_y_off = area->y_off;
 
-	gp_widget_ops_render(area->child, &child_offset, &child_ctx, flags);
 	gp_rect_xywh(ctx->buf, self->x + offset->x, self->y + offset->y, w, h, ctx->text_color);
 }
 
@@ -246,6 +329,24 @@ static int is_in_scrollbar_y(gp_widget *self, const gp_widget_render_ctx *ctx, u
 	return 0;
 }
 
+/*
+ * If nothing else but the offsets changed since the last render, the content
+ * is moved on the next render and only the exposed parts are repainted.
+ */
+static void redraw_scroll(gp_widget *self)
+{
+	struct gp_widget_scroll_area *area = self->scroll;
+
+	if (!self->redraw) {
+		area->scrolled = 1;
+		gp_widget_redraw(self);
+		return;
+	}
+
+	if (!area->scrolled)
+		gp_widget_redraw_children(self);
+}
+
 static void set_y_off(gp_widget *self, int y_off)
 {
 	if (y_off < 0) {
@@ -263,8 +364,7 @@ static void set_y_off(gp_widget *self, int y_off)
 
 	self->scroll->y_off = y_off;
 
-	gp_widget_redraw(self);
-	gp_widget_redraw_children(self);
+	redraw_scroll(self);
 }
 
 static void set_x_off(gp_widget *self, int x_off)
@@ -284,8 +384,7 @@ static void set_x_off(gp_widget *self, int x_off)
 
 	self->scroll->x_off = x_off;
 
-	gp_widget_redraw(self);
-	gp_widget_redraw_children(self);
+	redraw_scroll(self);
 }
 
 static void scrollbar_event_y(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
@@ -318,6 +417,35 @@ static void scrollbar_event_x(gp_widget *self, const gp_widget_render_ctx *ctx,
 	set_x_off(self, (x * max_x_off(self) + gw/2)/ gw);
 }
 
+/*
+ * The wheel scrolls by three lines of text.
+ */
+static gp_size wheel_step(const gp_widget_render_ctx *ctx)
+{
+	return 3 * scrollbar_size(ctx);
+}
+
+static int kinetic_event(gp_widget *self, const gp_widget_render_ctx *ctx,
+                         gp_event *ev)
+{
+	struct gp_widget_scroll_area *area = self->scroll;
+
+	switch (ev->type) {
+	case GP_EV_KEY:
+		/* button state is tracked even if the child handles the event */
+		gp_widget_kinetic_event(&area->kinetic, ev, wheel_step(ctx));
+		return 0;
+	case GP_EV_REL:
+		if (!area->area_focused &&
+		    gp_widget_ops_event_offset(area->child, ctx, ev, area->x_off, area->y_off))
+			return 1;
+
+		return gp_widget_kinetic_event(&area->kinetic, ev, wheel_step(ctx));
+	}
+
+	return 0;
+}
+
 static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 {
 	struct gp_widget_scroll_area *area = self->scroll;
@@ -338,6 +466,13 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 		}
 	}
 
+	if (kinetic_event(self, ctx, ev))
+		return 1;
+
+	/* relative events were already passed to the child in kinetic_event() */
+	if (ev->type == GP_EV_REL)
+		return 0;
+
 	if (area->area_focused) {
 		if (ev->type != GP_EV_KEY)
 			return 0;
@@ -453,6 +588,8 @@ static void distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx, in
 	gp_coord x_off = max_x_off(self);
 	gp_coord y_off = max_y_off(self);
 
+	area->scrolled = 0;
+
 	if (area->x_off > x_off)
 		area->x_off = x_off;
 
@@ -472,17 +609,17 @@ static void distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx, in
 	gp_widget_ops_distribute_size(area->child, ctx, child_w, child_h, new_wh);
 }
 
-static gp_widget *json_to_scroll(json_object *json, void **uids)
+static gp_widget *json_to_scroll(const gp_bjson *json, void **uids)
 {
-	json_object *childjs = NULL;
+	const gp_bjson *childjs = NULL;
 	int min_w = 0;
 	int min_h = 0;
 
-        json_object_object_foreach(json, key, val) {
+        gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "min_w")) {
-			min_w = json_object_get_int(val);
+			min_w = gp_bjson_int(val);
 		} else if (!strcmp(key, "min_h")) {
-			min_h = json_object_get_int(val);
+			min_h = gp_bjson_int(val);
 		} else if (!strcmp(key, "widget")) {
 			childjs = val;
 		} else
@@ -503,7 +640,7 @@ static gp_widget *json_to_scroll(json_object *json, void **uids)
 	gp_widget *ret;
 
 	if (childjs)
-		child = gp_widget_from_json(childjs, uids);
+		child = gp_widget_from_bjson(childjs, uids);
 
 	ret = gp_widget_scroll_area_new(min_w, min_h, child);
 	if (!ret)
@@ -512,6 +649,11 @@ static gp_widget *json_to_scroll(json_object *json, void **uids)
 	return ret;
 }
 
+static void free_(gp_widget *self)
+{
+	gp_widget_kinetic_stop(&self->scroll->kinetic);
+}
+
 struct gp_widget_ops gp_widget_scroll_area_ops = {
 	.min_w = min_w,
 	.min_h = min_h,
@@ -520,6 +662,8 @@ struct gp_widget_ops gp_widget_scroll_area_ops = {
 	.focus_xy = focus_xy,
 	.focus = focus,
 	.distribute_size = distribute_size,
+	.for_each_child = for_each_child,
+	.free = free_,
 	.from_json = json_to_scroll,
 	.id = "scroll area",
 };
@@ -538,6 +682,8 @@ gp_widget *gp_widget_scroll_area_new(gp_size min_w, gp_size min_h, gp_widget *ch
 	ret->scroll->child = child;
 	gp_widget_set_parent(child, ret);
 
+	gp_widget_kinetic_init(&ret->scroll->kinetic, ret, gp_widget_scroll_area_move);
+
 	return ret;
 }
 
@@ -601,8 +747,7 @@ int gp_widget_scroll_area_move(gp_widget *self, gp_coord x_off, gp_coord y_off)
 	if (!ret)
 		return ret;
 
-	gp_widget_redraw(self);
-	gp_widget_redraw_children(self);
+	redraw_scroll(self);
 
 	return 1;
 }
@@ -0,0 +1,198 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <core/gp_debug.h>
+#include <gp_widget_ops.h>
+#include <gp_widget_surface_cache.h>
+
+static gp_widget_surface_cache_stats stats = {
+	.gen = 1,
+};
+
+static gp_widget_surface_cache *lru_first;
+static gp_widget_surface_cache *lru_last;
+
+const gp_widget_surface_cache_stats *gp_widget_surface_cache_stats_get(void)
+{
+	return &stats;
+}
+
+static size_t pixmap_bytes(const gp_pixmap *pixmap)
+{
+	return (size_t)pixmap->bytes_per_row * pixmap->h;
+}
+
+static void lru_rem(gp_widget_surface_cache *self)
+{
+	if (self->prev)
+		self->prev->next = self->next;
+	else
+		lru_first = self->next;
+
+	if (self->next)
+		self->next->prev = self->prev;
+	else
+		lru_last = self->prev;
+
+	self->prev = NULL;
+	self->next = NULL;
+}
+
+static void lru_ins(gp_widget_surface_cache *self)
+{
+	self->prev = NULL;
+	self->next = lru_first;
+
+	if (lru_first)
+		lru_first->prev = self;
+	else
+		lru_last = self;
+
+	lru_first = self;
+}
+
+void gp_widget_surface_cache_free(gp_widget_surface_cache *self)
+{
+	if (!self->pixmap)
+		return;
+
+	lru_rem(self);
+
+	stats.used -= pixmap_bytes(self->pixmap);
+	stats.surfaces--;
+
+	gp_pixmap_free(self->pixmap);
+	self->pixmap = NULL;
+	self->gen = 0;
+}
+
+static void evict(size_t budget)
+{
+	while (lru_last && stats.used > budget) {
+		GP_DEBUG(3, "Evicting surface %p %ux%u", lru_last,
+		         lru_last->pixmap->w, lru_last->pixmap->h);
+
+		gp_widget_surface_cache_free(lru_last);
+		stats.evictions++;
+	}
+}
+
+void gp_widget_surface_cache_budget_set(size_t budget)
+{
+	stats.budget = budget;
+
+	evict(budget);
+}
+
+void gp_widget_surface_cache_flush(void)
+{
+	/* zero is reserved for invalidated surfaces */
+	if (!++stats.gen)
+		stats.gen = 1;
+
+	GP_DEBUG(1, "Surface cache flushed, generation %u", stats.gen);
+}
+
+static int surface_matches(gp_widget_surface_cache *self,
+                           const gp_widget_render_ctx *ctx,
+                           gp_size w, gp_size h)
+{
+	gp_pixmap *pixmap = self->pixmap;
+
+	return pixmap && pixmap->w == w && pixmap->h == h &&
+	       pixmap->pixel_type == ctx->pixel_type;
+}
+
+gp_pixmap *gp_widget_surface_cache_get(gp_widget_surface_cache *self,
+                                       const gp_widget_render_ctx *ctx,
+                                       gp_size w, gp_size h)
+{
+	if (!stats.budget)
+		return NULL;
+
+	if (self->gen != stats.gen || !surface_matches(self, ctx, w, h)) {
+		stats.misses++;
+		return NULL;
+	}
+
+	stats.hits++;
+
+	lru_rem(self);
+	lru_ins(self);
+
+	return self->pixmap;
+}
+
+gp_pixmap *gp_widget_surface_cache_alloc(gp_widget_surface_cache *self,
+                                         const gp_widget_render_ctx *ctx,
+                                         gp_size w, gp_size h)
+{
+	gp_pixmap *pixmap;
+
+	if (!stats.budget)
+		return NULL;
+
+	if (surface_matches(self, ctx, w, h)) {
+		lru_rem(self);
+		lru_ins(self);
+		self->gen = stats.gen;
+		return self->pixmap;
+	}
+
+	gp_widget_surface_cache_free(self);
+
+	pixmap = gp_pixmap_alloc(w, h, ctx->pixel_type);
+	if (!pixmap) {
+		GP_WARN("Failed to allocate surface %ux%u", w, h);
+		return NULL;
+	}
+
+	if (pixmap_bytes(pixmap) > stats.budget) {
+		GP_DEBUG(3, "Surface %ux%u does not fit the budget", w, h);
+		gp_pixmap_free(pixmap);
+		return NULL;
+	}
+
+	evict(stats.budget - pixmap_bytes(pixmap));
+
+	self->pixmap = pixmap;
+	self->gen = stats.gen;
+
+	stats.used += pixmap_bytes(pixmap);
+	stats.surfaces++;
+
+	lru_ins(self);
+
+	return pixmap;
+}
+
+void gp_widget_surface_cache_render(gp_widget_surface_cache *self,
+                                    gp_widget *widget,
+                                    const gp_widget_render_ctx *ctx,
+                                    gp_coord x, gp_coord y,
+                                    void (*draw)(gp_widget *widget,
+                                                 const gp_widget_render_ctx *ctx,
+                                                 gp_pixmap *buf,
+                                                 gp_coord x, gp_coord y))
+{
+	gp_pixmap *surface;
+
+	surface = gp_widget_surface_cache_get(self, ctx, widget->w, widget->h);
+	if (!surface) {
+		surface = gp_widget_surface_cache_alloc(self, ctx, widget->w, widget->h);
+		if (!surface) {
+			draw(widget, ctx, ctx->buf, x, y);
+			return;
+		}
+
+		draw(widget, ctx, surface, 0, 0);
+	}
+
+	gp_widget_ops_surface_blit(ctx, surface, x, y,
+	                           gp_bbox_pack(0, 0, widget->w, widget->h));
+}
@@ -6,8 +6,8 @@
 
  */
 
+#include <stdlib.h>
 #include <string.h>
-#include <json-c/json.h>
 
 #include <utils/gp_vec.h>
 
@@ -92,13 +92,16 @@ static void render(gp_widget *self, const gp_offset *offset,
 	gp_widget_ops_render(layout, &child_offset, ctx, flags);
 }
 
-static gp_widget *json_to_switch(json_object *json, void **uids)
+static gp_widget *json_to_switch(const gp_bjson *json, void **uids)
 {
-	json_object *widgets = NULL;
+	const gp_bjson *widgets = NULL;
+	int lazy = 0;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "widgets"))
 			widgets = val;
+		else if (!strcmp(key, "lazy"))
+			lazy = gp_bjson_bool(val);
 		else
 			GP_WARN("Invalid switch key '%s'", key);
 	}
@@ -108,21 +111,33 @@ static gp_widget *json_to_switch(json_object *json, void **uids)
 		return NULL;
 	}
 
-	if (!json_object_is_type(widgets, json_type_array)) {
+	if (!gp_bjson_is_type(widgets, GP_BJSON_ARRAY)) {
 		GP_WARN("Widgets has to be array of strings!");
 		return NULL;
 	}
 
-	unsigned int i, layouts = json_object_array_length(widgets);
+	unsigned int i, layouts = gp_bjson_len(widgets);
 
 	gp_widget *ret = gp_widget_switch_new(layouts);
 	if (!ret)
 		return NULL;
 
+	if (lazy && layouts > 1) {
+		ret->switch_->lazy = calloc(layouts, sizeof(gp_widget_lazy *));
+		if (!ret->switch_->lazy)
+			GP_WARN("Malloc failed, loading all layouts");
+	}
+
 	for (i = 0; i < layouts; i++) {
-		json_object *json_widget = json_object_array_get_idx(widgets, i);
+		const gp_bjson *json_widget = gp_bjson_idx(widgets, i);
+
+		if (ret->switch_->lazy && i != ret->switch_->active_layout) {
+			ret->switch_->lazy[i] = gp_widget_lazy_new(json_widget, uids);
+			if (ret->switch_->lazy[i])
+				continue;
+		}
 
-		ret->switch_->layouts[i] = gp_widget_from_json(json_widget, uids);
+		ret->switch_->layouts[i] = gp_widget_from_bjson(json_widget, uids);
 
 		gp_widget_set_parent(ret->switch_->layouts[i], ret);
 	}
@@ -130,13 +145,30 @@ static gp_widget *json_to_switch(json_object *json, void **uids)
 	return ret;
 }
 
-static void free_(gp_widget *self)
+static void for_each_child(gp_widget *self,
+                           void (*func)(gp_widget *child, void *priv),
+                           void *priv)
 {
 	unsigned int i;
 	struct gp_widget_switch *s = self->switch_;
 
-	for (i = 0; i < gp_widget_switch_layouts(self); i++)
-		gp_widget_free(s->layouts[i]);
+	for (i = 0; i < gp_widget_switch_layouts(self); i++) {
+		if (s->layouts[i])
+			func(s->layouts[i], priv);
+	}
+}
+
+static void free_(gp_widget *self)
+{
+	struct gp_widget_switch *s = self->switch_;
+	unsigned int i;
+
+	if (s->lazy) {
+		for (i = 0; i < gp_vec_len(s->layouts); i++)
+			gp_widget_lazy_free(s->lazy[i]);
+
+		free(s->lazy);
+	}
 
 	gp_vec_free(s->layouts);
 }
@@ -156,6 +188,7 @@ struct gp_widget_ops gp_widget_switch_ops = {
 	.min_w = min_w,
 	.min_h = min_h,
 	.distribute_size = distribute_size,
+	.for_each_child = for_each_child,
 	.event = event,
 	.focus = focus,
 	.focus_xy = focus_xy,
@@ -177,7 +210,7 @@ gp_widget *gp_widget_switch_new(unsigned int layouts)
 	ret->switch_->layouts = gp_vec_new(layouts, sizeof(gp_widget*));
 
 	if (!ret->switch_->layouts) {
-		free(ret);
+		gp_widget_free(ret);
 		return NULL;
 	}
 
@@ -221,6 +254,11 @@ gp_widget *gp_widget_switch_put(gp_widget *self, unsigned int layout_nr,
 	if (layout_nr >= gp_widget_switch_layouts(self))
 		return NULL;
 
+	if (self->switch_->lazy) {
+		gp_widget_lazy_free(self->switch_->lazy[layout_nr]);
+		self->switch_->lazy[layout_nr] = NULL;
+	}
+
 	ret = self->switch_->layouts[layout_nr];
 	self->switch_->layouts[layout_nr] = child;
 
@@ -242,6 +280,15 @@ void gp_widget_switch_layout(gp_widget *self, unsigned int layout_nr)
 		return;
 	}
 
+	if (s->lazy && s->lazy[layout_nr]) {
+		s->layouts[layout_nr] = gp_widget_lazy_load(s->lazy[layout_nr]);
+		s->lazy[layout_nr] = NULL;
+
+		gp_widget_set_parent(s->layouts[layout_nr], self);
+
+		gp_widget_resize(self);
+	}
+
 	s->active_layout = layout_nr;
 
 	gp_widget_redraw_children(self);
@@ -7,18 +7,115 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <gp_widgets.h>
 #include <gp_widget_ops.h>
 #include <gp_widget_render.h>
 
+/*
+ * Cell cache.
+ *
+ * Texts of recently rendered rows and their widths are stored in a direct
+ * mapped cache indexed by row number. Row entries are invalidated one by one
+ * by gp_widget_table_row_refresh() and all at once by incrementing the cache
+ * generation.
+ */
+struct cache_row {
+	unsigned int row;
+	/* entry is valid if equal to the cache generation */
+	unsigned int gen;
+	size_t text_size;
+	char *text;
+};
+
+struct gp_widget_table_cache {
+	unsigned int size;
+	unsigned int gen;
+	struct cache_row *rows;
+	/* text offsets and widths, size * cols entries */
+	size_t *offs;
+	gp_size *widths;
+};
+
+static void cache_clear(struct gp_widget_table_cache *cache)
+{
+	unsigned int i;
+
+	for (i = 0; i < cache->size; i++)
+		free(cache->rows[i].text);
+
+	free(cache->rows);
+	free(cache->offs);
+	free(cache->widths);
+
+	cache->rows = NULL;
+	cache->offs = NULL;
+	cache->widths = NULL;
+	cache->size = 0;
+}
+
+static void cache_invalidate(gp_widget_table *tbl)
+{
+	if (!tbl->cache)
+		return;
+
+	if (!++tbl->cache->gen)
+		tbl->cache->gen = 1;
+}
+
+static void cache_row_invalidate(gp_widget_table *tbl, unsigned int row)
+{
+	struct gp_widget_table_cache *cache = tbl->cache;
+
+	if (!cache || !cache->size)
+		return;
+
+	if (cache->rows[row % cache->size].row == row)
+		cache->rows[row % cache->size].gen = 0;
+}
+
+/*
+ * Makes sure that all visible rows fit into the cache, there is space for
+ * twice as many rows so that rows scrolled out of the view stay cached for a
+ * while.
+ */
+static int cache_fit(gp_widget_table *tbl, unsigned int rows)
+{
+	struct gp_widget_table_cache *cache = tbl->cache;
+	unsigned int size = 2 * GP_MAX(rows, 1u);
+
+	if (cache->size >= rows && cache->size)
+		return 0;
+
+	cache_clear(cache);
+
+	cache->rows = calloc(size, sizeof(*cache->rows));
+	cache->offs = malloc(size * tbl->cols * sizeof(*cache->offs));
+	cache->widths = malloc(size * tbl->cols * sizeof(*cache->widths));
+
+	if (!cache->rows || !cache->offs || !cache->widths) {
+		GP_WARN("Malloc failed :-(");
+		free(cache->rows);
+		free(cache->offs);
+		free(cache->widths);
+		cache->rows = NULL;
+		cache->offs = NULL;
+		cache->widths = NULL;
+		return 1;
+	}
+
+	cache->size = size;
+
+	return 0;
+}
+
 static unsigned int header_min_w(gp_widget_table *tbl,
                                  const gp_widget_render_ctx *ctx,
                                  unsigned int col)
 {
 	const char *text = tbl->headers[col].text;
-	unsigned int text_size = gp_text_width(ctx->font_bold, text);
+	gp_text_cache *cache = &tbl->header_widths[col];
+	unsigned int text_size = gp_text_cache_width(cache, ctx->font_bold, text);
 
 	if (tbl->headers[col].sortable)
 		text_size += ctx->padd + gp_text_ascent(ctx->font);
@@ -88,6 +185,9 @@ static void distribute_size(gp_widget *self, const gp_widget_render_ctx *ctx, in
 
 	(void)new_wh;
 
+	tbl->partial = 0;
+	cache_invalidate(tbl);
+
 	for (i = 0; i < tbl->cols; i++) {
 		sum_cols_w += tbl->cols_w[i];
 		sum_fills += tbl->col_fills[i];
@@ -150,29 +250,400 @@ static void header_render(gp_widget *self, gp_coord x, gp_coord y,
 	gp_hline_xyw(ctx->buf, x, cy, self->w, color);
 }
 
+/*
+ * Draws a cell text, the text width is either known or -1.
+ */
 static void align_text(gp_pixmap *buf, gp_widget_table *tbl,
                        const gp_widget_render_ctx *ctx,
 		       unsigned int x, unsigned int y,
-		       unsigned int col, gp_pixel bg, const char *str)
+		       unsigned int col, gp_pixel bg, const char *str,
+		       int width)
 {
+	if (width >= 0 && (gp_size)width <= tbl->cols_w[col]) {
+		gp_text(buf, ctx->font, x, y, GP_ALIGN_RIGHT|GP_VALIGN_BELOW,
+		        ctx->text_color, bg, str);
+		return;
+	}
+
 	gp_text_fit(buf, ctx->font, x, y, tbl->cols_w[col],
 	           GP_ALIGN_RIGHT|GP_VALIGN_BELOW,
 	           ctx->text_color, bg, str);
 }
 
+/*
+ * Rows are either accessed by the row iterator callback or, if set, by the
+ * random access model. Rows has to be visited in an increasing order after a
+ * call to rows_reset(), the iterator is reset lazily on first access so that
+ * repaints served from the cell cache do not call the application at all.
+ */
+static void rows_reset(gp_widget *self)
+{
+	gp_widget_table *tbl = self->tbl;
+
+	tbl->iter_row = 0;
+	tbl->iter_reset = 1;
+}
+
+static void row_seek(gp_widget *self, unsigned int row)
+{
+	gp_widget_table *tbl = self->tbl;
+
+	if (tbl->model) {
+		if (!tbl->iter_reset && row == tbl->iter_row)
+			return;
+
+		if (tbl->model->seek_row && row < tbl->last_max_row)
+			tbl->model->seek_row(self, row);
+
+		tbl->iter_reset = 0;
+		tbl->iter_row = row;
+		return;
+	}
+
+	if (tbl->iter_reset) {
+		tbl->row(self, GP_TABLE_ROW_RESET, 0);
+		tbl->iter_reset = 0;
+	}
+
+	if (row > tbl->iter_row)
+		tbl->row(self, GP_TABLE_ROW_ADVANCE, row - tbl->iter_row);
+
+	tbl->iter_row = row;
+}
+
+/*
+ * Fetches a cell from the application, the row has to be selected by
+ * row_seek().
+ */
+static const char *cell_fetch(gp_widget *self, unsigned int col)
+{
+	gp_widget_table *tbl = self->tbl;
+
+	if (!tbl->model)
+		return tbl->get(self, col);
+
+	if (tbl->iter_row >= tbl->last_max_row)
+		return "";
+
+	return tbl->model->get_cell(self, tbl->iter_row, col);
+}
+
+/*
+ * Counts rows starting at row, the model returns the count directly while the
+ * row iterator has to walk the rest of the rows.
+ */
+static unsigned int rows_count(gp_widget *self, unsigned int row)
+{
+	gp_widget_table *tbl = self->tbl;
+	unsigned int cnt = row;
+
+	if (tbl->model)
+		return tbl->last_max_row;
+
+	row_seek(self, row);
+
+	while (tbl->row(self, GP_TABLE_ROW_ADVANCE, 1))
+		cnt++;
+
+	return cnt;
+}
+
+/*
+ * Returns an index of the cache entry for the row, the row cells are fetched
+ * from the application on a cache miss.
+ *
+ * Returns -1 if the row couldn't be cached.
+ */
+static int cache_row_get(gp_widget *self, const gp_widget_render_ctx *ctx,
+                         unsigned int row)
+{
+	gp_widget_table *tbl = self->tbl;
+	struct gp_widget_table_cache *cache = tbl->cache;
+	unsigned int idx, col;
+	struct cache_row *crow;
+	size_t len = 0;
+
+	if (!cache->size)
+		return -1;
+
+	idx = row % cache->size;
+	crow = &cache->rows[idx];
+
+	if (crow->gen == cache->gen && crow->row == row)
+		return idx;
+
+	row_seek(self, row);
+
+	for (col = 0; col < tbl->cols; col++) {
+		const char *str = cell_fetch(self, col);
+		size_t str_len = strlen(str) + 1;
+
+		if (len + str_len > crow->text_size) {
+			size_t text_size = GP_MAX(2 * crow->text_size, len + str_len);
+			char *text = realloc(crow->text, text_size);
+
+			if (!text) {
+				GP_WARN("Malloc failed :-(");
+				crow->gen = 0;
+				return -1;
+			}
+
+			crow->text = text;
+			crow->text_size = text_size;
+		}
+
+		memcpy(crow->text + len, str, str_len);
+
+		cache->offs[idx * tbl->cols + col] = len;
+		cache->widths[idx * tbl->cols + col] = gp_text_width(ctx->font, str);
+
+		len += str_len;
+	}
+
+	crow->row = row;
+	crow->gen = cache->gen;
+
+	return idx;
+}
+
+/*
+ * Returns a cell text either from the cache or from the application, the width
+ * is set to the text width if known or to -1.
+ */
+static const char *cell_get(gp_widget *self, const gp_widget_render_ctx *ctx,
+                            unsigned int row, unsigned int col, int *width)
+{
+	gp_widget_table *tbl = self->tbl;
+
+	if (tbl->cache) {
+		int idx = cache_row_get(self, ctx, row);
+
+		if (idx >= 0) {
+			struct gp_widget_table_cache *cache = tbl->cache;
+			unsigned int i = idx * tbl->cols + col;
+
+			*width = cache->widths[i];
+			return cache->rows[idx].text + cache->offs[i];
+		}
+	}
+
+	*width = -1;
+	row_seek(self, row);
+
+	return cell_fetch(self, col);
+}
+
+/*
+ * Renders a row stripe starting at y.
+ */
+static void row_render(gp_widget *self, gp_coord x, gp_coord y,
+                       const gp_widget_render_ctx *ctx, unsigned int cur_row)
+{
+	gp_widget_table *tbl = self->tbl;
+	unsigned int text_a = gp_text_ascent(ctx->font);
+	unsigned int cx = x + ctx->padd;
+	unsigned int cy = y + ctx->padd/2;
+	gp_pixel bg_col = ctx->fg_color;
+	unsigned int j;
+
+	if (tbl->row_focused && cur_row == tbl->focused_row) {
+		bg_col = self->focused ? ctx->sel_color : ctx->bg_color;
+
+		gp_fill_rect_xywh(ctx->buf, x+1, y+1, self->w - 2,
+		                  text_a + ctx->padd-1, bg_col);
+	}
+
+	for (j = 0; j < tbl->cols; j++) {
+		int width;
+		const char *str = cell_get(self, ctx, cur_row, j, &width);
+
+		align_text(ctx->buf, tbl, ctx, cx, cy, j, bg_col, str, width);
+
+		cx += tbl->cols_w[j] + 2 * ctx->padd;
+	}
+
+	gp_hline_xyw(ctx->buf, x+1, y + row_h(ctx), self->w-2, ctx->bg_color);
+}
+
+/*
+ * Clears a row stripe starting at y before it's rendered again.
+ */
+static void row_clear(gp_widget *self, gp_coord x, gp_coord y,
+                      const gp_widget_render_ctx *ctx)
+{
+	gp_widget_table *tbl = self->tbl;
+	unsigned int cx = x + ctx->padd;
+	unsigned int j;
+
+	gp_fill_rect_xywh(ctx->buf, x+1, y+1, self->w - 2, row_h(ctx) - 1, ctx->fg_color);
+
+	for (j = 0; j < tbl->cols-1; j++) {
+		cx += tbl->cols_w[j] + ctx->padd;
+		gp_vline_xyh(ctx->buf, cx, y+1, row_h(ctx) - 1, ctx->bg_color);
+		cx += ctx->padd;
+	}
+}
+
+/*
+ * Clears the header before it's rendered again, the rounded corners of the
+ * frame drawn by gp_fill_rrect_xywh() are left intact.
+ */
+static void header_clear(gp_widget *self, gp_coord x, gp_coord y,
+                         const gp_widget_render_ctx *ctx)
+{
+	unsigned int rs = 3;
+	gp_size h = header_h(self, ctx);
+
+	gp_fill_rect_xyxy(ctx->buf, x + rs + 1, y + 1, x + self->w - rs - 2, y + rs, ctx->fg_color);
+	gp_fill_rect_xyxy(ctx->buf, x + 1, y + rs + 1, x + self->w - 2, y + h - 1, ctx->fg_color);
+}
+
+static void sort_rows(unsigned int *rows, unsigned int cnt)
+{
+	unsigned int i, j;
+
+	for (i = 1; i < cnt; i++) {
+		unsigned int row = rows[i];
+
+		for (j = i; j > 0 && rows[j-1] > row; j--)
+			rows[j] = rows[j-1];
+
+		rows[j] = row;
+	}
+}
+
+static void row_repaint(gp_widget *self, gp_coord x, gp_coord body_y,
+                        const gp_widget_render_ctx *ctx, unsigned int row)
+{
+	gp_coord row_y = body_y + (row - self->tbl->start_row) * row_h(ctx);
+
+	row_clear(self, x, row_y, ctx);
+	row_render(self, x, row_y, ctx, row);
+}
+
+/*
+ * Moves the already rendered rows after the table was scrolled and repaints
+ * the rows that were scrolled into the view.
+ *
+ * Returns non-zero if the rows couldn't be moved and all rows have to be
+ * repainted.
+ */
+static int scroll_body(gp_widget *self, gp_coord x, gp_coord body_y,
+                       const gp_widget_render_ctx *ctx, unsigned int rows)
+{
+	gp_widget_table *tbl = self->tbl;
+	int delta = (int)tbl->start_row - (int)tbl->rendered_start_row;
+	unsigned int i, first, last;
+
+	if ((unsigned int)GP_ABS(delta) >= rows)
+		return 1;
+
+	if (!gp_widget_ops_can_move(ctx, x + 1, body_y + 1, self->w - 2, rows * row_h(ctx)))
+		return 1;
+
+	gp_move_rect_xywh(ctx->buf, x + 1, body_y + 1, self->w - 2,
+	                  rows * row_h(ctx), 0, -delta * (int)row_h(ctx));
+
+	if (delta > 0) {
+		first = tbl->start_row + rows - delta;
+		last = tbl->start_row + rows;
+	} else {
+		first = tbl->start_row;
+		last = tbl->start_row - delta;
+	}
+
+	for (i = first; i < last; i++)
+		row_repaint(self, x, body_y, ctx, i);
+
+	return 0;
+}
+
+/*
+ * Repaints only the header and rows that were marked dirty.
+ */
+static void render_partial(gp_widget *self, gp_coord x, gp_coord y,
+                           const gp_widget_render_ctx *ctx)
+{
+	gp_widget_table *tbl = self->tbl;
+	unsigned int rows = display_rows(self, ctx);
+	unsigned int i;
+	gp_coord body_y = y + header_h(self, ctx);
+	gp_size body_h = rows * row_h(ctx) + 1;
+
+	if (tbl->dirty_header && tbl->headers) {
+		header_clear(self, x, y, ctx);
+		header_render(self, x, y, ctx);
+		gp_widget_ops_blit(ctx, x, y, self->w, header_h(self, ctx) + 1);
+	}
+
+	rows_reset(self);
+
+	if (tbl->dirty_scroll && !tbl->dirty_body) {
+		if (scroll_body(self, x, body_y, ctx, rows))
+			tbl->dirty_body = 1;
+	}
+
+	if (tbl->dirty_body) {
+		for (i = 0; i < rows; i++)
+			row_repaint(self, x, body_y, ctx, tbl->start_row + i);
+
+		gp_widget_ops_blit(ctx, x, body_y, self->w, body_h);
+		return;
+	}
+
+	sort_rows(tbl->dirty_rows, tbl->dirty_cnt);
+
+	/*
+	 * Rows scrolled into the view were repainted in an increasing order
+	 * already, the iterator has to be restarted for the dirty rows.
+	 */
+	if (tbl->dirty_scroll)
+		rows_reset(self);
+
+	for (i = 0; i < tbl->dirty_cnt; i++) {
+		unsigned int row = tbl->dirty_rows[i];
+
+		if (row < tbl->start_row || row >= tbl->start_row + rows)
+			continue;
+
+		row_repaint(self, x, body_y, ctx, row);
+
+		if (!tbl->dirty_scroll)
+			gp_widget_ops_blit(ctx, x, body_y + (row - tbl->start_row) * row_h(ctx), self->w, row_h(ctx) + 1);
+	}
+
+	if (tbl->dirty_scroll)
+		gp_widget_ops_blit(ctx, x, body_y, self->w, body_h);
+}
+
 static void render(gp_widget *self, const gp_offset *offset,
                    const gp_widget_render_ctx *ctx, int flags)
 {
 	struct gp_widget_table *tbl = self->tbl;
-	unsigned int text_a = gp_text_ascent(ctx->font);
 	unsigned int x = self->x + offset->x;
 	unsigned int y = self->y + offset->y;
 	unsigned int w = self->w;
 	unsigned int h = self->h;
 	unsigned int cy = y;
+	unsigned int rows = display_rows(self, ctx);
 	unsigned int i, j;
+	int partial = tbl->partial && !self->redraw &&
+	              !(flags & GP_WIDGET_REDRAW) &&
+	              self->focused == tbl->rendered_focused;
+
+	tbl->partial = 0;
+	tbl->rendered_focused = self->focused;
 
-	(void)flags;
+	if (tbl->cache)
+		cache_fit(tbl, rows);
+
+	if (partial) {
+		render_partial(self, x, y, ctx);
+		tbl->rendered_start_row = tbl->start_row;
+		return;
+	}
+
+	tbl->rendered_start_row = tbl->start_row;
 
 	gp_widget_ops_blit(ctx, x, y, w, h);
 
@@ -184,11 +655,12 @@ static void render(gp_widget *self, const gp_offset *offset,
 		cy += header_h(self, ctx);
 	}
 
-	tbl->row(self, GP_TABLE_ROW_RESET, 0);
-	tbl->row(self, GP_TABLE_ROW_ADVANCE, tbl->start_row);
+	rows_reset(self);
+
+	if (tbl->model)
+		tbl->last_max_row = tbl->model->row_cnt(self);
 
 	unsigned int cur_row = tbl->start_row;
-	unsigned int rows = display_rows(self, ctx);
 
 	unsigned int cx = x + ctx->padd;
 
@@ -198,46 +670,100 @@ static void render(gp_widget *self, const gp_offset *offset,
 		cx += ctx->padd;
 	}
 
-	cy += ctx->padd/2;
 	for (i = 0; i < rows; i++) {
-		cx = x + ctx->padd;
-		gp_pixel bg_col = ctx->fg_color;
+		row_render(self, x, cy, ctx, cur_row);
 
-		if (tbl->row_focused && cur_row == tbl->focused_row) {
-			bg_col = self->focused ? ctx->sel_color : ctx->bg_color;
+		cy += row_h(ctx);
+		cur_row++;
+	}
 
-			gp_fill_rect_xywh(ctx->buf, x+1, cy - ctx->padd/2+1,
-					self->w - 2,
-					text_a + ctx->padd-1, bg_col);
-		}
+	tbl->last_max_row = rows_count(self, cur_row);
+}
 
-		for (j = 0; j < tbl->cols; j++) {
-			const char *str = tbl->get(self, j);
+/*
+ * Marks the table for a partial redraw unless a full redraw is pending.
+ *
+ * The partial redraw is requested with gp_widget_redraw_child() so that a
+ * gp_widget_redraw() called later in the same frame still sets the redraw
+ * flag and the whole table is repainted.
+ *
+ * Returns non-zero if the dirty parts should be recorded.
+ */
+static int redraw_partial(gp_widget *self)
+{
+	gp_widget_table *tbl = self->tbl;
 
-			align_text(ctx->buf, tbl, ctx, cx, cy, j, bg_col, str);
+	if (self->redraw)
+		return 0;
 
-			cx += tbl->cols_w[j] + ctx->padd;
+	if (!tbl->partial) {
+		tbl->partial = 1;
+		tbl->dirty_cnt = 0;
+		tbl->dirty_header = 0;
+		tbl->dirty_body = 0;
+		tbl->dirty_scroll = 0;
 
-		//	if (j < tbl->cols - 1) {
-		//		gp_vline_xyh(ctx->buf, cx, cy,
-		//			    text_a, ctx->text_color);
-		//	}
+		gp_widget_redraw_child(self);
+	}
 
-			cx += ctx->padd;
-		}
+	return 1;
+}
+
+static void redraw_row(gp_widget *self, unsigned int row)
+{
+	gp_widget_table *tbl = self->tbl;
+	unsigned int i;
 
-		cy += text_a + ctx->padd;
+	if (!redraw_partial(self) || tbl->dirty_body)
+		return;
 
-		tbl->row(self, GP_TABLE_ROW_ADVANCE, 1);
-		cur_row++;
+	for (i = 0; i < tbl->dirty_cnt; i++) {
+		if (tbl->dirty_rows[i] == row)
+			return;
+	}
 
-		gp_hline_xyw(ctx->buf, x+1, cy - ctx->padd/2, w-2, ctx->bg_color);
+	if (tbl->dirty_cnt >= GP_WIDGET_TABLE_DIRTY_ROWS) {
+		tbl->dirty_body = 1;
+		return;
 	}
 
-	while (tbl->row(self, GP_TABLE_ROW_ADVANCE, 1))
-		cur_row++;
+	tbl->dirty_rows[tbl->dirty_cnt++] = row;
+}
+
+static void redraw_body(gp_widget *self)
+{
+	if (redraw_partial(self))
+		self->tbl->dirty_body = 1;
+}
 
-	tbl->last_max_row = cur_row;
+static void redraw_scroll(gp_widget *self)
+{
+	if (redraw_partial(self))
+		self->tbl->dirty_scroll = 1;
+}
+
+static void redraw_header(gp_widget *self)
+{
+	if (redraw_partial(self))
+		self->tbl->dirty_header = 1;
+}
+
+/*
+ * Repaints rows that changed after the focused row has moved, rows that are
+ * still visible after the table has scrolled are moved instead of repainted.
+ */
+static void redraw_focus_move(gp_widget *self, int was_focused,
+                              unsigned int old_row, unsigned int old_start)
+{
+	gp_widget_table *tbl = self->tbl;
+
+	if (tbl->start_row != old_start)
+		redraw_scroll(self);
+
+	if (was_focused)
+		redraw_row(self, old_row);
+
+	redraw_row(self, tbl->focused_row);
 }
 
 static void fix_focused_row(gp_widget_table *tbl)
@@ -250,6 +776,9 @@ static int move_down(gp_widget *self, const gp_widget_render_ctx *ctx,
                      unsigned int rows)
 {
 	gp_widget_table *tbl = self->tbl;
+	unsigned int old_row = tbl->focused_row;
+	unsigned int old_start = tbl->start_row;
+	int was_focused = tbl->row_focused;
 
 	if (!tbl->row_focused) {
 		tbl->row_focused = 1;
@@ -276,13 +805,16 @@ redraw:
 	if (tbl->focused_row > tbl->start_row + rows)
 		tbl->start_row = tbl->focused_row - rows + 1;
 
-	gp_widget_redraw(self);
+	redraw_focus_move(self, was_focused, old_row, old_start);
 	return 1;
 }
 
 static int move_up(gp_widget *self, const gp_widget_render_ctx *ctx, unsigned int rows)
 {
 	gp_widget_table *tbl = self->tbl;
+	unsigned int old_row = tbl->focused_row;
+	unsigned int old_start = tbl->start_row;
+	int was_focused = tbl->row_focused;
 
 	if (!tbl->row_focused) {
 		tbl->row_focused = 1;
@@ -306,7 +838,65 @@ redraw:
 	if (tbl->focused_row < tbl->start_row)
 		tbl->start_row = tbl->focused_row;
 
-	gp_widget_redraw(self);
+	redraw_focus_move(self, was_focused, old_row, old_start);
+	return 1;
+}
+
+/*
+ * Scrolls the table without moving the focused row.
+ *
+ * Returns zero if the table cannot scroll any further.
+ */
+static int scroll_rows(gp_widget *self, const gp_widget_render_ctx *ctx, int rows)
+{
+	gp_widget_table *tbl = self->tbl;
+	unsigned int disp_rows = display_rows(self, ctx);
+	unsigned int max_start = 0;
+	unsigned int start_row;
+
+	if (tbl->last_max_row > disp_rows)
+		max_start = tbl->last_max_row - disp_rows;
+
+	if (rows < 0)
+		start_row = (unsigned int)-rows > tbl->start_row ? 0 : tbl->start_row + rows;
+	else
+		start_row = GP_MIN(tbl->start_row + rows, max_start);
+
+	if (start_row == tbl->start_row)
+		return 0;
+
+	tbl->start_row = start_row;
+	redraw_scroll(self);
+
+	return 1;
+}
+
+/*
+ * The kinetic scrolling moves by pixels while the table scrolls by rows, the
+ * rest is kept until it adds up to a row.
+ */
+static int kinetic_move(gp_widget *self, gp_coord x_off, gp_coord y_off)
+{
+	const gp_widget_render_ctx *ctx = gp_widgets_render_ctx();
+	gp_widget_table *tbl = self->tbl;
+	int rh = row_h(ctx);
+	int rows;
+
+	if (x_off)
+		return 0;
+
+	tbl->kinetic_rem += y_off;
+	rows = tbl->kinetic_rem / rh;
+	tbl->kinetic_rem -= rows * rh;
+
+	if (!rows)
+		return 1;
+
+	if (!scroll_rows(self, ctx, rows)) {
+		tbl->kinetic_rem = 0;
+		return 0;
+	}
+
 	return 1;
 }
 
@@ -338,7 +928,10 @@ static int header_click(gp_widget *self, const gp_widget_render_ctx *ctx, unsign
 
 	tbl->sort(self, tbl->sorted_by_col, tbl->sorted_desc);
 
-	gp_widget_redraw(self);
+	cache_invalidate(tbl);
+
+	redraw_header(self);
+	redraw_body(self);
 	return 1;
 }
 
@@ -346,14 +939,16 @@ static int row_click(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event
 {
 	gp_widget_table *tbl = self->tbl;
 	unsigned int row = ev->cursor_y - header_h(self, ctx);
+	unsigned int old_row = tbl->focused_row;
+	int was_focused = tbl->row_focused;
 
-	row /= row_h(ctx) + tbl->start_row;
+	row = row / row_h(ctx) + tbl->start_row;
 	tbl->focused_row = row;
 
 	if (!tbl->row_focused)
 		tbl->row_focused = 1;
 
-	gp_widget_redraw(self);
+	redraw_focus_move(self, was_focused, old_row, tbl->start_row);
 	return 1;
 }
 
@@ -379,6 +974,9 @@ static int enter(gp_widget *self)
 
 static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 {
+	if (gp_widget_kinetic_event(&self->tbl->kinetic, ev, 3 * row_h(ctx)))
+		return 1;
+
 	switch (ev->type) {
 	case GP_EV_KEY:
 		if (ev->code == GP_EV_KEY_UP)
@@ -397,11 +995,10 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 
 			return move_up(self, ctx, 1);
 		break;
-		//TODO: Better page up/down
 		case GP_KEY_PAGE_UP:
-			return move_up(self, ctx, 10);
+			return move_up(self, ctx, display_rows(self, ctx));
 		case GP_KEY_PAGE_DOWN:
-			return move_down(self, ctx, 10);
+			return move_down(self, ctx, display_rows(self, ctx));
 		case GP_BTN_LEFT:
 			return click(self, ctx, ev);
 		case GP_KEY_ENTER:
@@ -412,7 +1009,20 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 	return 0;
 }
 
-static gp_widget_table_header *parse_header(json_object *json, int *cols)
+static void free_(gp_widget *self)
+{
+	gp_widget_table *tbl = self->tbl;
+
+	gp_widget_kinetic_stop(&tbl->kinetic);
+
+	if (!tbl->cache)
+		return;
+
+	cache_clear(tbl->cache);
+	free(tbl->cache);
+}
+
+static gp_widget_table_header *parse_header(const gp_bjson *json, int *cols)
 {
 	gp_widget_table_header *header;
 	int i;
@@ -420,71 +1030,84 @@ static gp_widget_table_header *parse_header(json_object *json, int *cols)
 	if (!json)
 		return NULL;
 
-	if (!json_object_is_type(json, json_type_array)) {
+	if (!gp_bjson_is_type(json, GP_BJSON_ARRAY)) {
 		GP_WARN("Table header must be array!");
 		return NULL;
 	}
 
 	if (*cols == -1) {
-		*cols = json_object_array_length(json);
-	} else if (json_object_array_length(json) != (size_t)(*cols)) {
+		*cols = gp_bjson_len(json);
+	} else if (gp_bjson_len(json) != (size_t)(*cols)) {
 		GP_WARN("Table header is not equal to number of columns!");
 		return NULL;
 	}
 
-	header = malloc(sizeof(*header) * (*cols));
+	header = gp_widget_arena_malloc(sizeof(*header) * (*cols));
 	if (!header)
 		return NULL;
 
+	memset(header, 0, sizeof(*header) * (*cols));
+
 	for (i = 0; i < *cols; i++) {
-		json_object *elem = json_object_array_get_idx(json, i);
-		json_object *tmp;
+		const gp_bjson *elem = gp_bjson_idx(json, i);
+		const gp_bjson *tmp;
 
 		if (!elem) {
 			GP_WARN("Table header parse error!");
 			goto err;
 		}
 
-		tmp = json_object_object_get(elem, "label");
+		tmp = gp_bjson_get(elem, "label");
 		if (!tmp) {
 			GP_WARN("Table header %i is missing label", i);
 			goto err;
 		}
 
-		header[i].text = strdup(json_object_get_string(tmp));
+		if (!gp_bjson_str(tmp)) {
+			GP_WARN("Table header %i label has to be a string", i);
+			goto err;
+		}
 
-		if ((tmp = json_object_object_get(elem, "sortable")))
-			header[i].sortable = json_object_get_boolean(tmp);
+		header[i].text = gp_widget_arena_strdup(gp_bjson_str(tmp));
+
+		if ((tmp = gp_bjson_get(elem, "sortable")))
+			header[i].sortable = gp_bjson_bool(tmp);
 
 		header[i].text_align = 0;
 	}
 
 	return header;
 err:
-	free(header);
+	if (!gp_widget_arena_active())
+		free(header);
 	return NULL;
 }
 
-static gp_widget *json_to_table(json_object *json, void **uids)
+static gp_widget *json_to_table(const gp_bjson *json, void **uids)
 {
 	int cols = -1, min_rows = -1;
-	void *set_row = NULL, *get_elem = NULL, *sort = NULL;
-	json_object *header = NULL;
+	void *set_row = NULL, *get_elem = NULL, *sort = NULL, *model = NULL;
+	const gp_bjson *header = NULL;
 	gp_widget_table_header *table_header;
+	int cache = 0;
 
 	(void)uids;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "cols"))
-			cols = json_object_get_int(val);
+			cols = gp_bjson_int(val);
 		else if (!strcmp(key, "min_rows"))
-			min_rows = json_object_get_int(val);
+			min_rows = gp_bjson_int(val);
 		else if (!strcmp(key, "set_row"))
-			set_row = gp_widget_callback_addr(json_object_get_string(val));
+			set_row = gp_widget_callback_addr(gp_bjson_str(val));
 		else if (!strcmp(key, "get_elem"))
-			get_elem = gp_widget_callback_addr(json_object_get_string(val));
+			get_elem = gp_widget_callback_addr(gp_bjson_str(val));
 		else if (!strcmp(key, "sort"))
-			sort = gp_widget_callback_addr(json_object_get_string(val));
+			sort = gp_widget_callback_addr(gp_bjson_str(val));
+		else if (!strcmp(key, "model"))
+			model = gp_widget_callback_addr(gp_bjson_str(val));
+		else if (!strcmp(key, "cache"))
+			cache = gp_bjson_bool(val);
 		else if (!strcmp(key, "header"))
 			header = val;
 		else
@@ -503,17 +1126,22 @@ static gp_widget *json_to_table(json_object *json, void **uids)
 		return NULL;
 	}
 
-	if (!set_row) {
+	if (!model && !set_row) {
 		GP_WARN("Invalid or missing set_row callback");
 		return NULL;
 	}
 
-	if (!get_elem) {
+	if (!model && !get_elem) {
 		GP_WARN("Invalid or missing get_elem callback");
 		return NULL;
 	}
 
-	gp_widget *table = gp_widget_table_new(cols, min_rows, table_header, set_row, get_elem);
+	gp_widget *table;
+
+	if (model)
+		table = gp_widget_table_model_new(cols, min_rows, table_header, model);
+	else
+		table = gp_widget_table_new(cols, min_rows, table_header, set_row, get_elem);
 
 	//TODO: Free header
 	if (!table)
@@ -521,6 +1149,9 @@ static gp_widget *json_to_table(json_object *json, void **uids)
 
 	table->tbl->sort = sort;
 
+	if (cache)
+		gp_widget_table_cache(table, 1);
+
 	return table;
 }
 
@@ -530,6 +1161,7 @@ struct gp_widget_ops gp_widget_table_ops = {
 	.distribute_size = distribute_size,
 	.render = render,
 	.event = event,
+	.free = free_,
 	.from_json = json_to_table,
 	.id = "table",
 };
@@ -544,6 +1176,7 @@ gp_widget *gp_widget_table_new(unsigned int cols, unsigned int min_rows,
 	gp_widget *ret;
 	size_t size = sizeof(struct gp_widget_table);
 
+	size += cols * sizeof(gp_text_cache);
 	size += 2 * cols * sizeof(unsigned int);
 	size += cols;
 
@@ -554,18 +1187,103 @@ gp_widget *gp_widget_table_new(unsigned int cols, unsigned int min_rows,
 	ret->tbl->cols = cols;
 	ret->tbl->min_rows = min_rows;
 	ret->tbl->start_row = 0;
-	ret->tbl->cols_w = (void*)ret->tbl->buf;
-	ret->tbl->col_min_sizes = (void*)(ret->tbl->buf + cols * sizeof(unsigned int));
-	ret->tbl->col_fills = (void*)(ret->tbl->buf + 2 * cols * sizeof(unsigned int));
+	ret->tbl->header_widths = (void*)ret->tbl->buf;
+	ret->tbl->cols_w = (void*)(ret->tbl->header_widths + cols);
+	ret->tbl->col_min_sizes = ret->tbl->cols_w + cols;
+	ret->tbl->col_fills = (void*)(ret->tbl->col_min_sizes + cols);
 	ret->tbl->headers = headers;
 
 	ret->tbl->get = get;
 	ret->tbl->row = row;
 
+	gp_widget_kinetic_init(&ret->tbl->kinetic, ret, kinetic_move);
+
+	return ret;
+}
+
+gp_widget *gp_widget_table_model_new(unsigned int cols, unsigned int min_rows,
+                                     const gp_widget_table_header *headers,
+                                     const gp_widget_table_model *model)
+{
+	gp_widget *ret;
+
+	if (!model->row_cnt || !model->get_cell) {
+		GP_WARN("Table model row_cnt and get_cell have to be set");
+		return NULL;
+	}
+
+	ret = gp_widget_table_new(cols, min_rows, headers, NULL, NULL);
+	if (!ret)
+		return NULL;
+
+	ret->tbl->model = model;
+
 	return ret;
 }
 
 void gp_widget_table_refresh(gp_widget *self)
 {
+	GP_WIDGET_ASSERT(self, GP_WIDGET_TABLE, );
+
+	self->tbl->partial = 0;
+	cache_invalidate(self->tbl);
 	gp_widget_redraw(self);
 }
+
+void gp_widget_table_cache(gp_widget *self, int cache)
+{
+	gp_widget_table *tbl;
+
+	GP_WIDGET_ASSERT(self, GP_WIDGET_TABLE, );
+
+	tbl = self->tbl;
+
+	if (!cache) {
+		if (!tbl->cache)
+			return;
+
+		cache_clear(tbl->cache);
+		free(tbl->cache);
+		tbl->cache = NULL;
+		return;
+	}
+
+	if (tbl->cache)
+		return;
+
+	tbl->cache = calloc(1, sizeof(*tbl->cache));
+	if (!tbl->cache) {
+		GP_WARN("Malloc failed :-(");
+		return;
+	}
+
+	tbl->cache->gen = 1;
+}
+
+void gp_widget_table_row_refresh(gp_widget *self, unsigned int row)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_TABLE, );
+
+	cache_row_invalidate(self->tbl, row);
+	redraw_row(self, row);
+}
+
+void gp_widget_table_header_refresh(gp_widget *self)
+{
+	gp_widget_table *tbl;
+	unsigned int i;
+
+	GP_WIDGET_ASSERT(self, GP_WIDGET_TABLE, );
+
+	tbl = self->tbl;
+
+	if (!tbl->headers)
+		return;
+
+	for (i = 0; i < tbl->cols; i++)
+		gp_text_cache_invalidate(&tbl->header_widths[i]);
+
+	/* header labels may have changed their widths */
+	gp_widget_resize(self);
+	redraw_header(self);
+}
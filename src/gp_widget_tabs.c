@@ -6,8 +6,8 @@
 
  */
 
+#include <stdlib.h>
 #include <string.h>
-#include <json-c/json.h>
 
 #include <core/gp_debug.h>
 #include <core/gp_common.h>
@@ -20,8 +20,9 @@ static gp_size tab_w(gp_widget *self, const gp_widget_render_ctx *ctx,
                      unsigned int tab)
 {
 	const char *label = self->tabs->labels[tab];
+	gp_text_cache *cache = &self->tabs->label_widths[tab];
 
-	return gp_text_width(ctx->font_bold, label) + 2 * ctx->padd;
+	return gp_text_cache_width(cache, ctx->font_bold, label) + 2 * ctx->padd;
 }
 
 static unsigned int min_w(gp_widget *self, const gp_widget_render_ctx *ctx)
@@ -130,7 +131,7 @@ static void render(gp_widget *self, const gp_offset *offset,
 		int is_active = self->tabs->active_tab == i;
 		gp_text_style *font = is_active ? ctx->font_bold : ctx->font;
 
-		unsigned int w = gp_text_width(ctx->font_bold, label) + 2 * ctx->padd;
+		unsigned int w = tab_w(self, ctx, i);
 
 		if (is_active) {
 			act_x = cur_x;
@@ -186,11 +187,28 @@ static void render(gp_widget *self, const gp_offset *offset,
 	gp_widget_ops_render(widget, &widget_offset, ctx, flags);
 }
 
+static void load_tab(gp_widget *self, unsigned int tab)
+{
+	struct gp_widget_tabs *tabs = self->tabs;
+
+	if (!tabs->lazy || !tabs->lazy[tab])
+		return;
+
+	tabs->widgets[tab] = gp_widget_lazy_load(tabs->lazy[tab]);
+	tabs->lazy[tab] = NULL;
+
+	gp_widget_set_parent(tabs->widgets[tab], self);
+
+	gp_widget_resize(self);
+}
+
 static void set_tab(gp_widget *self, unsigned int tab)
 {
 	if (tab == self->tabs->active_tab)
 		return;
 
+	load_tab(self, tab);
+
 	self->tabs->active_tab = tab;
 	gp_widget_redraw(self);
 	gp_widget_redraw_children(self);
@@ -402,16 +420,19 @@ static int focus_xy(gp_widget *self, const gp_widget_render_ctx *ctx,
 	return focus_title(self, ctx, x);
 }
 
-static gp_widget *json_to_tabs(json_object *json, void **uids)
+static gp_widget *json_to_tabs(const gp_bjson *json, void **uids)
 {
-	json_object *widgets = NULL;
-	json_object *labels = NULL;
+	const gp_bjson *widgets = NULL;
+	const gp_bjson *labels = NULL;
+	int lazy = 0;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "labels"))
 			labels = val;
 		else if (!strcmp(key, "widgets"))
 			widgets = val;
+		else if (!strcmp(key, "lazy"))
+			lazy = gp_bjson_bool(val);
 		else
 			GP_WARN("Invalid tabs key '%s'", key);
 	}
@@ -426,38 +447,52 @@ static gp_widget *json_to_tabs(json_object *json, void **uids)
 		return NULL;
 	}
 
-	if (!json_object_is_type(labels, json_type_array)) {
+	if (!gp_bjson_is_type(labels, GP_BJSON_ARRAY)) {
 		GP_WARN("Tabs has to be array of strings!");
 		return NULL;
 	}
 
-	if (!json_object_is_type(widgets, json_type_array)) {
+	if (!gp_bjson_is_type(widgets, GP_BJSON_ARRAY)) {
 		GP_WARN("Tabs has to be array of strings!");
 		return NULL;
 	}
 
-	unsigned int i, tab_count = json_object_array_length(labels);
+	unsigned int i, tab_count = gp_bjson_len(labels);
 	const char *tab_labels[tab_count];
 
 	for (i = 0; i < tab_count; i++) {
-		json_object *label = json_object_array_get_idx(labels, i);
-		tab_labels[i] = json_object_get_string(label);
+		const gp_bjson *label = gp_bjson_idx(labels, i);
+		tab_labels[i] = gp_bjson_str(label);
 
 		if (!tab_labels[i])
 			GP_WARN("Tab title %i must be string!", i);
 	}
 
 	gp_widget *ret = gp_widget_tabs_new(tab_count, 0, tab_labels);
+	if (!ret)
+		return NULL;
+
+	if (lazy && tab_count > 1) {
+		ret->tabs->lazy = calloc(tab_count, sizeof(gp_widget_lazy *));
+		if (!ret->tabs->lazy)
+			GP_WARN("Malloc failed, loading all tabs");
+	}
 
 	for (i = 0; i < tab_count; i++) {
-		json_object *json_widget = json_object_array_get_idx(widgets, i);
+		const gp_bjson *json_widget = gp_bjson_idx(widgets, i);
 
 		if (!json_widget) {
 			GP_WARN("Not enough widgets to fill tabs!");
 			return ret;
 		}
 
-		ret->tabs->widgets[i] = gp_widget_from_json(json_widget, uids);
+		if (ret->tabs->lazy && i != ret->tabs->active_tab) {
+			ret->tabs->lazy[i] = gp_widget_lazy_new(json_widget, uids);
+			if (ret->tabs->lazy[i])
+				continue;
+		}
+
+		ret->tabs->widgets[i] = gp_widget_from_bjson(json_widget, uids);
 
 		gp_widget_set_parent(ret->tabs->widgets[i], ret);
 	}
@@ -466,12 +501,29 @@ static gp_widget *json_to_tabs(json_object *json, void **uids)
 	return ret;
 }
 
+static void for_each_child(gp_widget *self,
+                           void (*func)(gp_widget *child, void *priv),
+                           void *priv)
+{
+	unsigned int i;
+
+	for (i = 0; i < self->tabs->count; i++) {
+		if (self->tabs->widgets[i])
+			func(self->tabs->widgets[i], priv);
+	}
+}
+
 static void free_(gp_widget *self)
 {
 	unsigned int i;
 
+	if (!self->tabs->lazy)
+		return;
+
 	for (i = 0; i < self->tabs->count; i++)
-		gp_widget_free(self->tabs->widgets[i]);
+		gp_widget_lazy_free(self->tabs->lazy[i]);
+
+	free(self->tabs->lazy);
 }
 
 struct gp_widget_ops gp_widget_tabs_ops = {
@@ -479,10 +531,11 @@ struct gp_widget_ops gp_widget_tabs_ops = {
 	.min_h = min_h,
 	.render = render,
 	.event = event,
-	.free = free_,
 	.focus = focus,
 	.focus_xy = focus_xy,
 	.distribute_size = distribute_size,
+	.for_each_child = for_each_child,
+	.free = free_,
 	.from_json = json_to_tabs,
 	.id = "tabs",
 };
@@ -492,6 +545,8 @@ gp_widget *gp_widget_tabs_new(unsigned int tabs, unsigned int active_tab,
 {
 	size_t size = sizeof(struct gp_widget_tabs) + tabs * sizeof(void*);
 
+	size += tabs * sizeof(gp_text_cache);
+
 	size += gp_string_arr_size(tab_labels, tabs);
 
 	gp_widget *ret = gp_widget_new(GP_WIDGET_TABS, size);
@@ -511,6 +566,8 @@ gp_widget *gp_widget_tabs_new(unsigned int tabs, unsigned int active_tab,
 	ret->tabs->active_tab = active_tab;
 	ret->tabs->widgets = payload;
 	payload += tabs * sizeof(void*);
+	ret->tabs->label_widths = payload;
+	payload += tabs * sizeof(gp_text_cache);
 	ret->tabs->labels = gp_string_arr_copy(tab_labels, tabs, payload);
 
 	return ret;
@@ -528,6 +585,11 @@ gp_widget *gp_widget_tabs_put(gp_widget *self, unsigned int tab,
 		return NULL;
 	}
 
+	if (self->tabs->lazy) {
+		gp_widget_lazy_free(self->tabs->lazy[tab]);
+		self->tabs->lazy[tab] = NULL;
+	}
+
 	ret = self->tabs->widgets[tab];
 	if (ret)
 		ret->parent = NULL;
@@ -541,3 +603,15 @@ gp_widget *gp_widget_tabs_put(gp_widget *self, unsigned int tab,
 
 	return ret;
 }
+
+void gp_widget_tabs_set_active(gp_widget *self, unsigned int tab)
+{
+	GP_WIDGET_ASSERT(self, GP_WIDGET_TABS, );
+
+	if (tab >= self->tabs->count) {
+		GP_WARN("Invalid tabs index %u", tab);
+		return;
+	}
+
+	set_tab(self, tab);
+}
@@ -7,7 +7,6 @@
  */
 
 #include <string.h>
-#include <json-c/json.h>
 
 #include <utils/gp_vec_str.h>
 
@@ -300,7 +299,7 @@ static int event(gp_widget *self, const gp_widget_render_ctx *ctx, gp_event *ev)
 	return 0;
 }
 
-static gp_widget *json_to_textbox(json_object *json, void **uid)
+static gp_widget *json_to_textbox(const gp_bjson *json, void **uid)
 {
 	gp_widget *ret;
 	const char *text = NULL;
@@ -310,15 +309,15 @@ static gp_widget *json_to_textbox(json_object *json, void **uid)
 
 	(void)uid;
 
-	json_object_object_foreach(json, key, val) {
+	gp_widget_json_foreach(json, key, val) {
 		if (!strcmp(key, "text"))
-			text = json_object_get_string(val);
+			text = gp_bjson_str(val);
 		else if (!strcmp(key, "size"))
-			size = json_object_get_int(val);
+			size = gp_bjson_int(val);
 		else if (!strcmp(key, "hidden"))
-			flags |= json_object_get_boolean(val) ? GP_WIDGET_TEXT_BOX_HIDDEN : 0;
+			flags |= gp_bjson_bool(val) ? GP_WIDGET_TEXT_BOX_HIDDEN : 0;
 		else if (!strcmp(key, "max_size"))
-			max_size = json_object_get_int(val);
+			max_size = gp_bjson_int(val);
 		else
 			GP_WARN("Invalid textbox key '%s'", key);
 	}
@@ -389,7 +388,7 @@ struct gp_widget *gp_widget_textbox_new(const char *text, unsigned int size,
 
 	return ret;
 err:
-	free(ret);
+	gp_widget_free(ret);
 	return NULL;
 }
 
@@ -0,0 +1,128 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+#include <stdlib.h>
+
+#include <core/gp_debug.h>
+#include <gp_widget_ops.h>
+#include <gp_widget_event.h>
+#include <gp_widget_trace.h>
+#include "gp_clock.h"
+
+struct gp_widget_trace gp_widget_trace_buf;
+
+void gp_widget_trace_rec_add(uint8_t type, uint8_t sub, uint16_t code,
+                             int32_t val, const void *ptr)
+{
+	struct gp_widget_trace *trace = &gp_widget_trace_buf;
+	gp_widget_trace_rec *rec = &trace->recs[trace->pos++ & (trace->size - 1)];
+
+	rec->ts = gp_clock_ns();
+	rec->ptr = ptr;
+	rec->type = type;
+	rec->sub = sub;
+	rec->code = code;
+	rec->val = val;
+}
+
+static void trace_dump_on_exit(void)
+{
+	gp_widget_trace_dump(stderr);
+}
+
+int gp_widget_trace_init(unsigned int records, int dump_on_exit)
+{
+	static int exit_registered;
+	unsigned int size = 1;
+
+	while (size < records)
+		size <<= 1;
+
+	gp_widget_trace_rec *recs = malloc(size * sizeof(*recs));
+	if (!recs) {
+		GP_WARN("Failed to allocate trace buffer");
+		return 1;
+	}
+
+	free(gp_widget_trace_buf.recs);
+
+	gp_widget_trace_buf.pos = 0;
+	gp_widget_trace_buf.size = size;
+	gp_widget_trace_buf.recs = recs;
+
+	GP_DEBUG(1, "Tracing enabled, buffer size %u records", size);
+
+	if (dump_on_exit && !exit_registered) {
+		atexit(trace_dump_on_exit);
+		exit_registered = 1;
+	}
+
+	return 0;
+}
+
+void gp_widget_trace_exit(void)
+{
+	free(gp_widget_trace_buf.recs);
+	gp_widget_trace_buf.recs = NULL;
+}
+
+static const char *phase_name(uint8_t sub)
+{
+	return sub == GP_WIDGET_TRACE_START ? "start" : "end";
+}
+
+static void rec_dump(FILE *f, const gp_widget_trace_rec *rec, uint64_t start)
+{
+	fprintf(f, "%12.3f ", (double)(rec->ts - start) / 1000);
+
+	switch (rec->type) {
+	case GP_WIDGET_TRACE_INPUT:
+		fprintf(f, "input  type %u code %u val %i\n",
+		        rec->sub, rec->code, rec->val);
+	break;
+	case GP_WIDGET_TRACE_EVENT:
+		fprintf(f, "event  %s for %p (%s)\n",
+		        gp_widget_event_type_name(rec->code), rec->ptr,
+		        gp_widget_type_name(rec->val));
+	break;
+	case GP_WIDGET_TRACE_LAYOUT:
+		fprintf(f, "layout %s %p\n", phase_name(rec->sub), rec->ptr);
+	break;
+	case GP_WIDGET_TRACE_RENDER:
+		fprintf(f, "render %s %p\n", phase_name(rec->sub), rec->ptr);
+	break;
+	case GP_WIDGET_TRACE_FLIP:
+		fprintf(f, "flip   %i rects\n", rec->val);
+	break;
+	case GP_WIDGET_TRACE_FRAME:
+		fprintf(f, "frame  %i us\n", rec->val);
+	break;
+	default:
+		fprintf(f, "invalid record type %u\n", rec->type);
+	}
+}
+
+void gp_widget_trace_dump(FILE *f)
+{
+	struct gp_widget_trace *trace = &gp_widget_trace_buf;
+	unsigned long i, first = 0;
+
+	if (!trace->recs || !trace->pos)
+		return;
+
+	if (trace->pos > trace->size)
+		first = trace->pos - trace->size;
+
+	uint64_t start = trace->recs[first & (trace->size - 1)].ts;
+
+	fprintf(f, "Widget trace, %lu records, %lu dropped, time in us\n",
+	        trace->pos - first, first);
+
+	for (i = first; i < trace->pos; i++)
+		rec_dump(f, &trace->recs[i & (trace->size - 1)], start);
+}
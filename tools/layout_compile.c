@@ -0,0 +1,44 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Compiles a JSON layout into a binary layout that can be loaded by
+ * gp_widget_layout_bjson().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gp_widgets.h>
+
+int main(int argc, char *argv[])
+{
+	gp_bjson_hdr *hdr;
+	int ret;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s layout.json layout.bjson\n", argv[0]);
+		return 1;
+	}
+
+	hdr = gp_widget_layout_compile(argv[1]);
+	if (!hdr) {
+		fprintf(stderr, "Failed to compile '%s'\n", argv[1]);
+		return 1;
+	}
+
+	ret = gp_bjson_save(hdr, argv[2]);
+
+	if (!ret) {
+		printf("%s: %u nodes, %u bytes\n", argv[2],
+		       (unsigned int)hdr->nodes, (unsigned int)hdr->size);
+	}
+
+	free(hdr);
+
+	return ret;
+}
@@ -0,0 +1,1403 @@
+//SPDX-License-Identifier: LGPL-2.0-or-later
+
+/*
+
+   Copyright (c) 2014-2020 Cyril Hrubis <metan@ucw.cz>
+
+ */
+
+/*
+ * Generates C code that builds a JSON layout with direct gp_widget_*_new()
+ * calls.
+ *
+ * The generated prefix.c defines gp_widget *prefix_layout(void) and a
+ * gp_widget *prefix_uid pointer for each widget uid, prefix.h declares these.
+ * Callbacks are referenced directly and bound at link time, the application
+ * has to define them with the right prototypes.
+ *
+ * The generated code follows the same rules as the JSON loader, i.e. each
+ * widget gets its alignment, on_event callback and uid set and receives the
+ * NEW event once its children have been created.
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gp_widgets.h>
+
+struct callback {
+	struct callback *next;
+	const char *proto;
+	char name[];
+};
+
+struct uid {
+	struct uid *next;
+	char name[];
+};
+
+struct gen {
+	const char *prefix;
+	/* static data and callback declarations */
+	FILE *decl;
+	/* layout function body */
+	FILE *body;
+	/* uid declarations for the header */
+	FILE *hdr;
+	unsigned int widgets;
+	unsigned int arrays;
+	struct callback *callbacks;
+	struct uid *uids;
+	int err;
+};
+
+#define CALLBACK_ON_EVENT "int %s(gp_widget_event *ev)"
+#define CALLBACK_CALL "gp_widget *%s(void)"
+#define CALLBACK_MARKUP_GET "char *%s(unsigned int var_id, char *old_val)"
+#define CALLBACK_TABLE_ROW "int %s(gp_widget *self, int op, unsigned int pos)"
+#define CALLBACK_TABLE_GET "const char *%s(gp_widget *self, unsigned int col)"
+#define CALLBACK_TABLE_SORT "void %s(gp_widget *self, unsigned int col, int desc)"
+#define CALLBACK_TABLE_MODEL "extern const gp_widget_table_model %s"
+#define CALLBACK_LIST_MODEL "extern const gp_widget_list_model %s"
+
+static void error(struct gen *g, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static void error(struct gen *g, const char *fmt, ...)
+{
+	va_list va;
+
+	fprintf(stderr, "error: ");
+	va_start(va, fmt);
+	vfprintf(stderr, fmt, va);
+	va_end(va);
+	fprintf(stderr, "\n");
+
+	g->err = 1;
+}
+
+static void warn(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void warn(const char *fmt, ...)
+{
+	va_list va;
+
+	fprintf(stderr, "warning: ");
+	va_start(va, fmt);
+	vfprintf(stderr, fmt, va);
+	va_end(va);
+	fprintf(stderr, "\n");
+}
+
+static int is_ident(const char *str)
+{
+	if (!str || !*str || isdigit(*str))
+		return 0;
+
+	for (; *str; str++) {
+		if (!isalnum(*str) && *str != '_')
+			return 0;
+	}
+
+	return 1;
+}
+
+static void put_str(FILE *f, const char *str)
+{
+	if (!str) {
+		fprintf(f, "NULL");
+		return;
+	}
+
+	fputc('"', f);
+
+	for (; *str; str++) {
+		unsigned char c = *str;
+
+		switch (c) {
+		case '"':
+		case '\\':
+			fprintf(f, "\\%c", c);
+		break;
+		case '\n':
+			fprintf(f, "\\n");
+		break;
+		case '\t':
+			fprintf(f, "\\t");
+		break;
+		default:
+			if (c < 0x20 || c == 0x7f)
+				fprintf(f, "\\%03o", c);
+			else
+				fputc(c, f);
+		}
+	}
+
+	fputc('"', f);
+}
+
+static void put_ref(FILE *f, int id)
+{
+	if (id < 0)
+		fprintf(f, "NULL");
+	else
+		fprintf(f, "w[%i]", id);
+}
+
+/*
+ * Declares a callback, returns the callback name or "NULL" if there is no
+ * callback.
+ */
+static const char *callback(struct gen *g, const gp_bjson *json, const char *proto)
+{
+	const char *name = gp_bjson_str(json);
+	struct callback *cb;
+
+	if (!json)
+		return "NULL";
+
+	if (!is_ident(name)) {
+		error(g, "Invalid callback name '%s'", name ? name : "null");
+		return "NULL";
+	}
+
+	for (cb = g->callbacks; cb; cb = cb->next) {
+		if (strcmp(cb->name, name))
+			continue;
+
+		if (strcmp(cb->proto, proto))
+			error(g, "Callback '%s' used with different prototypes", name);
+
+		return cb->name;
+	}
+
+	cb = malloc(sizeof(*cb) + strlen(name) + 1);
+	if (!cb) {
+		error(g, "Malloc failed :-(");
+		return "NULL";
+	}
+
+	strcpy(cb->name, name);
+	cb->proto = proto;
+	cb->next = g->callbacks;
+	g->callbacks = cb;
+
+	fprintf(g->decl, proto, name);
+	fprintf(g->decl, ";\n");
+
+	return cb->name;
+}
+
+static int new_widget(struct gen *g)
+{
+	return g->widgets++;
+}
+
+static void check_widget(struct gen *g, int id)
+{
+	fprintf(g->body, "\tif (!w[%i])\n\t\tgoto err;\n", id);
+}
+
+static unsigned int str_array(struct gen *g, const gp_bjson *json, const char *what)
+{
+	unsigned int i, id = g->arrays++;
+
+	fprintf(g->decl, "\nstatic const char *%s_arr%u[] = {\n", g->prefix, id);
+
+	for (i = 0; i < gp_bjson_len(json); i++) {
+		const char *str = gp_bjson_str(gp_bjson_idx(json, i));
+
+		if (!str)
+			warn("%s %u must be string!", what, i);
+
+		fprintf(g->decl, "\t");
+		put_str(g->decl, str);
+		fprintf(g->decl, ",\n");
+	}
+
+	fprintf(g->decl, "};\n");
+
+	return id;
+}
+
+static int emit_widget(struct gen *g, const gp_bjson *json);
+
+static int emit_button(struct gen *g, const gp_bjson *json)
+{
+	const char *label = NULL;
+	int id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "label"))
+			label = gp_bjson_str(val);
+		else
+			warn("Invalid button key '%s'", key);
+	}
+
+	if (!label) {
+		error(g, "Missing button label");
+		return -1;
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_button_new(", id);
+	put_str(g->body, label);
+	fprintf(g->body, ", NULL, NULL);\n");
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_checkbox(struct gen *g, const gp_bjson *json)
+{
+	const char *label = NULL;
+	int set = 0, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "label"))
+			label = gp_bjson_str(val);
+		else if (!strcmp(key, "set"))
+			set = gp_bjson_bool(val);
+		else
+			warn("Invalid checkbox key '%s'", key);
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_checkbox_new(", id);
+	put_str(g->body, label);
+	fprintf(g->body, ", %i, NULL, NULL);\n", set);
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_frame(struct gen *g, const gp_bjson *json)
+{
+	const char *label = NULL;
+	const gp_bjson *jwidget = NULL;
+	int bold = 0, id, child;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "label"))
+			label = gp_bjson_str(val);
+		else if (!strcmp(key, "widget"))
+			jwidget = val;
+		else if (!strcmp(key, "bold"))
+			bold = 1;
+		else
+			warn("Invalid frame key '%s'", key);
+	}
+
+	child = emit_widget(g, jwidget);
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_frame_new(", id);
+	put_str(g->body, label);
+	fprintf(g->body, ", %i, ", bold);
+	put_ref(g->body, child);
+	fprintf(g->body, ");\n");
+	check_widget(g, id);
+
+	return id;
+}
+
+static void emit_coefs(struct gen *g, int id, const char *name,
+                       uint8_t *coefs, unsigned int len, uint8_t def)
+{
+	unsigned int i;
+
+	for (i = 0; i < len; i++) {
+		if (coefs[i] != def)
+			fprintf(g->body, "\tw[%i]->grid->%s[%u] = %u;\n", id, name, i, coefs[i]);
+	}
+}
+
+static int emit_grid(struct gen *g, const gp_bjson *json)
+{
+	int cols = 0, rows = 0, frame = 0, uniform = 0, sparse = 0;
+	const gp_bjson *widgets = NULL;
+	const char *border = NULL;
+	const char *cpad = NULL, *rpad = NULL;
+	const char *cpadf = NULL, *rpadf = NULL;
+	const char *cfill = NULL, *rfill = NULL;
+	int col, row, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "cols"))
+			cols = gp_bjson_int(val);
+		else if (!strcmp(key, "rows"))
+			rows = gp_bjson_int(val);
+		else if (!strcmp(key, "widgets"))
+			widgets = val;
+		else if (!strcmp(key, "border"))
+			border = gp_bjson_str(val);
+		else if (!strcmp(key, "cpad"))
+			cpad = gp_bjson_str(val);
+		else if (!strcmp(key, "rpad"))
+			rpad = gp_bjson_str(val);
+		else if (!strcmp(key, "cpadf"))
+			cpadf = gp_bjson_str(val);
+		else if (!strcmp(key, "rpadf"))
+			rpadf = gp_bjson_str(val);
+		else if (!strcmp(key, "cfill"))
+			cfill = gp_bjson_str(val);
+		else if (!strcmp(key, "rfill"))
+			rfill = gp_bjson_str(val);
+		else if (!strcmp(key, "frame"))
+			frame = !!gp_bjson_int(val);
+		else if (!strcmp(key, "uniform"))
+			uniform = 1;
+		else if (!strcmp(key, "sparse"))
+			sparse = !!gp_bjson_int(val);
+		else
+			warn("Invalid grid key '%s'", key);
+	}
+
+	if (!cols)
+		cols = 1;
+
+	if (!rows)
+		rows = 1;
+
+	if (cols <= 0 || rows <= 0 || !gp_bjson_is_type(widgets, GP_BJSON_ARRAY)) {
+		error(g, "Invalid grid widget!");
+		return -1;
+	}
+
+	int children[cols * rows];
+	unsigned int cnt = gp_bjson_len(widgets);
+
+	for (col = 0; col < cols; col++) {
+		for (row = 0; row < rows; row++) {
+			unsigned int i = col * rows + row;
+
+			if (i == cnt)
+				warn("Not enough widgets to fill grid!");
+
+			children[i] = i < cnt ? emit_widget(g, gp_bjson_idx(widgets, i)) : -1;
+		}
+	}
+
+	if (cnt > (unsigned int)(cols * rows))
+		warn("Too many widgets in grid!");
+
+	uint8_t col_padds[cols + 1], row_padds[rows + 1];
+	uint8_t col_pfills[cols + 1], row_pfills[rows + 1];
+	uint8_t col_fills[cols], row_fills[rows];
+
+	memset(col_padds, 1, sizeof(col_padds));
+	memset(row_padds, 1, sizeof(row_padds));
+	memset(col_pfills, 0, sizeof(col_pfills));
+	memset(row_pfills, 0, sizeof(row_pfills));
+	memset(col_fills, 1, sizeof(col_fills));
+	memset(row_fills, 1, sizeof(row_fills));
+
+	gp_widget_grid_coefs_parse(cpad, col_padds, cols+1, "Grid cpad");
+	gp_widget_grid_coefs_parse(rpad, row_padds, rows+1, "Grid rpad");
+	gp_widget_grid_coefs_parse(cpadf, col_pfills, cols+1, "Grid cpadf");
+	gp_widget_grid_coefs_parse(rpadf, row_pfills, rows+1, "Grid rpadf");
+	gp_widget_grid_coefs_parse(cfill, col_fills, cols, "Grid cfill");
+	gp_widget_grid_coefs_parse(rfill, row_fills, rows, "Grid rfill");
+
+	if (border) {
+		int b = -1, horiz = 1, vert = 1;
+
+		if (!strcmp(border, "horiz")) {
+			b = 0;
+			horiz = 0;
+		} else if (!strcmp(border, "vert")) {
+			b = 0;
+			vert = 0;
+		} else if (!strcmp(border, "none")) {
+			b = 0;
+		} else if (strcmp(border, "all")) {
+			b = atoi(border);
+
+			if (b <= 0) {
+				warn("Invalid border '%s'", border);
+				b = -1;
+			}
+		}
+
+		if (b >= 0 && vert)
+			row_padds[0] = row_padds[rows] = b;
+
+		if (b >= 0 && horiz)
+			col_padds[0] = col_padds[cols] = b;
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_grid_%snew(%i, %i);\n",
+	        id, sparse ? "sparse_" : "", cols, rows);
+	check_widget(g, id);
+
+	if (frame)
+		fprintf(g->body, "\tw[%i]->grid->frame = 1;\n", id);
+
+	if (uniform)
+		fprintf(g->body, "\tw[%i]->grid->uniform = 1;\n", id);
+
+	emit_coefs(g, id, "col_padds", col_padds, cols + 1, 1);
+	emit_coefs(g, id, "row_padds", row_padds, rows + 1, 1);
+	emit_coefs(g, id, "col_pfills", col_pfills, cols + 1, 0);
+	emit_coefs(g, id, "row_pfills", row_pfills, rows + 1, 0);
+	emit_coefs(g, id, "col_fills", col_fills, cols, 1);
+	emit_coefs(g, id, "row_fills", row_fills, rows, 1);
+
+	for (col = 0; col < cols; col++) {
+		for (row = 0; row < rows; row++) {
+			int child = children[col * rows + row];
+
+			if (child >= 0) {
+				fprintf(g->body, "\tgp_widget_grid_put(w[%i], %i, %i, w[%i]);\n",
+				        id, col, row, child);
+			}
+		}
+	}
+
+	return id;
+}
+
+static int emit_int(struct gen *g, const gp_bjson *json, int slider)
+{
+	const char *dir = NULL;
+	int min = 0, max = 0, ival = 0, val_set = 0, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "min"))
+			min = gp_bjson_int(val);
+		else if (!strcmp(key, "max"))
+			max = gp_bjson_int(val);
+		else if (!strcmp(key, "val")) {
+			ival = gp_bjson_int(val);
+			val_set = 1;
+		} else if (!strcmp(key, "dir") && slider)
+			dir = gp_bjson_str(val);
+		else
+			warn("Invalid int key '%s'", key);
+	}
+
+	if (!val_set)
+		ival = min;
+
+	if (min >= max || ival < min || ival > max) {
+		error(g, "Invalid min %i max %i val %i", min, max, ival);
+		return -1;
+	}
+
+	id = new_widget(g);
+
+	if (!slider) {
+		fprintf(g->body, "\tw[%i] = gp_widget_spinner_new(%i, %i, %i);\n",
+		        id, min, max, ival);
+		check_widget(g, id);
+		return id;
+	}
+
+	const char *sdir = "GP_WIDGET_HORIZ";
+
+	if (dir) {
+		if (!strcmp(dir, "vert"))
+			sdir = "GP_WIDGET_VERT";
+		else if (strcmp(dir, "horiz"))
+			warn("Invalid direction '%s'", dir);
+	}
+
+	fprintf(g->body, "\tw[%i] = gp_widget_slider_new(%i, %i, %i, %s, NULL, NULL);\n",
+	        id, min, max, ival, sdir);
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_spinner(struct gen *g, const gp_bjson *json)
+{
+	return emit_int(g, json, 0);
+}
+
+static int emit_slider(struct gen *g, const gp_bjson *json)
+{
+	return emit_int(g, json, 1);
+}
+
+static int emit_label(struct gen *g, const gp_bjson *json)
+{
+	const char *label = NULL;
+	int bold = 0, size = 0, ralign = 0, frame = 0, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "text"))
+			label = gp_bjson_str(val);
+		else if (!strcmp(key, "bold"))
+			bold = gp_bjson_bool(val);
+		else if (!strcmp(key, "size"))
+			size = gp_bjson_int(val);
+		else if (!strcmp(key, "ralign"))
+			ralign = gp_bjson_bool(val);
+		else if (!strcmp(key, "frame"))
+			frame = gp_bjson_bool(val);
+		else
+			warn("Invalid label key '%s'", key);
+	}
+
+	if (!label) {
+		warn("Missing label");
+		label = "Missing label";
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_label_new(", id);
+	put_str(g->body, label);
+	fprintf(g->body, ", %i, %i);\n", size, bold);
+	check_widget(g, id);
+
+	if (ralign)
+		fprintf(g->body, "\tw[%i]->label->ralign = 1;\n", id);
+
+	if (frame)
+		fprintf(g->body, "\tw[%i]->label->frame = 1;\n", id);
+
+	return id;
+}
+
+static int emit_markup(struct gen *g, const gp_bjson *json)
+{
+	const char *markup = NULL;
+	const char *get = "NULL";
+	int id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "text"))
+			markup = gp_bjson_str(val);
+		else if (!strcmp(key, "get"))
+			get = callback(g, val, CALLBACK_MARKUP_GET);
+		else
+			warn("Invalid markup key '%s'", key);
+	}
+
+	if (!markup) {
+		warn("Missing markup");
+		markup = "Missing markup";
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_markup_new(", id);
+	put_str(g->body, markup);
+	fprintf(g->body, ", %s);\n", get);
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_layers(struct gen *g, const gp_bjson *json, const char *type)
+{
+	const gp_bjson *widgets = NULL;
+	const gp_bjson *hidden = NULL;
+	unsigned int i, cnt;
+	int id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "widgets"))
+			widgets = val;
+		else if (!strcmp(key, "hidden") && !strcmp(type, "overlay"))
+			hidden = val;
+		else if (!strcmp(key, "lazy"))
+			continue;
+		else
+			warn("Invalid %s key '%s'", type, key);
+	}
+
+	if (!gp_bjson_is_type(widgets, GP_BJSON_ARRAY)) {
+		error(g, "Missing %s widgets array!", type);
+		return -1;
+	}
+
+	cnt = gp_bjson_len(widgets);
+
+	int children[cnt + 1];
+
+	for (i = 0; i < cnt; i++)
+		children[i] = emit_widget(g, gp_bjson_idx(widgets, i));
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_%s_new(%u);\n", id, type, cnt);
+	check_widget(g, id);
+
+	for (i = 0; i < cnt; i++) {
+		if (children[i] >= 0) {
+			fprintf(g->body, "\tgp_widget_%s_put(w[%i], %u, w[%i]);\n",
+			        type, id, i, children[i]);
+		}
+	}
+
+	for (i = 0; i < gp_bjson_len(hidden); i++) {
+		fprintf(g->body, "\tgp_widget_overlay_hide(w[%i], %i);\n",
+		        id, gp_bjson_int(gp_bjson_idx(hidden, i)));
+	}
+
+	return id;
+}
+
+static int emit_list(struct gen *g, const gp_bjson *json)
+{
+	const char *model = "NULL";
+	int min_w = 0, min_h = 0, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "min_w"))
+			min_w = gp_bjson_int(val);
+		else if (!strcmp(key, "min_h"))
+			min_h = gp_bjson_int(val);
+		else if (!strcmp(key, "model"))
+			model = callback(g, val, CALLBACK_LIST_MODEL);
+		else
+			warn("Invalid list key '%s'", key);
+	}
+
+	if (min_w < 0 || min_h <= 0) {
+		error(g, "Invalid list min_w %i min_h %i", min_w, min_h);
+		return -1;
+	}
+
+	if (!strcmp(model, "NULL")) {
+		error(g, "Missing list model");
+		return -1;
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_list_new(%i, %i, &%s, NULL);\n",
+	        id, min_w, min_h, model);
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_overlay(struct gen *g, const gp_bjson *json)
+{
+	return emit_layers(g, json, "overlay");
+}
+
+static int emit_switch(struct gen *g, const gp_bjson *json)
+{
+	return emit_layers(g, json, "switch");
+}
+
+static int emit_pbar(struct gen *g, const gp_bjson *json)
+{
+	double val = 0, max = 100;
+	const char *type = NULL;
+	const char *ptype = "GP_WIDGET_PBAR_PERCENTS";
+	int inverse = 0, id;
+
+	gp_widget_json_foreach(json, key, jval) {
+		if (!strcmp(key, "val"))
+			val = gp_bjson_double(jval);
+		else if (!strcmp(key, "ptype"))
+			type = gp_bjson_str(jval);
+		else if (!strcmp(key, "max"))
+			max = gp_bjson_double(jval);
+		else if (!strcmp(key, "inverse"))
+			inverse = gp_bjson_bool(jval);
+		else
+			warn("Invalid int pbar '%s'", key);
+	}
+
+	if (max <= 0) {
+		warn("Invalid progressbar max %lf", max);
+		max = 100;
+	}
+
+	if (val < 0 || val > max) {
+		warn("Invalid progressbar value %lf", val);
+		val = 0;
+	}
+
+	if (type) {
+		if (!strcmp(type, "none"))
+			ptype = "GP_WIDGET_PBAR_NONE";
+		else if (!strcmp(type, "seconds"))
+			ptype = "GP_WIDGET_PBAR_SECONDS";
+		else if (strcmp(type, "percents"))
+			warn("Invalid type '%s'", type);
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_pbar_new(%.9g, %.9g, %s%s);\n",
+	        id, val, max, ptype, inverse ? " | GP_WIDGET_PBAR_INVERSE" : "");
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_pixmap(struct gen *g, const gp_bjson *json)
+{
+	int w = 0, h = 0, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "w"))
+			w = gp_bjson_int(val);
+		else if (!strcmp(key, "h"))
+			h = gp_bjson_int(val);
+		else
+			warn("Invalid pixmap key '%s'", key);
+	}
+
+	if (w <= 0 || h <= 0) {
+		error(g, "Invalid pixmap size %ix%i", w, h);
+		return -1;
+	}
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_pixmap_new(%i, %i, NULL, NULL);\n", id, w, h);
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_radiobutton(struct gen *g, const gp_bjson *json)
+{
+	const gp_bjson *labels = NULL;
+	int sel = 0, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "buttons"))
+			labels = val;
+		else if (!strcmp(key, "selected"))
+			sel = gp_bjson_int(val);
+		else
+			warn("Invalid radiobutton key '%s'", key);
+	}
+
+	if (!gp_bjson_is_type(labels, GP_BJSON_ARRAY)) {
+		error(g, "Missing radiobutton buttons array!");
+		return -1;
+	}
+
+	unsigned int cnt = gp_bjson_len(labels);
+
+	if (sel < 0 || (unsigned int)sel >= cnt) {
+		warn("Invalid selected button %i", sel);
+		sel = 0;
+	}
+
+	unsigned int arr = str_array(g, labels, "Button");
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_choice_new(%s_arr%u, %u, %i, NULL, NULL);\n",
+	        id, g->prefix, arr, cnt, sel);
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_scroll_area(struct gen *g, const gp_bjson *json)
+{
+	const gp_bjson *jwidget = NULL;
+	int min_w = 0, min_h = 0, id, child;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "min_w"))
+			min_w = gp_bjson_int(val);
+		else if (!strcmp(key, "min_h"))
+			min_h = gp_bjson_int(val);
+		else if (!strcmp(key, "widget"))
+			jwidget = val;
+		else
+			warn("Invalid scroll area key '%s'", key);
+	}
+
+	if (min_w < 0 || min_h < 0 || (min_w == 0 && min_h == 0)) {
+		error(g, "Invalid scroll area min_w %i min_h %i", min_w, min_h);
+		return -1;
+	}
+
+	child = emit_widget(g, jwidget);
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_scroll_area_new(%i, %i, ", id, min_w, min_h);
+	put_ref(g->body, child);
+	fprintf(g->body, ");\n");
+	check_widget(g, id);
+
+	return id;
+}
+
+static int emit_table(struct gen *g, const gp_bjson *json)
+{
+	int cols = -1, min_rows = -1, id, hdr = -1, cache = 0;
+	const char *set_row = "NULL", *get_elem = "NULL", *sort = "NULL";
+	const char *model = "NULL";
+	const gp_bjson *header = NULL;
+	unsigned int i;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "cols"))
+			cols = gp_bjson_int(val);
+		else if (!strcmp(key, "min_rows"))
+			min_rows = gp_bjson_int(val);
+		else if (!strcmp(key, "set_row"))
+			set_row = callback(g, val, CALLBACK_TABLE_ROW);
+		else if (!strcmp(key, "get_elem"))
+			get_elem = callback(g, val, CALLBACK_TABLE_GET);
+		else if (!strcmp(key, "sort"))
+			sort = callback(g, val, CALLBACK_TABLE_SORT);
+		else if (!strcmp(key, "model"))
+			model = callback(g, val, CALLBACK_TABLE_MODEL);
+		else if (!strcmp(key, "cache"))
+			cache = gp_bjson_bool(val);
+		else if (!strcmp(key, "header"))
+			header = val;
+		else
+			warn("Invalid table key '%s'", key);
+	}
+
+	if (header) {
+		if (!gp_bjson_is_type(header, GP_BJSON_ARRAY)) {
+			error(g, "Table header must be array!");
+			return -1;
+		}
+
+		if (cols == -1)
+			cols = gp_bjson_len(header);
+
+		if (gp_bjson_len(header) != (unsigned int)cols) {
+			error(g, "Table header is not equal to number of columns!");
+			return -1;
+		}
+
+		hdr = g->arrays++;
+
+		fprintf(g->decl, "\nstatic const gp_widget_table_header %s_arr%i[] = {\n",
+		        g->prefix, hdr);
+
+		for (i = 0; i < gp_bjson_len(header); i++) {
+			const gp_bjson *elem = gp_bjson_idx(header, i);
+			const char *label = gp_bjson_str(gp_bjson_get(elem, "label"));
+
+			if (!label) {
+				error(g, "Table header %u is missing label", i);
+				return -1;
+			}
+
+			fprintf(g->decl, "\t{.text = ");
+			put_str(g->decl, label);
+			if (gp_bjson_bool(gp_bjson_get(elem, "sortable")))
+				fprintf(g->decl, ", .sortable = 1");
+			fprintf(g->decl, "},\n");
+		}
+
+		fprintf(g->decl, "};\n");
+	}
+
+	if (cols < 0 || min_rows < 0) {
+		error(g, "Invalid or missing table cols or min_rows");
+		return -1;
+	}
+
+	if (!strcmp(model, "NULL") &&
+	    (!strcmp(set_row, "NULL") || !strcmp(get_elem, "NULL"))) {
+		error(g, "Invalid or missing table set_row or get_elem callback");
+		return -1;
+	}
+
+	id = new_widget(g);
+
+	if (strcmp(model, "NULL"))
+		fprintf(g->body, "\tw[%i] = gp_widget_table_model_new(%i, %i, ", id, cols, min_rows);
+	else
+		fprintf(g->body, "\tw[%i] = gp_widget_table_new(%i, %i, ", id, cols, min_rows);
+
+	if (hdr >= 0)
+		fprintf(g->body, "%s_arr%i", g->prefix, hdr);
+	else
+		fprintf(g->body, "NULL");
+
+	if (strcmp(model, "NULL"))
+		fprintf(g->body, ", &%s);\n", model);
+	else
+		fprintf(g->body, ", %s, %s);\n", set_row, get_elem);
+	check_widget(g, id);
+
+	if (strcmp(sort, "NULL"))
+		fprintf(g->body, "\tw[%i]->tbl->sort = %s;\n", id, sort);
+
+	if (cache)
+		fprintf(g->body, "\tgp_widget_table_cache(w[%i], 1);\n", id);
+
+	return id;
+}
+
+static int emit_tabs(struct gen *g, const gp_bjson *json)
+{
+	const gp_bjson *widgets = NULL;
+	const gp_bjson *labels = NULL;
+	unsigned int i, cnt, arr;
+	int id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "labels"))
+			labels = val;
+		else if (!strcmp(key, "widgets"))
+			widgets = val;
+		else if (!strcmp(key, "lazy"))
+			continue;
+		else
+			warn("Invalid tabs key '%s'", key);
+	}
+
+	if (!gp_bjson_is_type(labels, GP_BJSON_ARRAY) ||
+	    !gp_bjson_is_type(widgets, GP_BJSON_ARRAY)) {
+		error(g, "Missing tabs labels or widgets array!");
+		return -1;
+	}
+
+	cnt = gp_bjson_len(labels);
+
+	int children[cnt + 1];
+
+	for (i = 0; i < cnt; i++) {
+		if (i == gp_bjson_len(widgets))
+			warn("Not enough widgets to fill tabs!");
+
+		children[i] = emit_widget(g, gp_bjson_idx(widgets, i));
+	}
+
+	arr = str_array(g, labels, "Tab title");
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_tabs_new(%u, 0, %s_arr%u);\n",
+	        id, cnt, g->prefix, arr);
+	check_widget(g, id);
+
+	for (i = 0; i < cnt; i++) {
+		if (children[i] >= 0) {
+			fprintf(g->body, "\tgp_widget_tabs_put(w[%i], %u, w[%i]);\n",
+			        id, i, children[i]);
+		}
+	}
+
+	return id;
+}
+
+static int emit_textbox(struct gen *g, const gp_bjson *json)
+{
+	const char *text = NULL;
+	int hidden = 0, size = 0, max_size = 0, id;
+
+	gp_widget_json_foreach(json, key, val) {
+		if (!strcmp(key, "text"))
+			text = gp_bjson_str(val);
+		else if (!strcmp(key, "size"))
+			size = gp_bjson_int(val);
+		else if (!strcmp(key, "hidden"))
+			hidden = gp_bjson_bool(val);
+		else if (!strcmp(key, "max_size"))
+			max_size = gp_bjson_int(val);
+		else
+			warn("Invalid textbox key '%s'", key);
+	}
+
+	if ((size <= 0 && !text) || max_size < 0) {
+		error(g, "Invalid textbox size %i max_size %i", size, max_size);
+		return -1;
+	}
+
+	if (size <= 0)
+		size = strlen(text);
+
+	if (text && max_size)
+		max_size = GP_MAX(max_size, (int)strlen(text));
+
+	id = new_widget(g);
+	fprintf(g->body, "\tw[%i] = gp_widget_textbox_new(", id);
+	put_str(g->body, text);
+	fprintf(g->body, ", %i, NULL, NULL, NULL, %s);\n",
+	        size, hidden ? "GP_WIDGET_TEXT_BOX_HIDDEN" : "0");
+	check_widget(g, id);
+
+	if (max_size)
+		fprintf(g->body, "\tw[%i]->tbox->max_size = %i;\n", id, max_size);
+
+	return id;
+}
+
+static const struct emitter {
+	const char *type;
+	int (*emit)(struct gen *g, const gp_bjson *json);
+} emitters[] = {
+	{"button", emit_button},
+	{"checkbox", emit_checkbox},
+	{"frame", emit_frame},
+	{"grid", emit_grid},
+	{"spinner", emit_spinner},
+	{"slider", emit_slider},
+	{"label", emit_label},
+	{"list", emit_list},
+	{"markup", emit_markup},
+	{"overlay", emit_overlay},
+	{"progressbar", emit_pbar},
+	{"pixmap", emit_pixmap},
+	{"radiobutton", emit_radiobutton},
+	{"scroll area", emit_scroll_area},
+	{"switch", emit_switch},
+	{"table", emit_table},
+	{"tabs", emit_tabs},
+	{"textbox", emit_textbox},
+};
+
+static const struct emitter *emitter_by_type(const char *type)
+{
+	unsigned int i;
+
+	for (i = 0; i < GP_ARRAY_SIZE(emitters); i++) {
+		if (!strcmp(emitters[i].type, type))
+			return &emitters[i];
+	}
+
+	return NULL;
+}
+
+static const char *halign_name(unsigned int align)
+{
+	switch (align) {
+	case GP_HCENTER:
+		return "GP_HCENTER";
+	case GP_LEFT:
+		return "GP_LEFT";
+	case GP_RIGHT:
+		return "GP_RIGHT";
+	case GP_HFILL:
+		return "GP_HFILL";
+	default:
+		return NULL;
+	}
+}
+
+static const char *valign_name(unsigned int align)
+{
+	switch (align) {
+	case GP_VCENTER:
+		return "GP_VCENTER";
+	case GP_TOP:
+		return "GP_TOP";
+	case GP_BOTTOM:
+		return "GP_BOTTOM";
+	case GP_VFILL:
+		return "GP_VFILL";
+	default:
+		return NULL;
+	}
+}
+
+static void emit_align(struct gen *g, int id, const gp_bjson *json)
+{
+	const char *align = gp_bjson_str(gp_bjson_get(json, "align"));
+	const char *halign_str = gp_bjson_str(gp_bjson_get(json, "halign"));
+	const char *valign_str = gp_bjson_str(gp_bjson_get(json, "valign"));
+	unsigned int halign = 0, valign = 0;
+
+	if (align) {
+		if (!strcmp(align, "center")) {
+			halign = GP_HCENTER;
+			valign = GP_VCENTER;
+		} else if (!strcmp(align, "fill")) {
+			halign = GP_HFILL;
+			valign = GP_VFILL;
+		} else if (!strcmp(align, "hfill")) {
+			halign = GP_HFILL;
+		} else if (!strcmp(align, "vfill")) {
+			valign = GP_VFILL;
+		} else {
+			warn("Invalid align=%s.", align);
+		}
+	}
+
+	if (halign_str) {
+		if (halign)
+			warn("Only one of halign and align can be defined!");
+
+		if (!strcmp(halign_str, "center"))
+			halign = GP_HCENTER;
+		else if (!strcmp(halign_str, "left"))
+			halign = GP_LEFT;
+		else if (!strcmp(halign_str, "right"))
+			halign = GP_RIGHT;
+		else if (!strcmp(halign_str, "fill"))
+			halign = GP_HFILL;
+		else
+			warn("Invalid halign=%s.", halign_str);
+	}
+
+	if (valign_str) {
+		if (valign)
+			warn("Only one of valign and align can be defined!");
+
+		if (!strcmp(valign_str, "center"))
+			valign = GP_VCENTER;
+		else if (!strcmp(valign_str, "top"))
+			valign = GP_TOP;
+		else if (!strcmp(valign_str, "bottom"))
+			valign = GP_BOTTOM;
+		else if (!strcmp(valign_str, "fill"))
+			valign = GP_VFILL;
+		else
+			warn("Invalid valign=%s.", valign_str);
+	}
+
+	if (halign && valign) {
+		fprintf(g->body, "\tw[%i]->align = %s | %s;\n",
+		        id, halign_name(halign), valign_name(valign));
+	} else if (halign || valign) {
+		fprintf(g->body, "\tw[%i]->align = %s;\n", id,
+		        halign ? halign_name(halign) : valign_name(valign));
+	}
+}
+
+static void emit_uid(struct gen *g, int id, const gp_bjson *json)
+{
+	const char *uid = gp_bjson_str(json);
+	struct uid *u;
+
+	if (!is_ident(uid)) {
+		error(g, "Widget uid '%s' is not a valid C identifier", uid ? uid : "null");
+		return;
+	}
+
+	for (u = g->uids; u; u = u->next) {
+		if (!strcmp(u->name, uid)) {
+			error(g, "Duplicate widget uid '%s'", uid);
+			return;
+		}
+	}
+
+	u = malloc(sizeof(*u) + strlen(uid) + 1);
+	if (!u) {
+		error(g, "Malloc failed :-(");
+		return;
+	}
+
+	strcpy(u->name, uid);
+	u->next = g->uids;
+	g->uids = u;
+
+	fprintf(g->hdr, "extern gp_widget *%s_%s;\n", g->prefix, uid);
+	fprintf(g->decl, "gp_widget *%s_%s;\n", g->prefix, uid);
+	fprintf(g->body, "\t%s_%s = w[%i];\n", g->prefix, uid, id);
+}
+
+static int emit_widget(struct gen *g, const gp_bjson *json)
+{
+	const gp_bjson *call, *uid, *on_event;
+	const struct emitter *emitter;
+	const char *type = "grid";
+	int id;
+
+	if (gp_bjson_len(json) == 0 || !gp_bjson_is_type(json, GP_BJSON_OBJECT))
+		return -1;
+
+	call = gp_bjson_get(json, "call");
+	if (call) {
+		const char *func = callback(g, call, CALLBACK_CALL);
+
+		if (!strcmp(func, "NULL"))
+			return -1;
+
+		id = new_widget(g);
+		fprintf(g->body, "\tw[%i] = %s();\n", id, func);
+
+		return id;
+	}
+
+	if (gp_bjson_get(json, "type")) {
+		type = gp_bjson_str(gp_bjson_get(json, "type"));
+
+		if (!type) {
+			error(g, "Invalid type");
+			return -1;
+		}
+	}
+
+	emitter = emitter_by_type(type);
+	if (!emitter) {
+		error(g, "Invalid widget type '%s'", type);
+		return -1;
+	}
+
+	id = emitter->emit(g, json);
+	if (id < 0)
+		return id;
+
+	emit_align(g, id, json);
+
+	on_event = gp_bjson_get(json, "on_event");
+	if (on_event) {
+		fprintf(g->body, "\tw[%i]->on_event = %s;\n",
+		        id, callback(g, on_event, CALLBACK_ON_EVENT));
+	}
+
+	if (gp_bjson_bool(gp_bjson_get(json, "retain")))
+		fprintf(g->body, "\tgp_widget_retain(w[%i], 1);\n", id);
+
+	uid = gp_bjson_get(json, "uid");
+	if (uid)
+		emit_uid(g, id, uid);
+
+	fprintf(g->body, "\tgp_widget_send_event(w[%i], GP_WIDGET_EVENT_NEW);\n", id);
+
+	return id;
+}
+
+static FILE *open_out(const char *prefix, const char *ext, const char *layout)
+{
+	char path[1024];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s.%s", prefix, ext);
+
+	f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "Failed to open '%s'\n", path);
+		return NULL;
+	}
+
+	fprintf(f, "/* Generated by layout_to_c from %s, do not edit. */\n\n", layout);
+
+	return f;
+}
+
+static int close_out(FILE *f, const char *prefix, const char *ext)
+{
+	if (fclose(f)) {
+		fprintf(stderr, "Failed to write '%s.%s'\n", prefix, ext);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int write_header(struct gen *g, const char *layout, const char *uids)
+{
+	FILE *f = open_out(g->prefix, "h", layout);
+	char guard[strlen(g->prefix) + 16];
+	unsigned int i;
+
+	if (!f)
+		return 1;
+
+	for (i = 0; g->prefix[i]; i++)
+		guard[i] = toupper(g->prefix[i]);
+
+	strcpy(guard + i, "_LAYOUT_H__");
+
+	fprintf(f, "#ifndef %s\n#define %s\n\n", guard, guard);
+	fprintf(f, "#include <gp_widgets.h>\n\n");
+
+	if (*uids)
+		fprintf(f, "%s\n", uids);
+
+	fprintf(f, "/* Builds the layout, returns NULL on a failure. */\n");
+	fprintf(f, "gp_widget *%s_layout(void);\n\n", g->prefix);
+	fprintf(f, "#endif /* %s */\n", guard);
+
+	return close_out(f, g->prefix, "h");
+}
+
+static int write_source(struct gen *g, const char *layout, int root,
+                        const char *decl, const char *body)
+{
+	FILE *f = open_out(g->prefix, "c", layout);
+	struct uid *u;
+
+	if (!f)
+		return 1;
+
+	fprintf(f, "#include \"%s.h\"\n\n", g->prefix);
+
+	if (*decl)
+		fprintf(f, "%s\n", decl);
+
+	fprintf(f, "gp_widget *%s_layout(void)\n{\n", g->prefix);
+
+	if (root < 0) {
+		fprintf(f, "\treturn NULL;\n}\n");
+		return close_out(f, g->prefix, "c");
+	}
+
+	fprintf(f, "\tgp_widget *w[%u] = {};\n", g->widgets);
+	fprintf(f, "\tunsigned int i;\n\n");
+	fprintf(f, "%s\n", body);
+	fprintf(f, "\treturn w[%i];\nerr:\n", root);
+
+	for (u = g->uids; u; u = u->next)
+		fprintf(f, "\t%s_%s = NULL;\n", g->prefix, u->name);
+
+	fprintf(f, "\tfor (i = 0; i < %u; i++) {\n", g->widgets);
+	fprintf(f, "\t\tif (w[i] && !w[i]->parent)\n");
+	fprintf(f, "\t\t\tgp_widget_free(w[i]);\n");
+	fprintf(f, "\t}\n\n");
+	fprintf(f, "\treturn NULL;\n}\n");
+
+	return close_out(f, g->prefix, "c");
+}
+
+int main(int argc, char *argv[])
+{
+	struct gen g = {};
+	char *decl = NULL, *body = NULL, *uids = NULL;
+	size_t decl_size, body_size, uids_size;
+	gp_bjson_hdr *blob;
+	int root, ret = 1;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s layout.json prefix\n\n", argv[0]);
+		fprintf(stderr, "Writes prefix.c and prefix.h into the current directory\n");
+		return 1;
+	}
+
+	g.prefix = argv[2];
+
+	if (!is_ident(g.prefix)) {
+		fprintf(stderr, "Prefix '%s' is not a valid C identifier\n", g.prefix);
+		return 1;
+	}
+
+	blob = gp_widget_layout_compile(argv[1]);
+	if (!blob)
+		return 1;
+
+	g.decl = open_memstream(&decl, &decl_size);
+	g.body = open_memstream(&body, &body_size);
+	g.hdr = open_memstream(&uids, &uids_size);
+
+	if (!g.decl || !g.body || !g.hdr) {
+		fprintf(stderr, "open_memstream() failed\n");
+		return 1;
+	}
+
+	root = emit_widget(&g, gp_bjson_root(blob));
+
+	fclose(g.decl);
+	fclose(g.body);
+	fclose(g.hdr);
+
+	if (g.err)
+		goto exit;
+
+	if (write_header(&g, argv[1], uids))
+		goto exit;
+
+	if (write_source(&g, argv[1], root, decl, body))
+		goto exit;
+
+	printf("%s.c: %u widgets\n", g.prefix, g.widgets);
+
+	ret = 0;
+exit:
+	free(decl);
+	free(body);
+	free(uids);
+	free(blob);
+	return ret;
+}